@@ -77,44 +77,25 @@ sudo systemctl restart nginx
 # Kill any existing instances cleanly before starting fresh
 # ---------------------------------------------------------------------------
 pkill -x pifridge_api       2>/dev/null || true
-pkill -x pifridge_inventory 2>/dev/null || true
+pkill -x pifridge_inventory 2>/dev/null || true   # before it was merged into pifridge_api
 sleep 0.5
 
 # ---------------------------------------------------------------------------
-# Start FastCGI vitals API in background
+# Start the FastCGI API server (vitals, events and inventory) in background
 # ---------------------------------------------------------------------------
-echo "==> [PiFridge] Starting vitals API..."
+echo "==> [PiFridge] Starting API server..."
 "$REPO_DIR/build/src/web_app/pifridge_api" &
-FCGI_VITALS_PID=$!
+FCGI_API_PID=$!
 
 sleep 1
 
 if [ -S /var/run/pifridge/pifridge.sock ]; then
     sudo chown "$PI_USER":www-data /var/run/pifridge/pifridge.sock
     sudo chmod 660 /var/run/pifridge/pifridge.sock
-    echo "==> [PiFridge] Vitals socket ready."
+    echo "==> [PiFridge] API socket ready."
 else
-    echo "[ERROR] Vitals socket not created. Check pifridge_api output."
-    kill $FCGI_VITALS_PID 2>/dev/null
-    exit 1
-fi
-
-# ---------------------------------------------------------------------------
-# Start FastCGI inventory API in background
-# ---------------------------------------------------------------------------
-echo "==> [PiFridge] Starting inventory API..."
-"$REPO_DIR/build/src/web_app/pifridge_inventory" &
-FCGI_INVENTORY_PID=$!
-
-sleep 1
-
-if [ -S /var/run/pifridge/pifridge_inventory.sock ]; then
-    sudo chown "$PI_USER":www-data /var/run/pifridge/pifridge_inventory.sock
-    sudo chmod 660 /var/run/pifridge/pifridge_inventory.sock
-    echo "==> [PiFridge] Inventory socket ready."
-else
-    echo "[ERROR] Inventory socket not created. Check pifridge_inventory output."
-    kill $FCGI_VITALS_PID $FCGI_INVENTORY_PID 2>/dev/null
+    echo "[ERROR] API socket not created. Check pifridge_api output."
+    kill $FCGI_API_PID 2>/dev/null
     exit 1
 fi
 
@@ -124,8 +105,7 @@ fi
 cleanup() {
     echo ""
     echo "==> [PiFridge] Shutting down..."
-    kill $FCGI_VITALS_PID    2>/dev/null
-    kill $FCGI_INVENTORY_PID 2>/dev/null
+    kill $FCGI_API_PID 2>/dev/null
     echo "==> [PiFridge] Stopped."
     exit 0
 }
@@ -149,4 +129,5 @@ echo ""
 # Start main pifridge process in foreground (needs sudo for I2C/GPIO)
 # ---------------------------------------------------------------------------
 echo "==> [PiFridge] Starting main sensor process..."
-sudo "$REPO_DIR/build/src/pifridge"
+# --http-port serves /api/fridge/history, which nginx proxies to
+sudo "$REPO_DIR/build/src/pifridge" --http-port 8080
@@ -1,6 +1,8 @@
 // BarcodeScanner.cpp
 
 #include "BarcodeScanner.hpp"
+#include "InventoryStore.hpp"
+#include "JsonView.hpp"
 #include <iostream>
 #include <fcntl.h>
 #include <unistd.h>
@@ -10,8 +12,6 @@
 #include <sys/select.h>
 #include <curl/curl.h>
 #include <cstdint>
-#include <ctime>
-#include <sqlite3.h>
 
 static const char* DB_PATH = "/var/lib/pifridge/inventory.db";
 
@@ -23,112 +23,35 @@ static size_t write_cb(void* contents, size_t size, size_t nmemb, void* userp) {
     return total;
 }
 
-// ================== Simple JSON string extractor ==================
-// Pulls the value of "key": "value" from a JSON string
-static std::string extractJsonString(const std::string& json, const std::string& key) {
-    std::string search = "\"" + key + "\"";
-    size_t pos = json.find(search);
-    if (pos == std::string::npos) return "";
-
-    pos = json.find(':', pos);
-    if (pos == std::string::npos) return "";
-    pos++;
-
-    while (pos < json.size() && (json[pos] == ' ' || json[pos] == '\t')) pos++;
-
-    if (pos >= json.size() || json[pos] != '"') return "";
-    pos++;
-
-    size_t end = json.find('"', pos);
-    if (end == std::string::npos) return "";
-
-    return json.substr(pos, end - pos);
-}
-
-// ================== SQLite helpers ==================
-
-// Opens the inventory database — same schema as pifridge_inventory.cpp
-static sqlite3* openDb() {
-    sqlite3* db = nullptr;
-    if (sqlite3_open(DB_PATH, &db) != SQLITE_OK) {
-        std::cerr << "[BarcodeScanner] Failed to open DB: " << sqlite3_errmsg(db) << "\n";
-        return nullptr;
-    }
-
-    const char* createTable =
-        "CREATE TABLE IF NOT EXISTS inventory ("
-        "  id         INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "  name       TEXT    NOT NULL,"
-        "  barcode    TEXT,"
-        "  quantity   INTEGER NOT NULL DEFAULT 1,"
-        "  date_added TEXT    NOT NULL"
-        ");";
-
-    char* errMsg = nullptr;
-    if (sqlite3_exec(db, createTable, nullptr, nullptr, &errMsg) != SQLITE_OK) {
-        std::cerr << "[BarcodeScanner] Failed to create table: " << errMsg << "\n";
-        sqlite3_free(errMsg);
-        sqlite3_close(db);
-        return nullptr;
+// Same store and schema as pifridge_api. The upsert is a single
+// statement, so a scan racing a click in the UI can't lose an update.
+static void add_to_inventory(InventoryStore& store, const std::string& productName,
+                             const std::string& barcode) {
+    int quantity = store.upsertItem(productName, barcode, 1, "");
+    if (quantity == 1) {
+        std::cout << "[BarcodeScanner] Added to inventory: " << productName << " (" << barcode << ")\n";
+    } else if (quantity > 1) {
+        std::cout << "[BarcodeScanner] Incremented quantity for: " << productName
+                  << " (now " << quantity << ")\n";
     }
-
-    return db;
 }
 
-// If the barcode already exists, increment its quantity.
-// Otherwise insert a new row.
-static void upsertItem(sqlite3* db, const std::string& name, const std::string& barcode) {
-    // Check if barcode already exists
-    const char* selectQuery = "SELECT id, quantity FROM inventory WHERE barcode = ?;";
-    sqlite3_stmt* stmt = nullptr;
-
-    if (sqlite3_prepare_v2(db, selectQuery, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "[BarcodeScanner] Failed to prepare select\n";
+void fetch_product(InventoryStore& store, const std::string& barcode) {
+    // A no-op once open; retries if the DB was unavailable at start()
+    if (!store.open()) {
+        std::cerr << "[BarcodeScanner] Failed to open inventory DB\n";
         return;
     }
 
-    sqlite3_bind_text(stmt, 1, barcode.c_str(), -1, SQLITE_STATIC);
-
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        // Row exists — increment quantity
-        int id  = sqlite3_column_int(stmt, 0);
-        int qty = sqlite3_column_int(stmt, 1);
-        sqlite3_finalize(stmt);
-
-        const char* updateQuery = "UPDATE inventory SET quantity = ? WHERE id = ?;";
-        sqlite3_stmt* upStmt = nullptr;
-        if (sqlite3_prepare_v2(db, updateQuery, -1, &upStmt, nullptr) == SQLITE_OK) {
-            sqlite3_bind_int(upStmt, 1, qty + 1);
-            sqlite3_bind_int(upStmt, 2, id);
-            sqlite3_step(upStmt);
-            sqlite3_finalize(upStmt);
-            std::cout << "[BarcodeScanner] Incremented quantity for: " << name << " (id=" << id << ")\n";
-        }
-
-    } else {
-        // No existing row — insert new item
-        sqlite3_finalize(stmt);
-
-        time_t now = time(nullptr);
-        char dateBuf[11];
-        strftime(dateBuf, sizeof(dateBuf), "%Y-%m-%d", localtime(&now));
-
-        const char* insertQuery =
-            "INSERT INTO inventory (name, barcode, quantity, date_added) VALUES (?, ?, 1, ?);";
-        sqlite3_stmt* insStmt = nullptr;
-
-        if (sqlite3_prepare_v2(db, insertQuery, -1, &insStmt, nullptr) == SQLITE_OK) {
-            sqlite3_bind_text(insStmt, 1, name.c_str(),    -1, SQLITE_STATIC);
-            sqlite3_bind_text(insStmt, 2, barcode.c_str(), -1, SQLITE_STATIC);
-            sqlite3_bind_text(insStmt, 3, dateBuf,         -1, SQLITE_STATIC);
-            sqlite3_step(insStmt);
-            sqlite3_finalize(insStmt);
-            std::cout << "[BarcodeScanner] Added to inventory: " << name << " (" << barcode << ")\n";
-        }
+    // A product already in the fridge keeps the name it was stocked under;
+    // no need to ask OpenFoodFacts again
+    std::string knownName = store.nameForBarcode(barcode);
+    if (!knownName.empty()) {
+        std::cout << "[BarcodeScanner] Known product: " << knownName << "\n";
+        add_to_inventory(store, knownName, barcode);
+        return;
     }
-}
 
-void fetch_product(const std::string& barcode) {
     const std::string baseUrl =
         "https://world.openfoodfacts.org/api/v2/product/";
     const std::string fallbackBaseUrl =
@@ -181,22 +104,17 @@ void fetch_product(const std::string& barcode) {
         return;
     }
 
-    std::string statusStr = extractJsonString(response, "status");
-
-    if (statusStr == "0" || statusStr.empty()) {
-        size_t statusPos = response.find("\"status\":");
-        if (statusPos != std::string::npos) {
-            size_t valPos = response.find(':', statusPos) + 1;
-            while (valPos < response.size() && response[valPos] == ' ') valPos++;
-            if (response[valPos] == '0') {
-                std::cout << "[BarcodeScanner] Product not found for barcode: "
-                          << barcode << " — skipping.\n";
-                return;
-            }
-        }
+    // {"code": "...", "product": {"product_name": "..."}, "status": 1, ...}
+    JsonView doc = JsonView::parse(response);
+
+    JsonView status = doc["status"];
+    if (status.valid() && status.asInt(-1) == 0) {
+        std::cout << "[BarcodeScanner] Product not found for barcode: "
+                  << barcode << " — skipping.\n";
+        return;
     }
 
-    std::string productName = extractJsonString(response, "product_name");
+    std::string productName = doc["product"]["product_name"].asString();
 
     if (productName.empty()) {
         std::cout << "[BarcodeScanner] No product name returned for: "
@@ -205,17 +123,12 @@ void fetch_product(const std::string& barcode) {
     }
 
     std::cout << "[BarcodeScanner] Product found: " << productName << "\n";
-
-    sqlite3* db = openDb();
-    if (!db) return;
-
-    upsertItem(db, productName, barcode);
-    sqlite3_close(db);
+    add_to_inventory(store, productName, barcode);
 }
 
 // ================== SerialReader Implementation ==================
 BarcodeScanner::BarcodeScanner(const std::string& portName)
-    : port(portName), fd(-1) {}
+    : port(portName), fd(-1), store_(DB_PATH, "barcode") {}
 
 BarcodeScanner::~BarcodeScanner() {
     stop();
@@ -236,6 +149,10 @@ void BarcodeScanner::registerCallback(Callback cb) {
 }
 
 void BarcodeScanner::start() {
+    // One connection for the scanner's lifetime: statements are prepared once
+    if (!store_.open()) {
+        std::cerr << "[BarcodeScanner] Failed to open inventory DB\n";
+    }
     if (!openPort()) return;
     running_ = true;
     thread_ = std::thread(&BarcodeScanner::run, this);
@@ -1,13 +1,16 @@
 #ifndef BARCODE_SCANNER_HPP
 #define BARCODE_SCANNER_HPP
 
+#include "InventoryStore.hpp"
+
 #include <string>
 #include <functional>
 #include <thread>
 #include <atomic>
 
-// Function to fetch product info from OpenFoodFacts API
-void fetch_product(const std::string& number);
+// Look up a scanned barcode (in @p store, then on OpenFoodFacts) and add
+// the product to @p store
+void fetch_product(InventoryStore& store, const std::string& number);
 
 // Class to read data from a barcode scanner connected via a serial port
 class BarcodeScanner {
@@ -24,6 +27,10 @@ public:
     void triggerScan();
     void stopScan();
 
+    // The scanner's inventory connection, opened by start(), for
+    // fetch_product from the callback
+    InventoryStore& inventory() { return store_; }
+
 private:
     bool openPort();
     void run(); 
@@ -34,6 +41,7 @@ private:
     int               wake_pipe_[2] = {-1, -1};
     std::thread       thread_;
     std::atomic<bool> running_{false};
+    InventoryStore    store_;
 };
 
 #endif
\ No newline at end of file
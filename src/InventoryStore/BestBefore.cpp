@@ -0,0 +1,131 @@
+#include "BestBefore.hpp"
+
+#include <cctype>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+namespace {
+
+const char* const MONTHS[] = {
+    "jan", "feb", "mar", "apr", "may", "jun", "jul", "aug", "sep", "oct", "nov", "dec"
+};
+
+bool isLeapYear(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+int daysInMonth(int year, int month) {
+    static const int DAYS[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    return month == 2 && isLeapYear(year) ? 29 : DAYS[month - 1];
+}
+
+// A run of digits, and how many there were ("05" is 5 with two digits)
+struct Number {
+    int value;
+    size_t digits;
+};
+
+// Two-digit years are this century
+int fullYear(const Number& year) {
+    return year.digits <= 2 ? 2000 + year.value : year.value;
+}
+
+} // namespace
+
+bool BestBefore::parse(const std::string& text, BestBefore& out) {
+    // Split into numbers and month names; other words ("BB", "best",
+    // "before", "end", "use by") and separators are ignored
+    std::vector<Number> numbers;
+    int month = 0;
+    for (size_t i = 0; i < text.size();) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        size_t start = i;
+        if (std::isdigit(c)) {
+            int value = 0;
+            while (i < text.size() && std::isdigit(static_cast<unsigned char>(text[i]))) {
+                if (i - start < 8) value = value * 10 + (text[i] - '0');
+                ++i;
+            }
+            if (i - start > 8) return false;
+            numbers.push_back({ value, i - start });
+        } else if (std::isalpha(c)) {
+            std::string word;
+            while (i < text.size() && std::isalpha(static_cast<unsigned char>(text[i]))) {
+                word += static_cast<char>(std::tolower(static_cast<unsigned char>(text[i])));
+                ++i;
+            }
+            for (int m = 0; m < 12 && word.size() >= 3; ++m) {
+                if (word.compare(0, 3, MONTHS[m]) == 0) month = m + 1;
+            }
+        } else {
+            ++i;
+        }
+    }
+
+    int year = 0;
+    int day = 0;
+    if (month > 0) {
+        // "12 OCT 2026", "OCT 12 2026", "2026 OCT 12", "12 OCT 26", "OCT 2026"
+        if (numbers.size() == 2) {
+            bool yearFirst = numbers[0].digits == 4;
+            day  = numbers[yearFirst ? 1 : 0].value;
+            year = fullYear(numbers[yearFirst ? 0 : 1]);
+        } else if (numbers.size() == 1) {
+            year = fullYear(numbers[0]);
+        } else {
+            return false;
+        }
+    } else if (numbers.size() == 3) {
+        // "2026-10-12", "12/10/2026", "12.10.26"
+        if (numbers[0].digits == 4) {
+            year  = numbers[0].value;
+            month = numbers[1].value;
+            day   = numbers[2].value;
+        } else {
+            day   = numbers[0].value;
+            month = numbers[1].value;
+            year  = fullYear(numbers[2]);
+        }
+    } else if (numbers.size() == 2) {
+        // "10/2026", "10/26", "2026-10"
+        bool yearFirst = numbers[0].digits == 4;
+        month = numbers[yearFirst ? 1 : 0].value;
+        year  = fullYear(numbers[yearFirst ? 0 : 1]);
+    } else if (numbers.size() == 1 && numbers[0].digits == 8) {
+        // "20261012"
+        year  = numbers[0].value / 10000;
+        month = numbers[0].value / 100 % 100;
+        day   = numbers[0].value % 100;
+    } else {
+        return false;
+    }
+
+    if (year < 1970 || year > 9999 || month < 1 || month > 12) return false;
+    if (day == 0) day = daysInMonth(year, month);
+    if (day < 1 || day > daysInMonth(year, month)) return false;
+
+    char buf[20];   // 11 is enough, but -Wformat-truncation only sees day as an int
+    std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d", year, month, day);
+    out.date = buf;
+    out.days = epochDays(year, month, day);
+    return true;
+}
+
+// Days-from-civil: shifts the year to start in March so the leap day falls
+// at the end, then counts whole 400-year eras
+long long BestBefore::epochDays(int year, int month, int day) {
+    long long y = month <= 2 ? year - 1 : year;
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    long long yearOfEra = y - era * 400;
+    long long dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    long long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+long long BestBefore::today() {
+    time_t now = time(nullptr);
+    struct tm local;
+    localtime_r(&now, &local);
+    return epochDays(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+}
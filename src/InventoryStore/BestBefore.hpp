@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+
+/**
+ * @brief A best-before date read from whatever the UI or OCR produced.
+ *
+ * best_before is stored as typed: the UI's date input gives YYYY-MM-DD, but
+ * labels read by the camera come out as "12/10/26", "BB 12 OCT 2026" or
+ * "END OCT 2026". parse() recognises those and gives the date both as
+ * YYYY-MM-DD and as a day number, which InventoryStore keeps in the
+ * indexed best_before_days column.
+ *
+ * Numeric dates are read day first (DD/MM/YYYY), as on European labels,
+ * unless they start with a four-digit year. A month without a day means
+ * the end of that month.
+ *
+ * Usage:
+ * @code
+ *   BestBefore date;
+ *   if (BestBefore::parse("BB 12.10.26", date)) {
+ *       // date.date == "2026-10-12", date.days == 20738
+ *   }
+ * @endcode
+ */
+struct BestBefore {
+    std::string date;     ///< YYYY-MM-DD
+    long long   days = 0; ///< Days since 1970-01-01
+
+    /** @return false if @p text holds no recognisable date. */
+    static bool parse(const std::string& text, BestBefore& out);
+
+    /** Day number of a calendar date (proleptic Gregorian). */
+    static long long epochDays(int year, int month, int day);
+
+    /** Today's day number in local time, as date_added is written. */
+    static long long today();
+};
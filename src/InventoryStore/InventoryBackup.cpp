@@ -0,0 +1,235 @@
+#include "InventoryBackup.hpp"
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <dirent.h>
+#include <iostream>
+#include <sys/stat.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+const char BACKUP_PREFIX[] = "inventory-";
+const char BACKUP_SUFFIX[] = ".db";
+
+// Closes the connection when it goes out of scope; a transaction still
+// open on it is rolled back
+class Connection {
+public:
+    Connection(const std::string& path, int flags) {
+        if (sqlite3_open_v2(path.c_str(), &db_, flags, nullptr) != SQLITE_OK) {
+            sqlite3_close(db_);
+            db_ = nullptr;
+        }
+    }
+    ~Connection() { sqlite3_close(db_); }
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    sqlite3* get() const { return db_; }
+
+private:
+    sqlite3* db_ = nullptr;
+};
+
+std::string localTime(time_t at, const char* format) {
+    struct tm local;
+    localtime_r(&at, &local);
+    char buf[32];
+    strftime(buf, sizeof(buf), format, &local);
+    return buf;
+}
+
+bool isBackupName(const std::string& name) {
+    size_t prefix = sizeof(BACKUP_PREFIX) - 1;
+    size_t suffix = sizeof(BACKUP_SUFFIX) - 1;
+    return name.size() > prefix + suffix && name.compare(0, prefix, BACKUP_PREFIX) == 0 &&
+           name.compare(name.size() - suffix, suffix, BACKUP_SUFFIX) == 0;
+}
+
+} // namespace
+
+InventoryBackup::InventoryBackup(std::string dbPath, std::string backupDir, size_t keep)
+    : dbPath_(std::move(dbPath)), backupDir_(std::move(backupDir)), keep_(std::max<size_t>(keep, 1)) {}
+
+InventoryBackup::~InventoryBackup() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void InventoryBackup::start(std::chrono::minutes interval) {
+    if (thread_.joinable()) return;
+
+    thread_ = std::thread([this, interval] {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            wake_.wait_for(lock, interval, [this] { return requested_ || stopping_; });
+            if (stopping_) break;
+            requested_ = false;
+
+            lock.unlock();
+            backupNow();
+            lock.lock();
+        }
+    });
+}
+
+bool InventoryBackup::request() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_ || requested_ || !thread_.joinable()) return false;
+        requested_ = true;
+    }
+    wake_.notify_all();
+    return true;
+}
+
+bool InventoryBackup::backupNow(const Progress& progress) {
+    if (running_.exchange(true)) return false;
+    pagesDone_ = 0;
+    pagesTotal_ = 0;
+
+    auto started = std::chrono::steady_clock::now();
+    mkdir(backupDir_.c_str(), 0755);   // fails harmlessly if it exists
+
+    // A second backup within the same second replaces the first
+    std::string file = backupDir_ + "/" + BACKUP_PREFIX + localTime(time(nullptr), "%Y%m%d-%H%M%S") + BACKUP_SUFFIX;
+    std::string part = file + ".part";
+    std::remove(part.c_str());
+
+    std::string error;
+    bool ok = copyTo(part, progress, error);
+    if (ok && std::rename(part.c_str(), file.c_str()) != 0) {
+        ok = false;
+        error = "could not rename " + part;
+    }
+
+    if (ok) {
+        rotate();
+    } else {
+        std::remove(part.c_str());
+        std::remove((part + "-journal").c_str());
+    }
+
+    auto durationMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    finish(ok, file, error, static_cast<long long>(durationMs));
+    running_ = false;
+    return ok;
+}
+
+void InventoryBackup::writeStatus(JsonWriter& json) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    json.beginObject();
+    json.key("running");          json.value(running_.load());
+    json.key("pages_done");       json.value(pagesDone_.load());
+    json.key("pages_total");      json.value(pagesTotal_.load());
+    json.key("completed");        json.value(completed_);
+    json.key("failed");           json.value(failed_);
+    json.key("last_file");        json.value(lastFile_);
+    json.key("last_finished");    json.value(lastFinished_);
+    json.key("last_duration_ms"); json.value(lastDurationMs_);
+    json.key("last_error");
+    if (lastError_.empty()) json.null();
+    else json.value(lastError_);
+    json.endObject();
+}
+
+bool InventoryBackup::copyTo(const std::string& path, const Progress& progress, std::string& error) {
+    Connection source(dbPath_, SQLITE_OPEN_READWRITE);
+    if (!source.get()) {
+        error = "could not open " + dbPath_;
+        return false;
+    }
+    sqlite3_busy_timeout(source.get(), 2000);
+
+    // Hold one read transaction for the whole copy. Every step then reads
+    // the same snapshot, so other connections' commits neither tear the
+    // copy nor make sqlite3_backup_step start over.
+    if (sqlite3_exec(source.get(), "BEGIN; SELECT COUNT(*) FROM sqlite_master;",
+                     nullptr, nullptr, nullptr) != SQLITE_OK) {
+        error = sqlite3_errmsg(source.get());
+        return false;
+    }
+
+    Connection destination(path, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+    if (!destination.get()) {
+        error = "could not create " + path;
+        return false;
+    }
+
+    sqlite3_backup* backup = sqlite3_backup_init(destination.get(), "main", source.get(), "main");
+    if (!backup) {
+        error = sqlite3_errmsg(destination.get());
+        return false;
+    }
+
+    int rc;
+    do {
+        rc = sqlite3_backup_step(backup, PAGES_PER_STEP);
+
+        long long total = sqlite3_backup_pagecount(backup);
+        pagesTotal_ = total;
+        pagesDone_  = total - sqlite3_backup_remaining(backup);
+        if (progress) progress(pagesDone_, pagesTotal_);
+
+        if (rc != SQLITE_DONE) sqlite3_sleep(STEP_PAUSE_MS);
+    } while ((rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED) && !stopping_);
+
+    sqlite3_backup_finish(backup);
+    if (rc != SQLITE_DONE) {
+        error = stopping_ ? "stopped" : sqlite3_errstr(rc);
+        return false;
+    }
+
+    // The copy keeps the source's WAL flag; a rollback journal instead
+    // makes the backup one self-contained file that opening won't add to
+    if (sqlite3_exec(destination.get(), "PRAGMA journal_mode=DELETE;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        error = sqlite3_errmsg(destination.get());
+        return false;
+    }
+    return true;
+}
+
+// Names sort by their timestamp, so the oldest come first
+void InventoryBackup::rotate() {
+    DIR* dir = opendir(backupDir_.c_str());
+    if (!dir) return;
+
+    std::vector<std::string> backups;
+    while (dirent* entry = readdir(dir)) {
+        if (isBackupName(entry->d_name)) backups.emplace_back(entry->d_name);
+    }
+    closedir(dir);
+
+    std::sort(backups.begin(), backups.end());
+    for (size_t i = 0; i + keep_ < backups.size(); ++i) {
+        std::remove((backupDir_ + "/" + backups[i]).c_str());
+    }
+}
+
+void InventoryBackup::finish(bool ok, const std::string& file, const std::string& error, long long durationMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lastDurationMs_ = durationMs;
+    if (ok) {
+        ++completed_;
+        lastFile_ = file;
+        lastFinished_ = localTime(time(nullptr), "%Y-%m-%dT%H:%M:%S");
+        lastError_.clear();
+        std::cout << "[inventory] Backup written to " << file << " in " << durationMs << " ms\n";
+    } else {
+        ++failed_;
+        lastError_ = error;
+        std::cerr << "[inventory] Backup failed: " << error << "\n";
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "JsonWriter.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Online backups of the inventory database, with rotation.
+ *
+ * Copies the live database with the sqlite3_backup API while the scanner,
+ * camera and web workers keep writing. The copy reads from one WAL
+ * snapshot taken when it starts, so it is consistent and never restarts
+ * because of their writes. Readers don't block writers in WAL mode, and
+ * the copy goes PAGES_PER_STEP pages at a time with a pause between steps
+ * so it doesn't hog the SD card either.
+ *
+ * Each backup is written to "<dir>/inventory-YYYYMMDD-HHMMSS.db.part" and
+ * renamed into place once complete, so a file without ".part" is always a
+ * whole database. Only the newest @p keep are kept.
+ *
+ * start() runs backups on a thread of their own: one every interval, and
+ * one whenever request() asks. backupNow() runs one on the calling thread.
+ *
+ * Thread-safe.
+ *
+ * Usage:
+ * @code
+ *   InventoryBackup backup("/var/lib/pifridge/inventory.db", "/var/lib/pifridge/backups");
+ *   backup.start(std::chrono::hours(24));
+ *   backup.request();   // e.g. from POST /api/admin/backup
+ * @endcode
+ */
+class InventoryBackup {
+public:
+    /** Called after each step with the pages copied so far and the total. */
+    using Progress = std::function<void(long long done, long long total)>;
+
+    /**
+     * @param dbPath    Database to back up.
+     * @param backupDir Directory for the copies; created if missing.
+     * @param keep      Newest backups kept after each one completes.
+     */
+    InventoryBackup(std::string dbPath, std::string backupDir, size_t keep = DEFAULT_KEEP);
+
+    /** Stops the thread; a backup in progress is abandoned and its part file removed. */
+    ~InventoryBackup();
+
+    InventoryBackup(const InventoryBackup&) = delete;
+    InventoryBackup& operator=(const InventoryBackup&) = delete;
+
+    /** Start the backup thread. It backs up every @p interval, and on request(). */
+    void start(std::chrono::minutes interval);
+
+    /**
+     * @brief Ask the backup thread for a backup now.
+     * @return false if one is already running or waiting to.
+     */
+    bool request();
+
+    /**
+     * @brief Take one backup on the calling thread.
+     * @return false if it failed or another backup is running; see writeStatus().
+     */
+    bool backupNow(const Progress& progress = nullptr);
+
+    /**
+     * @brief Write the current state:
+     * @code
+     *   {"running":true,"pages_done":1408,"pages_total":5120,"completed":12,"failed":0,
+     *    "last_file":"/var/lib/pifridge/backups/inventory-20261017-030000.db",
+     *    "last_finished":"2026-10-17T03:00:02","last_duration_ms":1840,"last_error":null}
+     * @endcode
+     * pages_done/pages_total is the progress of the running backup, or of
+     * the last one if none is running.
+     */
+    void writeStatus(JsonWriter& json) const;
+
+    /** Backups kept unless the constructor is told otherwise. */
+    static constexpr size_t DEFAULT_KEEP = 7;
+
+    /** Pages (4 KB each) copied per sqlite3_backup_step. */
+    static constexpr int PAGES_PER_STEP = 64;
+
+    /** Pause between steps, leaving the SD card to the other writers. */
+    static constexpr int STEP_PAUSE_MS = 10;
+
+private:
+    /** Copy the database to @p path; sets @p error on failure. */
+    bool copyTo(const std::string& path, const Progress& progress, std::string& error);
+
+    /** Delete all but the newest keep_ backups. */
+    void rotate();
+
+    void finish(bool ok, const std::string& file, const std::string& error, long long durationMs);
+
+    std::string dbPath_;
+    std::string backupDir_;
+    size_t keep_;
+
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stopping_{false};
+    std::atomic<long long> pagesDone_{0};
+    std::atomic<long long> pagesTotal_{0};
+
+    mutable std::mutex mutex_;   // guards everything below
+    std::condition_variable wake_;
+    bool requested_ = false;
+    long long completed_ = 0;
+    long long failed_ = 0;
+    std::string lastFile_;
+    std::string lastFinished_;
+    long long lastDurationMs_ = 0;
+    std::string lastError_;
+    std::thread thread_;
+};
@@ -0,0 +1,412 @@
+#include "InventoryCache.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+namespace {
+
+// ASCII-only, matching SQLite's NOCASE collation used by inventory_identity
+std::string lowercase(const std::string& text) {
+    std::string out = text;
+    for (char& c : out) {
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    }
+    return out;
+}
+
+// Newest first, as ORDER BY date_added DESC, id DESC
+bool listingOrder(const InventoryItem& a, const InventoryItem& b) {
+    if (a.dateAdded != b.dateAdded) return a.dateAdded > b.dateAdded;
+    return a.id > b.id;
+}
+
+// Names accepted by ?fields=, in output order
+const std::pair<const char*, unsigned> FIELD_NAMES[] = {
+    { "id",          InventoryCache::FIELD_ID },
+    { "name",        InventoryCache::FIELD_NAME },
+    { "barcode",     InventoryCache::FIELD_BARCODE },
+    { "quantity",    InventoryCache::FIELD_QUANTITY },
+    { "date_added",  InventoryCache::FIELD_DATE_ADDED },
+    { "best_before", InventoryCache::FIELD_BEST_BEFORE },
+};
+
+// Whether @p item passes the page's filters; @p prefix is the lowercased name prefix
+bool matches(const InventoryItem& item, const InventoryCache::PageQuery& query, const std::string& prefix) {
+    if (!query.barcode.empty() && item.barcode != query.barcode) return false;
+    if (!prefix.empty() && lowercase(item.name).compare(0, prefix.size(), prefix) != 0) return false;
+    if (query.bestBeforeFromDays >= 0 || query.bestBeforeToDays >= 0) {
+        // By day number: best_before is stored as typed, so its text is
+        // "BB 12.10.26" as often as a date, or no date at all
+        if (item.bestBeforeDays < 0) return false;
+        if (query.bestBeforeFromDays >= 0 && item.bestBeforeDays < query.bestBeforeFromDays) return false;
+        if (query.bestBeforeToDays >= 0 && item.bestBeforeDays > query.bestBeforeToDays) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Snapshot
+// ---------------------------------------------------------------------------
+const InventoryItem* InventoryCache::Snapshot::findById(long long id) const {
+    auto it = byId_.find(id);
+    return it == byId_.end() ? nullptr : &items[it->second];
+}
+
+std::vector<const InventoryItem*> InventoryCache::Snapshot::findByBarcode(const std::string& barcode) const {
+    std::vector<const InventoryItem*> found;
+    auto range = byBarcode_.equal_range(barcode);
+    for (auto it = range.first; it != range.second; ++it) found.push_back(&items[it->second]);
+    return found;
+}
+
+std::vector<const InventoryItem*> InventoryCache::Snapshot::findByName(const std::string& name) const {
+    std::vector<const InventoryItem*> found;
+    std::string key = lowercase(name);
+    auto it = std::lower_bound(byName_.begin(), byName_.end(), std::make_pair(key, size_t(0)));
+    for (; it != byName_.end() && it->first == key; ++it) found.push_back(&items[it->second]);
+    return found;
+}
+
+void InventoryCache::Snapshot::writeChangesSince(long long since, JsonWriter& json) const {
+    json.beginObject();
+    json.key("version"); json.value(version);
+
+    if (since < 0 || since < horizon || since > version) {
+        json.key("full");  json.value(true);
+        json.key("items"); json.rawValue(listing());
+        json.endObject();
+        return;
+    }
+
+    // Changed items and tombstones, in the order they happened. A null
+    // item is a tombstone for deletedId.
+    struct Change {
+        long long version;
+        const InventoryItem* item;
+        long long deletedId;
+    };
+    std::vector<Change> changes;
+    for (const InventoryItem& item : items) {
+        if (item.changed > since) changes.push_back({ item.changed, &item, 0 });
+    }
+    for (const auto& d : deleted) {
+        if (d.second > since) changes.push_back({ d.second, nullptr, d.first });
+    }
+    std::sort(changes.begin(), changes.end(),
+              [](const Change& a, const Change& b) { return a.version < b.version; });
+
+    json.key("full");    json.value(false);
+    json.key("changes");
+    json.beginArray();
+
+    for (const Change& change : changes) {
+        if (change.item) {
+            writeItem(json, *change.item);
+        } else {
+            json.beginObject();
+            json.key("id");      json.value(change.deletedId);
+            json.key("deleted"); json.value(true);
+            json.endObject();
+        }
+    }
+
+    json.endArray();
+    json.endObject();
+}
+
+void InventoryCache::Snapshot::writePage(const PageQuery& query, JsonWriter& json) const {
+    // First position after the cursor in listing order
+    size_t start = 0;
+    if (query.after) {
+        InventoryItem key;
+        key.dateAdded = query.afterDate;
+        key.id        = query.afterId;
+        start = static_cast<size_t>(std::upper_bound(items.begin(), items.end(), key, listingOrder) -
+                                    items.begin());
+    }
+
+    // Positions to consider, in listing order. An indexed filter narrows
+    // them to its matches; otherwise the page reads on from the cursor.
+    std::string prefix = lowercase(query.namePrefix);
+    std::vector<size_t> candidates;
+    bool indexed = false;
+    if (!query.barcode.empty()) {
+        auto range = byBarcode_.equal_range(query.barcode);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second >= start) candidates.push_back(it->second);
+        }
+        indexed = true;
+    } else if (!prefix.empty()) {
+        auto it = std::lower_bound(byName_.begin(), byName_.end(), std::make_pair(prefix, size_t(0)));
+        for (; it != byName_.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            if (it->second >= start) candidates.push_back(it->second);
+        }
+        indexed = true;
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    json.beginObject();
+    json.key("version"); json.value(version);
+    json.key("items");
+    json.beginArray();
+
+    // Read one past the page to know whether there is a next one
+    const InventoryItem* last = nullptr;
+    bool more = false;
+    size_t written = 0;
+    size_t end = indexed ? candidates.size() : items.size();
+    for (size_t i = indexed ? 0 : start; i < end; ++i) {
+        const InventoryItem& item = items[indexed ? candidates[i] : i];
+        if (!matches(item, query, prefix)) continue;
+        if (written == query.limit) {
+            more = true;
+            break;
+        }
+        writeItem(json, item, query.fields);
+        last = &item;
+        ++written;
+    }
+
+    json.endArray();
+    json.key("next");
+    if (more && last) {
+        json.value(cursorAfter(*last));
+    } else {
+        json.null();
+    }
+    json.endObject();
+}
+
+void InventoryCache::Snapshot::writeExpiring(long long today, int withinDays, JsonWriter& json) const {
+    json.beginArray();
+    for (size_t position : byExpiry_) {
+        const InventoryItem& item = items[position];
+        if (item.bestBeforeDays > today + withinDays) break;
+
+        long long daysLeft = item.bestBeforeDays - today;
+        writeItem(json, item, ALL_FIELDS, &daysLeft);
+    }
+    json.endArray();
+}
+
+const std::string& InventoryCache::Snapshot::listing() const {
+    // Only full loads and the unpaged GET read it, so a write doesn't pay for it
+    std::call_once(rendered_, [this] {
+        JsonWriter json = JsonWriter::toString(listing_);
+        json.beginArray();
+        for (const InventoryItem& item : items) writeItem(json, item);
+        json.endArray();
+        json.flush();
+    });
+    return listing_;
+}
+
+void InventoryCache::Snapshot::index() {
+    std::sort(items.begin(), items.end(), listingOrder);
+
+    byId_.clear();
+    byBarcode_.clear();
+    byName_.clear();
+    for (size_t i = 0; i < items.size(); ++i) {
+        byId_.emplace(items[i].id, i);
+        if (!items[i].barcode.empty()) byBarcode_.emplace(items[i].barcode, i);
+        byName_.emplace_back(lowercase(items[i].name), i);
+    }
+    std::sort(byName_.begin(), byName_.end());
+
+    sortExpiry();
+}
+
+void InventoryCache::Snapshot::patch(const Snapshot& previous, std::vector<InventoryItem>&& changed,
+                                     const std::vector<std::pair<long long, long long>>& removed) {
+    // Where each previous row ends up; GONE for those replaced or deleted
+    const size_t GONE = SIZE_MAX;
+    std::vector<size_t> moved(previous.items.size(), 0);
+    auto drop = [&](long long id) {
+        auto it = previous.byId_.find(id);
+        if (it != previous.byId_.end()) moved[it->second] = GONE;
+    };
+    for (const InventoryItem& item : changed) drop(item.id);
+    for (const auto& d : removed) drop(d.first);
+
+    // Merge the changed rows into the rest, both in listing order
+    std::sort(changed.begin(), changed.end(), listingOrder);
+    std::vector<size_t> added;
+    items.reserve(previous.items.size() + changed.size());
+    size_t next = 0;
+    for (size_t i = 0; i < previous.items.size(); ++i) {
+        if (moved[i] == GONE) continue;
+        for (; next < changed.size() && listingOrder(changed[next], previous.items[i]); ++next) {
+            added.push_back(items.size());
+            items.push_back(std::move(changed[next]));
+        }
+        moved[i] = items.size();
+        items.push_back(previous.items[i]);
+    }
+    for (; next < changed.size(); ++next) {
+        added.push_back(items.size());
+        items.push_back(std::move(changed[next]));
+    }
+
+    // The rows carried over keep their order, so their entries only move
+    byId_ = previous.byId_;
+    for (auto it = byId_.begin(); it != byId_.end();) {
+        if (moved[it->second] == GONE) {
+            it = byId_.erase(it);
+        } else {
+            it->second = moved[it->second];
+            ++it;
+        }
+    }
+    byBarcode_ = previous.byBarcode_;
+    for (auto it = byBarcode_.begin(); it != byBarcode_.end();) {
+        if (moved[it->second] == GONE) {
+            it = byBarcode_.erase(it);
+        } else {
+            it->second = moved[it->second];
+            ++it;
+        }
+    }
+    byName_.reserve(previous.byName_.size() + added.size());
+    for (const auto& entry : previous.byName_) {
+        if (moved[entry.second] != GONE) byName_.emplace_back(entry.first, moved[entry.second]);
+    }
+
+    byExpiry_.reserve(previous.byExpiry_.size() + added.size());
+    for (size_t position : previous.byExpiry_) {
+        if (moved[position] != GONE) byExpiry_.push_back(moved[position]);
+    }
+
+    for (size_t i : added) {
+        byId_.emplace(items[i].id, i);
+        if (!items[i].barcode.empty()) byBarcode_.emplace(items[i].barcode, i);
+        auto entry = std::make_pair(lowercase(items[i].name), i);
+        byName_.insert(std::lower_bound(byName_.begin(), byName_.end(), entry), std::move(entry));
+        if (items[i].bestBeforeDays >= 0) {
+            auto at = std::upper_bound(byExpiry_.begin(), byExpiry_.end(), i,
+                                       [this](size_t a, size_t b) { return expiresBefore(a, b); });
+            byExpiry_.insert(at, i);
+        }
+    }
+}
+
+void InventoryCache::Snapshot::sortExpiry() {
+    byExpiry_.clear();
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (items[i].bestBeforeDays >= 0) byExpiry_.push_back(i);
+    }
+    std::sort(byExpiry_.begin(), byExpiry_.end(), [this](size_t a, size_t b) { return expiresBefore(a, b); });
+}
+
+// As ORDER BY best_before_days, id
+bool InventoryCache::Snapshot::expiresBefore(size_t a, size_t b) const {
+    if (items[a].bestBeforeDays != items[b].bestBeforeDays) {
+        return items[a].bestBeforeDays < items[b].bestBeforeDays;
+    }
+    return items[a].id < items[b].id;
+}
+
+// ---------------------------------------------------------------------------
+// Cache
+// ---------------------------------------------------------------------------
+InventoryCache::InventoryCache(std::string dbPath)
+    : store_(std::move(dbPath)) {}
+
+std::shared_ptr<const InventoryCache::Snapshot> InventoryCache::current() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!store_.open()) return nullptr;
+
+    // Read before the changes, so a commit landing in between is picked up
+    // again next time rather than missed
+    long long dataVersion = store_.dataVersion();
+    if (snapshot_ && dataVersion >= 0 && dataVersion == dataVersion_) return snapshot_;
+
+    InventoryChanges changes;
+    if (!store_.readChangesSince(snapshot_ ? snapshot_->version : -1, changes)) return nullptr;
+
+    dataVersion_ = dataVersion;
+    if (!snapshot_ || changes.version != snapshot_->version) {
+        snapshot_ = apply(changes.full ? nullptr : snapshot_.get(), std::move(changes));
+    }
+    return snapshot_;
+}
+
+void InventoryCache::writeItem(JsonWriter& json, const InventoryItem& item, unsigned fields,
+                               const long long* daysLeft) {
+    json.beginObject();
+    if (fields & FIELD_ID)          { json.key("id");          json.value(item.id); }
+    if (fields & FIELD_NAME)        { json.key("name");        json.value(item.name); }
+    if (fields & FIELD_BARCODE)     { json.key("barcode");     json.value(item.barcode); }
+    if (fields & FIELD_QUANTITY)    { json.key("quantity");    json.value(item.quantity); }
+    if (fields & FIELD_DATE_ADDED)  { json.key("date_added");  json.value(item.dateAdded); }
+    if (fields & FIELD_BEST_BEFORE) { json.key("best_before"); json.value(item.bestBefore); }
+    if (daysLeft)                   { json.key("days_left");   json.value(*daysLeft); }
+    json.endObject();
+}
+
+bool InventoryCache::parseFields(const std::string& list, unsigned& fields) {
+    fields = 0;
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t comma = std::min(list.find(',', pos), list.size());
+        std::string name = list.substr(pos, comma - pos);
+        pos = comma + 1;
+
+        auto found = std::find_if(std::begin(FIELD_NAMES), std::end(FIELD_NAMES),
+                                  [&name](const auto& field) { return name == field.first; });
+        if (found == std::end(FIELD_NAMES)) return false;
+        fields |= found->second;
+    }
+    return fields != 0;
+}
+
+// "<date_added>_<id>". Dates are YYYY-MM-DD, so the last '_' is the separator.
+std::string InventoryCache::cursorAfter(const InventoryItem& item) {
+    return item.dateAdded + "_" + std::to_string(item.id);
+}
+
+bool InventoryCache::parseCursor(const std::string& cursor, PageQuery& query) {
+    size_t sep = cursor.rfind('_');
+    if (sep == std::string::npos || sep + 1 == cursor.size()) return false;
+
+    char* end = nullptr;
+    long long id = std::strtoll(cursor.c_str() + sep + 1, &end, 10);
+    if (*end != '\0') return false;
+
+    query.after     = true;
+    query.afterDate = cursor.substr(0, sep);
+    query.afterId   = id;
+    return true;
+}
+
+std::shared_ptr<InventoryCache::Snapshot> InventoryCache::apply(const Snapshot* previous,
+                                                                 InventoryChanges&& changes) {
+    auto next = std::make_shared<Snapshot>();
+    next->version = changes.version;
+
+    if (!previous) {
+        next->horizon = changes.horizon;
+        next->items   = std::move(changes.items);
+        next->deleted = std::move(changes.deleted);
+        next->index();
+        return next;
+    }
+
+    next->horizon = previous->horizon;
+    next->deleted = previous->deleted;
+    next->deleted.insert(next->deleted.end(), changes.deleted.begin(), changes.deleted.end());
+
+    // Same bound on tombstones as the database's log
+    size_t max = static_cast<size_t>(InventoryStore::MAX_TOMBSTONES);
+    if (next->deleted.size() > max) {
+        size_t drop = next->deleted.size() - max;
+        next->horizon = std::max(next->horizon, next->deleted[drop - 1].second);
+        next->deleted.erase(next->deleted.begin(), next->deleted.begin() + static_cast<long>(drop));
+    }
+
+    next->patch(*previous, std::move(changes.items), changes.deleted);
+    return next;
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "InventoryStore.hpp"
+#include "JsonWriter.hpp"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief In-memory copy of the inventory table, shared by every worker.
+ *
+ * Reads are served from an immutable Snapshot; SQLite stays the only place
+ * writes go. current() asks its own connection for PRAGMA data_version,
+ * which changes whenever any other connection commits: a worker in this
+ * process, the barcode scanner or the camera. Only then does it read the
+ * change log since the snapshot's version and build a new snapshot, so
+ * every write from any process shows up on the next read.
+ *
+ * Snapshots are never modified. A reader keeps the shared_ptr for as long
+ * as it needs it; a refresh swaps in a new one under the mutex without
+ * waiting for readers. A new snapshot is the previous one with only the
+ * changed rows moved: its rows and indexes are carried over in order, not
+ * sorted or hashed again.
+ *
+ * Thread-safe.
+ *
+ * Usage:
+ * @code
+ *   InventoryCache cache("/var/lib/pifridge/inventory.db");
+ *   auto snapshot = cache.current();
+ *   if (snapshot) {
+ *       const InventoryItem* milk = snapshot->findById(3);
+ *   }
+ * @endcode
+ */
+class InventoryCache {
+public:
+    /** Item fields for ?fields=, as a bitmask. */
+    enum Field : unsigned {
+        FIELD_ID          = 1u << 0,
+        FIELD_NAME        = 1u << 1,
+        FIELD_BARCODE     = 1u << 2,
+        FIELD_QUANTITY    = 1u << 3,
+        FIELD_DATE_ADDED  = 1u << 4,
+        FIELD_BEST_BEFORE = 1u << 5,
+        ALL_FIELDS        = (1u << 6) - 1
+    };
+
+    /**
+     * @brief One page of the listing: filters, where to start and what to write.
+     *
+     * Pages follow the listing order (date_added DESC, id DESC). The cursor
+     * is the (date_added, id) of the last item on the previous page, so a
+     * page starts in the right place however many rows were added or
+     * removed in between.
+     */
+    struct PageQuery {
+        std::string barcode;          ///< Exact match; empty for any
+        std::string namePrefix;       ///< ASCII case-insensitive; empty for any
+        long long   bestBeforeFromDays = -1;   ///< Inclusive BestBefore day number; -1 for no lower bound
+        long long   bestBeforeToDays = -1;     ///< Inclusive BestBefore day number; -1 for no upper bound
+        bool        after = false;    ///< Start after (afterDate, afterId)
+        std::string afterDate;
+        long long   afterId = 0;
+        size_t      limit = 50;
+        unsigned    fields = ALL_FIELDS;
+    };
+
+    /** The table at one version, with lookups by id, barcode and name. */
+    class Snapshot {
+    public:
+        long long version = 0;
+        long long horizon = 0;                                   ///< Oldest version deltas can start at
+        std::vector<InventoryItem> items;                        ///< date_added DESC, id DESC
+        std::vector<std::pair<long long, long long>> deleted;   ///< (id, version), oldest first
+
+        /** items as a JSON array, rendered by the first call and kept. */
+        const std::string& listing() const;
+
+        /** @return nullptr if no item has @p id. */
+        const InventoryItem* findById(long long id) const;
+
+        /** Items stocked under @p barcode (one per best-before date). */
+        std::vector<const InventoryItem*> findByBarcode(const std::string& barcode) const;
+
+        /** Items called @p name, ignoring ASCII case like COLLATE NOCASE. */
+        std::vector<const InventoryItem*> findByName(const std::string& name) const;
+
+        /** Same JSON as InventoryStore::writeChangesSince(), from memory. */
+        void writeChangesSince(long long since, JsonWriter& json) const;
+
+        /**
+         * @brief Write one page as {"version", "items", "next"}.
+         *
+         * "next" is the cursor for the following page, or null after the
+         * last one. A barcode or name prefix filter starts from its index,
+         * and the cursor is found by binary search, so a page costs its own
+         * matches rather than a pass over the table.
+         */
+        void writePage(const PageQuery& query, JsonWriter& json) const;
+
+        /**
+         * @brief Same JSON as InventoryStore::writeExpiring(), from memory.
+         *
+         * Reads the front of the snapshot's expiry order. A write's delta
+         * keeps that order: the other rows' entries are renumbered, and each
+         * changed dated row is inserted by binary search.
+         */
+        void writeExpiring(long long today, int withinDays, JsonWriter& json) const;
+
+    private:
+        friend class InventoryCache;
+
+        /** Sort items and build the indexes from scratch. */
+        void index();
+
+        /**
+         * @brief Fill items and the indexes from @p previous with @p changed
+         *        rows put in place and the @p removed ids left out.
+         *
+         * One merge over the rows; the other rows keep their order, so their
+         * index entries are only renumbered, and each changed row is
+         * inserted into every index on its own.
+         */
+        void patch(const Snapshot& previous, std::vector<InventoryItem>&& changed,
+                   const std::vector<std::pair<long long, long long>>& removed);
+
+        /** Dated items into byExpiry_, soonest first. */
+        void sortExpiry();
+
+        /** byExpiry_ order between the items at two positions. */
+        bool expiresBefore(size_t a, size_t b) const;
+
+        std::unordered_map<long long, size_t> byId_;
+        std::unordered_multimap<std::string, size_t> byBarcode_;
+        std::vector<std::pair<std::string, size_t>> byName_;       // lowercased, sorted
+        std::vector<size_t> byExpiry_;                              // dated items, soonest first
+
+        mutable std::once_flag rendered_;
+        mutable std::string listing_;
+    };
+
+    /**
+     * @param dbPath Path to the SQLite database file.
+     */
+    explicit InventoryCache(std::string dbPath);
+
+    InventoryCache(const InventoryCache&) = delete;
+    InventoryCache& operator=(const InventoryCache&) = delete;
+
+    /**
+     * @brief Return a snapshot that includes every commit made so far.
+     *
+     * Costs one PRAGMA data_version when nothing has changed.
+     *
+     * @return nullptr if the database cannot be read.
+     */
+    std::shared_ptr<const Snapshot> current();
+
+    /**
+     * @brief Writes an item the way InventoryStore does, limited to
+     *        @p fields and ending with "days_left" if @p daysLeft is given.
+     */
+    static void writeItem(JsonWriter& json, const InventoryItem& item, unsigned fields = ALL_FIELDS,
+                          const long long* daysLeft = nullptr);
+
+    /**
+     * @brief Parse a comma-separated ?fields= list such as "id,name,quantity".
+     * @return false if a name is unknown or the list is empty.
+     */
+    static bool parseFields(const std::string& list, unsigned& fields);
+
+    /** The "next" cursor that resumes after @p item. */
+    static std::string cursorAfter(const InventoryItem& item);
+
+    /**
+     * @brief Read a cursor from cursorAfter() into @p query.
+     * @return false if @p cursor is malformed.
+     */
+    static bool parseCursor(const std::string& cursor, PageQuery& query);
+
+private:
+    /** Apply @p changes on top of @p previous (or build from scratch if full). */
+    static std::shared_ptr<Snapshot> apply(const Snapshot* previous, InventoryChanges&& changes);
+
+    std::mutex mutex_;
+    InventoryStore store_;
+    long long dataVersion_ = -1;
+    std::shared_ptr<const Snapshot> snapshot_;
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+/**
+ * @brief SQL for every statement InventoryStore runs per request.
+ *
+ * Kept in one place so test/QueryPlanTest.cpp can run EXPLAIN QUERY PLAN
+ * on exactly what the store prepares, and fail if one of them stops using
+ * an index. A new query added here should get a row in that test too.
+ */
+struct InventoryQueries {
+    static constexpr const char* VERSION =
+        "SELECT version FROM inventory_meta WHERE id = 1;";
+
+    static constexpr const char* VERSION_AND_HORIZON =
+        "SELECT version, log_horizon FROM inventory_meta WHERE id = 1;";
+
+    /** Newest first; walks inventory_listing backwards instead of sorting. */
+    static constexpr const char* ALL_ITEMS =
+        "SELECT id, name, barcode, quantity, date_added, best_before "
+        "FROM inventory ORDER BY date_added DESC, id DESC;";
+
+    /** Every row in rowid order, for export; a plain table scan, no sort. */
+    static constexpr const char* EXPORT_ITEMS =
+        "SELECT id, name, barcode, quantity, date_added, best_before, best_before_days "
+        "FROM inventory ORDER BY id;";
+
+    static constexpr const char* CHANGES_SINCE =
+        "SELECT inventory.id, name, barcode, quantity, date_added, best_before, best_before_days,"
+        "       inventory_changes.item_id, inventory_changes.deleted, inventory_changes.version "
+        "FROM inventory_changes LEFT JOIN inventory ON inventory.id = inventory_changes.item_id "
+        "WHERE inventory_changes.version > ? ORDER BY inventory_changes.version;";
+
+    /** ALL_ITEMS plus the version each item last changed at, if still logged. */
+    static constexpr const char* ALL_ITEMS_WITH_VERSIONS =
+        "SELECT id, name, barcode, quantity, date_added, best_before, best_before_days,"
+        "       inventory_changes.version "
+        "FROM inventory LEFT JOIN inventory_changes "
+        "  ON inventory_changes.item_id = inventory.id AND inventory_changes.deleted = 0 "
+        "ORDER BY date_added DESC, id DESC;";
+
+    static constexpr const char* TOMBSTONES =
+        "SELECT item_id, version FROM inventory_changes WHERE deleted = 1 ORDER BY version;";
+
+    /** Changes whenever another connection commits; never touches the file. */
+    static constexpr const char* DATA_VERSION =
+        "PRAGMA data_version;";
+
+    /** Best first by the bm25 rank configured on inventory_search; no sort step. */
+    static constexpr const char* SEARCH =
+        "SELECT inventory.id, inventory.name, inventory.barcode, quantity, date_added, best_before "
+        "FROM inventory_search JOIN inventory ON inventory.id = inventory_search.rowid "
+        "WHERE inventory_search MATCH ? ORDER BY rank LIMIT ?;";
+
+    /**
+     * Soonest first, expired included; a range scan of the partial
+     * inventory_expiry index, whose rowid order breaks ties without a sort.
+     */
+    static constexpr const char* EXPIRING =
+        "SELECT id, name, barcode, quantity, date_added, best_before, best_before_days "
+        "FROM inventory WHERE best_before_days <= ? ORDER BY best_before_days, id;";
+
+    /** Last event rolled up into inventory_daily, and the newest event. */
+    static constexpr const char* PENDING_EVENTS =
+        "SELECT events_rolled_up, (SELECT MAX(id) FROM inventory_events) "
+        "FROM inventory_meta WHERE id = 1;";
+
+    /** Adds events (?1, ?2] to their days; a rowid range, not a scan. */
+    static constexpr const char* ROLL_UP_EVENTS =
+        "INSERT INTO inventory_daily (day, source, name, added, removed) "
+        "SELECT date(at, 'unixepoch', 'localtime'), source, name, "
+        "       SUM(MAX(delta, 0)), SUM(MAX(-delta, 0)) "
+        "FROM inventory_events WHERE id > ? AND id <= ? "
+        "GROUP BY 1, 2, 3 "
+        "ON CONFLICT (day, source, name) DO UPDATE SET "
+        "  added = added + excluded.added, removed = removed + excluded.removed;";
+
+    static constexpr const char* MARK_ROLLED_UP =
+        "UPDATE inventory_meta SET events_rolled_up = ? WHERE id = 1;";
+
+    /** Raw events up to ?1 that are older than ?2 (unix seconds). */
+    static constexpr const char* PRUNE_EVENTS =
+        "DELETE FROM inventory_events WHERE id <= ? AND at < ?;";
+
+    /** Per day and source, in order; walks the inventory_daily primary key. */
+    static constexpr const char* HISTORY =
+        "SELECT day, source, SUM(added), SUM(removed) FROM inventory_daily "
+        "WHERE day BETWEEN ? AND ? GROUP BY day, source ORDER BY day, source;";
+
+    /** HISTORY for one item name (?3); walks inventory_daily_name. */
+    static constexpr const char* HISTORY_FOR_NAME =
+        "SELECT day, source, SUM(added), SUM(removed) FROM inventory_daily "
+        "WHERE name = ?3 AND day BETWEEN ?1 AND ?2 GROUP BY day, source ORDER BY day, source;";
+
+    /** Conflict target is the inventory_identity unique index. */
+    static constexpr const char* UPSERT =
+        "INSERT INTO inventory (name, barcode, quantity, date_added, best_before, best_before_days) "
+        "VALUES (?, ?, ?, ?, ?, ?) "
+        "ON CONFLICT (name COLLATE NOCASE, barcode, best_before) "
+        "DO UPDATE SET quantity = quantity + excluded.quantity "
+        "RETURNING quantity;";
+
+    /** Answered from the partial inventory_barcode index alone. */
+    static constexpr const char* NAME_FOR_BARCODE =
+        "SELECT name FROM inventory WHERE barcode = ? AND barcode <> '' LIMIT 1;";
+
+    static constexpr const char* DELETE_ITEM =
+        "DELETE FROM inventory WHERE id = ?;";
+
+    static constexpr const char* DECREMENT_ITEM =
+        "UPDATE inventory SET quantity = quantity - 1 WHERE id = ? RETURNING quantity;";
+
+    static constexpr const char* INCREMENT_ITEM =
+        "UPDATE inventory SET quantity = quantity + 1 WHERE id = ?;";
+
+    static constexpr const char* UPDATE_ITEM =
+        "UPDATE inventory SET name = ?, barcode = ?, quantity = ?, best_before = ?, best_before_days = ? "
+        "WHERE id = ?;";
+};
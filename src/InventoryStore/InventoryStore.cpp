@@ -0,0 +1,1017 @@
+#include "InventoryStore.hpp"
+
+#include "BestBefore.hpp"
+#include "InventoryQueries.hpp"
+
+#include <cctype>
+#include <ctime>
+#include <iostream>
+#include <utility>
+
+namespace {
+
+// Resets a cached statement when it goes out of scope so it releases its
+// read lock and drops its bindings before the next request reuses it.
+class StatementReset {
+public:
+    explicit StatementReset(sqlite3_stmt* stmt) : stmt_(stmt) {}
+    ~StatementReset() {
+        if (stmt_) {
+            sqlite3_reset(stmt_);
+            sqlite3_clear_bindings(stmt_);
+        }
+    }
+
+    StatementReset(const StatementReset&) = delete;
+    StatementReset& operator=(const StatementReset&) = delete;
+
+private:
+    sqlite3_stmt* stmt_;
+};
+
+// Holds a read transaction open for the enclosing scope
+class ReadTransaction {
+public:
+    explicit ReadTransaction(sqlite3* db)
+        : db_(db), ok_(sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr) == SQLITE_OK) {}
+    ~ReadTransaction() {
+        if (ok_) sqlite3_exec(db_, "COMMIT;", nullptr, nullptr, nullptr);
+    }
+
+    ReadTransaction(const ReadTransaction&) = delete;
+    ReadTransaction& operator=(const ReadTransaction&) = delete;
+
+    bool ok() const { return ok_; }
+
+private:
+    sqlite3* db_;
+    bool ok_;
+};
+
+// Holds a write transaction; rolls back unless commit() is called. Inside a
+// transaction that is already open (a batch) it becomes a savepoint, so the
+// enclosed writes still succeed or fail together without ending the batch.
+class WriteTransaction {
+public:
+    explicit WriteTransaction(sqlite3* db)
+        : db_(db), nested_(!sqlite3_get_autocommit(db)),
+          open_(sqlite3_exec(db, nested_ ? "SAVEPOINT nested;" : "BEGIN IMMEDIATE;",
+                             nullptr, nullptr, nullptr) == SQLITE_OK) {}
+    ~WriteTransaction() {
+        if (!open_) return;
+        sqlite3_exec(db_, nested_ ? "ROLLBACK TO nested; RELEASE nested;" : "ROLLBACK;",
+                     nullptr, nullptr, nullptr);
+    }
+
+    WriteTransaction(const WriteTransaction&) = delete;
+    WriteTransaction& operator=(const WriteTransaction&) = delete;
+
+    bool ok() const { return open_; }
+
+    bool commit() {
+        if (!open_) return false;
+        open_ = false;
+        return sqlite3_exec(db_, nested_ ? "RELEASE nested;" : "COMMIT;",
+                            nullptr, nullptr, nullptr) == SQLITE_OK;
+    }
+
+private:
+    sqlite3* db_;
+    bool nested_;
+    bool open_;
+};
+
+// Writes the item in columns id, name, barcode, quantity, date_added,
+// best_before as a JSON object, ending with "days_left" if given
+void writeItem(JsonWriter& json, sqlite3_stmt* stmt, const long long* daysLeft = nullptr) {
+    auto text = [stmt](int column) {
+        const char* value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+        return std::string_view(value ? value : "", static_cast<size_t>(sqlite3_column_bytes(stmt, column)));
+    };
+
+    json.beginObject();
+    json.key("id");          json.value(sqlite3_column_int64(stmt, 0));
+    json.key("name");        json.value(text(1));
+    json.key("barcode");     json.value(text(2));
+    json.key("quantity");    json.value(sqlite3_column_int64(stmt, 3));
+    json.key("date_added");  json.value(text(4));
+    json.key("best_before"); json.value(text(5));
+    if (daysLeft) { json.key("days_left"); json.value(*daysLeft); }
+    json.endObject();
+}
+
+// Reads the item in columns id, name, barcode, quantity, date_added,
+// best_before, best_before_days
+InventoryItem readItem(sqlite3_stmt* stmt) {
+    auto text = [stmt](int column) {
+        const char* value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+        return std::string(value ? value : "", static_cast<size_t>(sqlite3_column_bytes(stmt, column)));
+    };
+
+    InventoryItem item;
+    item.id         = sqlite3_column_int64(stmt, 0);
+    item.name       = text(1);
+    item.barcode    = text(2);
+    item.quantity   = sqlite3_column_int64(stmt, 3);
+    item.dateAdded  = text(4);
+    item.bestBefore = text(5);
+    item.bestBeforeDays = sqlite3_column_type(stmt, 6) == SQLITE_NULL ? -1 : sqlite3_column_int64(stmt, 6);
+    return item;
+}
+
+// Turns what the user typed into an FTS5 query. Each word must match the
+// start of a word in the name or barcode; a whole-word match also scores as
+// an exact one, so "egg" ranks Egg above Eggplant. Anything that isn't a
+// letter or digit separates words, so FTS5 syntax in the input is inert.
+std::string matchExpression(const std::string& query) {
+    static const size_t MAX_WORDS = 8;
+
+    std::string expression;
+    size_t words = 0;
+    size_t i = 0;
+    while (i < query.size() && words < MAX_WORDS) {
+        auto isWordByte = [](unsigned char c) { return std::isalnum(c) || c >= 0x80; };
+
+        while (i < query.size() && !isWordByte(static_cast<unsigned char>(query[i]))) ++i;
+        size_t start = i;
+        while (i < query.size() && isWordByte(static_cast<unsigned char>(query[i]))) ++i;
+        if (i == start) break;
+
+        std::string word = query.substr(start, i - start);
+        if (words++ > 0) expression += " AND ";
+        expression += "(\"" + word + "\" OR \"" + word + "\"*)";
+    }
+    return expression;
+}
+
+} // namespace
+
+InventoryStore::InventoryStore(std::string dbPath, std::string source)
+    : dbPath_(std::move(dbPath)) {
+    // Spliced into the trigger SQL, so nothing that could end the literal
+    for (char c : source) {
+        if (std::isalnum(static_cast<unsigned char>(c)) || c == '_') source_ += c;
+    }
+}
+
+InventoryStore::~InventoryStore() {
+    close();
+}
+
+bool InventoryStore::open() {
+    if (db_) return true;
+
+    if (sqlite3_open(dbPath_.c_str(), &db_) != SQLITE_OK) {
+        std::cerr << "[inventory] Failed to open DB: " << sqlite3_errmsg(db_) << "\n";
+        sqlite3_close(db_);
+        db_ = nullptr;
+        return false;
+    }
+
+    // The scanner and camera write through their own connections; wait for
+    // their locks rather than failing the request outright.
+    sqlite3_busy_timeout(db_, 2000);
+
+    // WAL lets readers on other connections carry on while one writer commits.
+    // The mode is stored in the database file, so this only converts it once.
+    // NORMAL sync is durable across application crashes in WAL mode and skips
+    // the per-commit fsync.
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db_, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;",
+                     nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "[inventory] Failed to enable WAL: " << errMsg << "\n";
+        sqlite3_free(errMsg);
+    }
+
+    if (!migrate() || !installEventTriggers()) {
+        sqlite3_close(db_);
+        db_ = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+void InventoryStore::close() {
+    for (auto& entry : statements_) {
+        sqlite3_finalize(entry.second);
+    }
+    statements_.clear();
+
+    if (db_) {
+        sqlite3_close(db_);
+        db_ = nullptr;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Schema migrations
+//
+// The schema is defined only here. PRAGMA user_version records the last step
+// applied; a store that finds it current does no DDL at all. To change the
+// schema, add a case to applyMigration() and bump SCHEMA_VERSION.
+//
+// Steps 1-4 also upgrade databases from before user_version was used
+// (created by the old scanner, or by pifridge_inventory's per-request DDL),
+// so they are written to be safe on tables that already have some of it.
+// ---------------------------------------------------------------------------
+bool InventoryStore::migrate() {
+    int current = userVersion();
+    if (current < 0) return false;
+    if (current >= SCHEMA_VERSION) return true;
+
+    WriteTransaction transaction(db_);
+    if (!transaction.ok()) {
+        std::cerr << "[inventory] Failed to start migration: " << sqlite3_errmsg(db_) << "\n";
+        return false;
+    }
+
+    // Another process may have migrated while we waited for the lock
+    current = userVersion();
+    for (int step = current + 1; step <= SCHEMA_VERSION; ++step) {
+        if (!applyMigration(step)) {
+            std::cerr << "[inventory] Migration to schema " << step << " failed\n";
+            return false;
+        }
+    }
+
+    std::string setVersion = "PRAGMA user_version = " + std::to_string(SCHEMA_VERSION) + ";";
+    if (!exec(setVersion.c_str()) || !transaction.commit()) return false;
+
+    std::cout << "[inventory] Schema migrated from " << current << " to " << SCHEMA_VERSION << "\n";
+    return true;
+}
+
+bool InventoryStore::applyMigration(int step) {
+    switch (step) {
+    case 1:
+        // Base table. Databases created by the barcode scanner predate best_before.
+        return exec(
+                   "CREATE TABLE IF NOT EXISTS inventory ("
+                   "  id          INTEGER PRIMARY KEY AUTOINCREMENT,"
+                   "  name        TEXT    NOT NULL,"
+                   "  barcode     TEXT,"
+                   "  quantity    INTEGER NOT NULL DEFAULT 1,"
+                   "  date_added  TEXT    NOT NULL,"
+                   "  best_before TEXT"
+                   ");") &&
+               addColumnIfMissing("inventory", "best_before TEXT") >= 0;
+
+    case 2:
+        // Change counter, served as the ETag for GET /api/inventory
+        return exec(
+            "CREATE TABLE IF NOT EXISTS inventory_meta ("
+            "  id      INTEGER PRIMARY KEY CHECK (id = 1),"
+            "  version INTEGER NOT NULL"
+            ");"
+            "INSERT OR IGNORE INTO inventory_meta (id, version) VALUES (1, 0);");
+
+    case 3: {
+        // Change log for GET /api/inventory?since=. Every insert, update and
+        // delete — from the UI, the scanner or the camera, whichever
+        // connection — bumps the version and records the row under it, so no
+        // write path can forget to log. Compaction happens inline:
+        //   - a change supersedes any earlier entry for the same item, so the
+        //     log holds at most one entry per item;
+        //   - only the newest MAX_TOMBSTONES deletions are kept; dropping
+        //     older ones raises log_horizon, and clients behind it get a
+        //     full resync.
+        // Versions below log_horizon are not covered by the log. When the
+        // column is first added, nothing before now is logged.
+        int added = addColumnIfMissing("inventory_meta", "log_horizon INTEGER NOT NULL DEFAULT 0");
+        if (added < 0) return false;
+        if (added > 0 && !exec("UPDATE inventory_meta SET log_horizon = version WHERE id = 1;")) return false;
+
+        const std::string createChangeLog =
+            "CREATE TABLE IF NOT EXISTS inventory_changes ("
+            "  version INTEGER PRIMARY KEY,"
+            "  item_id INTEGER NOT NULL,"
+            "  deleted INTEGER NOT NULL DEFAULT 0"
+            ");"
+            "CREATE INDEX IF NOT EXISTS inventory_changes_item ON inventory_changes (item_id);"
+            "CREATE INDEX IF NOT EXISTS inventory_changes_deleted ON inventory_changes (deleted, version);"
+
+            // Replaces the plain version-bump triggers
+            "DROP TRIGGER IF EXISTS inventory_version_insert;"
+            "DROP TRIGGER IF EXISTS inventory_version_update;"
+            "DROP TRIGGER IF EXISTS inventory_version_delete;"
+
+            "CREATE TRIGGER IF NOT EXISTS inventory_change_insert AFTER INSERT ON inventory BEGIN"
+            "  UPDATE inventory_meta SET version = version + 1 WHERE id = 1;"
+            "  DELETE FROM inventory_changes WHERE item_id = NEW.id;"
+            "  INSERT INTO inventory_changes (version, item_id, deleted)"
+            "    SELECT version, NEW.id, 0 FROM inventory_meta WHERE id = 1;"
+            "END;"
+
+            "CREATE TRIGGER IF NOT EXISTS inventory_change_update AFTER UPDATE ON inventory BEGIN"
+            "  UPDATE inventory_meta SET version = version + 1 WHERE id = 1;"
+            "  DELETE FROM inventory_changes WHERE item_id = NEW.id;"
+            "  INSERT INTO inventory_changes (version, item_id, deleted)"
+            "    SELECT version, NEW.id, 0 FROM inventory_meta WHERE id = 1;"
+            "END;"
+
+            "CREATE TRIGGER IF NOT EXISTS inventory_change_delete AFTER DELETE ON inventory BEGIN"
+            "  UPDATE inventory_meta SET version = version + 1 WHERE id = 1;"
+            "  DELETE FROM inventory_changes WHERE item_id = OLD.id;"
+            "  INSERT INTO inventory_changes (version, item_id, deleted)"
+            "    SELECT version, OLD.id, 1 FROM inventory_meta WHERE id = 1;"
+            "  UPDATE inventory_meta SET log_horizon = IFNULL("
+            "    (SELECT version FROM inventory_changes WHERE deleted = 1"
+            "     ORDER BY version DESC LIMIT 1 OFFSET " + std::to_string(MAX_TOMBSTONES) + "),"
+            "    log_horizon) WHERE id = 1;"
+            "  DELETE FROM inventory_changes WHERE deleted = 1"
+            "    AND version <= (SELECT log_horizon FROM inventory_meta WHERE id = 1);"
+            "END;";
+        return exec(createChangeLog.c_str());
+    }
+
+    case 4:
+        // One row per (name, barcode, best_before), so adds can be single
+        // INSERT ... ON CONFLICT statements. NULLs would never conflict, so
+        // they are normalised to '' first, and rows that already duplicate
+        // each other are merged into the oldest one.
+        return exec(
+            "UPDATE inventory SET barcode = '' WHERE barcode IS NULL;"
+            "UPDATE inventory SET best_before = '' WHERE best_before IS NULL;"
+            "UPDATE inventory SET quantity = ("
+            "  SELECT SUM(d.quantity) FROM inventory AS d"
+            "  WHERE d.name = inventory.name COLLATE NOCASE"
+            "    AND d.barcode = inventory.barcode AND d.best_before = inventory.best_before"
+            ") WHERE id IN ("
+            "  SELECT MIN(id) FROM inventory GROUP BY name COLLATE NOCASE, barcode, best_before"
+            "  HAVING COUNT(*) > 1"
+            ");"
+            "DELETE FROM inventory WHERE id NOT IN ("
+            "  SELECT MIN(id) FROM inventory GROUP BY name COLLATE NOCASE, barcode, best_before"
+            ");"
+            "CREATE UNIQUE INDEX IF NOT EXISTS inventory_identity"
+            "  ON inventory (name COLLATE NOCASE, barcode, best_before);");
+
+    case 5:
+        // Indexes for the per-request queries (test/QueryPlanTest.cpp checks
+        // none of them falls back to a table scan). Name lookups, including
+        // the camera's barcode-less upsert, already use inventory_identity.
+        //   inventory_barcode: scanner's barcode -> name lookup, covering,
+        //     and partial so barcode-less camera rows take no space in it
+        //   inventory_listing: GET /api/inventory order; the rowid (id)
+        //     follows date_added in every index entry, so no sort is needed
+        return exec(
+            "CREATE INDEX IF NOT EXISTS inventory_barcode"
+            "  ON inventory (barcode, name) WHERE barcode <> '';"
+            "CREATE INDEX IF NOT EXISTS inventory_listing ON inventory (date_added);");
+
+    case 6:
+        // Full-text index over names and barcodes for /api/inventory/search.
+        // External content: the text stays in inventory, the FTS table only
+        // holds the index, kept in step by the triggers below. Prefix
+        // indexes for 1-3 characters keep type-ahead on short input from
+        // walking every term. Names weigh ten times barcodes in the ranking.
+        return exec(
+            "CREATE VIRTUAL TABLE IF NOT EXISTS inventory_search USING fts5("
+            "  name, barcode,"
+            "  content = 'inventory', content_rowid = 'id',"
+            "  tokenize = 'unicode61 remove_diacritics 2', prefix = '1 2 3'"
+            ");"
+            "INSERT INTO inventory_search (inventory_search) VALUES ('rebuild');"
+            "INSERT INTO inventory_search (inventory_search, rank) VALUES ('rank', 'bm25(10.0, 1.0)');"
+
+            "CREATE TRIGGER IF NOT EXISTS inventory_search_insert AFTER INSERT ON inventory BEGIN"
+            "  INSERT INTO inventory_search (rowid, name, barcode) VALUES (NEW.id, NEW.name, NEW.barcode);"
+            "END;"
+
+            "CREATE TRIGGER IF NOT EXISTS inventory_search_delete AFTER DELETE ON inventory BEGIN"
+            "  INSERT INTO inventory_search (inventory_search, rowid, name, barcode)"
+            "    VALUES ('delete', OLD.id, OLD.name, OLD.barcode);"
+            "END;"
+
+            // Quantity changes — nearly every write — leave the index alone
+            "CREATE TRIGGER IF NOT EXISTS inventory_search_update AFTER UPDATE OF name, barcode ON inventory BEGIN"
+            "  INSERT INTO inventory_search (inventory_search, rowid, name, barcode)"
+            "    VALUES ('delete', OLD.id, OLD.name, OLD.barcode);"
+            "  INSERT INTO inventory_search (rowid, name, barcode) VALUES (NEW.id, NEW.name, NEW.barcode);"
+            "END;");
+
+    case 7: {
+        // best_before as a day number for /api/inventory/expiring. Writes
+        // through the store fill it in; existing rows are parsed here. Their
+        // text is left as it was, since normalising it could make two rows
+        // collide on inventory_identity. The index is partial: undated rows,
+        // most of the camera's, take no space in it.
+        if (addColumnIfMissing("inventory", "best_before_days INTEGER") < 0) return false;
+
+        sqlite3_stmt* select = nullptr;
+        sqlite3_stmt* update = nullptr;
+        bool ok = sqlite3_prepare_v2(db_, "SELECT id, best_before FROM inventory WHERE best_before <> '';",
+                                     -1, &select, nullptr) == SQLITE_OK &&
+                  sqlite3_prepare_v2(db_, "UPDATE inventory SET best_before_days = ? WHERE id = ?;",
+                                     -1, &update, nullptr) == SQLITE_OK;
+        while (ok && sqlite3_step(select) == SQLITE_ROW) {
+            const char* text = reinterpret_cast<const char*>(sqlite3_column_text(select, 1));
+            BestBefore date;
+            if (!BestBefore::parse(text ? text : "", date)) continue;
+
+            sqlite3_bind_int64(update, 1, date.days);
+            sqlite3_bind_int64(update, 2, sqlite3_column_int64(select, 0));
+            ok = sqlite3_step(update) == SQLITE_DONE;
+            sqlite3_reset(update);
+        }
+        sqlite3_finalize(select);
+        sqlite3_finalize(update);
+
+        return ok && exec(
+            "CREATE INDEX IF NOT EXISTS inventory_expiry"
+            "  ON inventory (best_before_days) WHERE best_before_days IS NOT NULL;");
+    }
+
+    case 8:
+        // Inventory history for /api/inventory/history. inventory_events is
+        // append-only: one row per change in quantity, written by each
+        // store's temporary triggers (installEventTriggers) so it knows the
+        // source. rollUpHistory() folds it into inventory_daily, which range
+        // queries read instead. The name is copied, since deleted items
+        // lose their row. Keyed by day first so a date range is one walk of
+        // the primary key, grouped by day and source without a sort.
+        return addColumnIfMissing("inventory_meta", "events_rolled_up INTEGER NOT NULL DEFAULT 0") >= 0 &&
+               exec(
+                   "CREATE TABLE IF NOT EXISTS inventory_events ("
+                   "  id      INTEGER PRIMARY KEY AUTOINCREMENT,"   // never reused after pruning
+                   "  at      INTEGER NOT NULL,"     // unix seconds
+                   "  item_id INTEGER NOT NULL,"
+                   "  name    TEXT    NOT NULL,"
+                   "  delta   INTEGER NOT NULL,"
+                   "  source  TEXT    NOT NULL"
+                   ");"
+                   "CREATE TABLE IF NOT EXISTS inventory_daily ("
+                   "  day     TEXT    NOT NULL,"     // YYYY-MM-DD, local time
+                   "  source  TEXT    NOT NULL,"
+                   "  name    TEXT    NOT NULL COLLATE NOCASE,"
+                   "  added   INTEGER NOT NULL,"
+                   "  removed INTEGER NOT NULL,"
+                   "  PRIMARY KEY (day, source, name)"
+                   ") WITHOUT ROWID;"
+                   "CREATE INDEX IF NOT EXISTS inventory_daily_name ON inventory_daily (name, day, source);");
+
+    default:
+        return false;
+    }
+}
+
+// Temporary triggers belong to this connection alone, which is how each
+// event learns its source; they are not stored in the database file.
+// Connections that never open a store, such as the sqlite3 shell, record
+// nothing. An upsert that merges fires the update trigger, and a decrement
+// to zero logs its -1 while the delete that follows has nothing left to log.
+bool InventoryStore::installEventTriggers() {
+    const std::string values = "(CAST(strftime('%s', 'now') AS INTEGER), ";
+    const std::string source = ", '" + source_ + "');";
+    const std::string sql =
+        "CREATE TEMP TRIGGER inventory_event_insert AFTER INSERT ON main.inventory BEGIN"
+        "  INSERT INTO inventory_events (at, item_id, name, delta, source) VALUES "
+        + values + "NEW.id, NEW.name, NEW.quantity" + source +
+        "END;"
+        "CREATE TEMP TRIGGER inventory_event_update AFTER UPDATE OF quantity ON main.inventory"
+        "  WHEN NEW.quantity <> OLD.quantity BEGIN"
+        "  INSERT INTO inventory_events (at, item_id, name, delta, source) VALUES "
+        + values + "NEW.id, NEW.name, NEW.quantity - OLD.quantity" + source +
+        "END;"
+        "CREATE TEMP TRIGGER inventory_event_delete AFTER DELETE ON main.inventory"
+        "  WHEN OLD.quantity > 0 BEGIN"
+        "  INSERT INTO inventory_events (at, item_id, name, delta, source) VALUES "
+        + values + "OLD.id, OLD.name, -OLD.quantity" + source +
+        "END;";
+    return exec(sql.c_str());
+}
+
+int InventoryStore::userVersion() {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, "PRAGMA user_version;", -1, &stmt, nullptr) != SQLITE_OK) return -1;
+
+    int version = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : -1;
+    sqlite3_finalize(stmt);
+    return version;
+}
+
+bool InventoryStore::exec(const char* sql) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db_, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "[inventory] " << (errMsg ? errMsg : "exec failed") << "\n";
+        sqlite3_free(errMsg);
+        return false;
+    }
+    return true;
+}
+
+// Returns 1 if the column was added, 0 if it already existed, -1 on error
+int InventoryStore::addColumnIfMissing(const char* table, const char* columnDef) {
+    std::string alter = std::string("ALTER TABLE ") + table + " ADD COLUMN " + columnDef + ";";
+
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db_, alter.c_str(), nullptr, nullptr, &errMsg) == SQLITE_OK) return 1;
+
+    std::string err = errMsg ? errMsg : "";
+    sqlite3_free(errMsg);
+
+    if (err.find("duplicate column name") != std::string::npos) return 0;
+
+    std::cerr << "[inventory] Failed to add column " << table << "." << columnDef << ": " << err << "\n";
+    return -1;
+}
+
+sqlite3_stmt* InventoryStore::statement(const char* sql) {
+    if (!db_) return nullptr;
+
+    auto it = statements_.find(sql);
+    if (it != statements_.end()) return it->second;
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v3(db_, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "[inventory] Failed to prepare: " << sqlite3_errmsg(db_) << "\n";
+        return nullptr;
+    }
+
+    statements_.emplace(sql, stmt);
+    return stmt;
+}
+
+long long InventoryStore::version() {
+    sqlite3_stmt* stmt = statement(InventoryQueries::VERSION);
+    if (!stmt) return -1;
+    StatementReset reset(stmt);
+
+    if (sqlite3_step(stmt) != SQLITE_ROW) return -1;
+    return sqlite3_column_int64(stmt, 0);
+}
+
+std::string InventoryStore::getAllItems() {
+    std::string out;
+    JsonWriter json = JsonWriter::toString(out);
+    if (!writeAllItems(json)) return "{\"error\": \"Failed to query inventory\"}";
+    json.flush();
+    return out;
+}
+
+// Streams all inventory items as a JSON array, one row at a time
+bool InventoryStore::writeAllItems(JsonWriter& json) {
+    sqlite3_stmt* stmt = statement(InventoryQueries::ALL_ITEMS);
+    if (!stmt) return false;
+    StatementReset reset(stmt);
+
+    json.beginArray();
+    while (sqlite3_step(stmt) == SQLITE_ROW && json.ok()) {
+        writeItem(json, stmt);
+    }
+    json.endArray();
+    return true;
+}
+
+bool InventoryStore::forEachItem(const std::function<bool(const InventoryItem&)>& visit) {
+    sqlite3_stmt* stmt = statement(InventoryQueries::EXPORT_ITEMS);
+    if (!stmt) return false;
+    StatementReset reset(stmt);
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (!visit(readItem(stmt))) return true;
+    }
+    return rc == SQLITE_DONE;
+}
+
+std::string InventoryStore::getChangesSince(long long since) {
+    std::string out;
+    JsonWriter json = JsonWriter::toString(out);
+    if (!writeChangesSince(since, json)) return "{\"error\": \"Failed to query inventory\"}";
+    json.flush();
+    return out;
+}
+
+bool InventoryStore::writeChangesSince(long long since, JsonWriter& json) {
+    // One read transaction so version, horizon and rows share a snapshot
+    ReadTransaction snapshot(db_);
+    if (!snapshot.ok()) return false;
+
+    long long current = 0;
+    long long horizon = 0;
+    {
+        sqlite3_stmt* stmt = statement(InventoryQueries::VERSION_AND_HORIZON);
+        if (!stmt) return false;
+        StatementReset reset(stmt);
+
+        if (sqlite3_step(stmt) != SQLITE_ROW) return false;
+        current = sqlite3_column_int64(stmt, 0);
+        horizon = sqlite3_column_int64(stmt, 1);
+    }
+
+    if (since < 0 || since < horizon || since > current) {
+        // Too old for the log (or from another database) — resend everything.
+        // Prepared up front so a failure leaves the output untouched.
+        if (!statement(InventoryQueries::ALL_ITEMS)) return false;
+
+        json.beginObject();
+        json.key("version"); json.value(current);
+        json.key("full");    json.value(true);
+        json.key("items");
+        writeAllItems(json);
+        json.endObject();
+        return true;
+    }
+
+    // Deleted items have no inventory row, so the LEFT JOIN leaves them NULL
+    sqlite3_stmt* stmt = statement(InventoryQueries::CHANGES_SINCE);
+    if (!stmt) return false;
+    StatementReset reset(stmt);
+
+    sqlite3_bind_int64(stmt, 1, since);
+
+    json.beginObject();
+    json.key("version"); json.value(current);
+    json.key("full");    json.value(false);
+    json.key("changes");
+    json.beginArray();
+
+    while (sqlite3_step(stmt) == SQLITE_ROW && json.ok()) {
+        if (sqlite3_column_int(stmt, 8) || sqlite3_column_type(stmt, 0) == SQLITE_NULL) {
+            json.beginObject();
+            json.key("id");      json.value(sqlite3_column_int64(stmt, 7));
+            json.key("deleted"); json.value(true);
+            json.endObject();
+        } else {
+            writeItem(json, stmt);
+        }
+    }
+
+    json.endArray();
+    json.endObject();
+    return true;
+}
+
+bool InventoryStore::readChangesSince(long long since, InventoryChanges& out) {
+    out = InventoryChanges();
+
+    ReadTransaction snapshot(db_);
+    if (!snapshot.ok()) return false;
+
+    {
+        sqlite3_stmt* stmt = statement(InventoryQueries::VERSION_AND_HORIZON);
+        if (!stmt) return false;
+        StatementReset reset(stmt);
+
+        if (sqlite3_step(stmt) != SQLITE_ROW) return false;
+        out.version = sqlite3_column_int64(stmt, 0);
+        out.horizon = sqlite3_column_int64(stmt, 1);
+    }
+
+    out.full = since < 0 || since < out.horizon || since > out.version;
+
+    if (out.full) {
+        sqlite3_stmt* stmt = statement(InventoryQueries::ALL_ITEMS_WITH_VERSIONS);
+        if (!stmt) return false;
+        StatementReset reset(stmt);
+
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            out.items.push_back(readItem(stmt));
+            out.items.back().changed = sqlite3_column_type(stmt, 7) == SQLITE_NULL
+                                           ? out.horizon : sqlite3_column_int64(stmt, 7);
+        }
+
+        sqlite3_stmt* tombstones = statement(InventoryQueries::TOMBSTONES);
+        if (!tombstones) return false;
+        StatementReset resetTombstones(tombstones);
+
+        while (sqlite3_step(tombstones) == SQLITE_ROW) {
+            out.deleted.emplace_back(sqlite3_column_int64(tombstones, 0), sqlite3_column_int64(tombstones, 1));
+        }
+        return true;
+    }
+
+    sqlite3_stmt* stmt = statement(InventoryQueries::CHANGES_SINCE);
+    if (!stmt) return false;
+    StatementReset reset(stmt);
+
+    sqlite3_bind_int64(stmt, 1, since);
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        long long changed = sqlite3_column_int64(stmt, 9);
+        if (sqlite3_column_int(stmt, 8) || sqlite3_column_type(stmt, 0) == SQLITE_NULL) {
+            out.deleted.emplace_back(sqlite3_column_int64(stmt, 7), changed);
+        } else {
+            out.items.push_back(readItem(stmt));
+            out.items.back().changed = changed;
+        }
+    }
+    return true;
+}
+
+std::string InventoryStore::getExpiring(long long today, int withinDays) {
+    std::string out;
+    JsonWriter json = JsonWriter::toString(out);
+    if (!writeExpiring(today, withinDays, json)) return "{\"error\": \"Failed to query inventory\"}";
+    json.flush();
+    return out;
+}
+
+bool InventoryStore::writeExpiring(long long today, int withinDays, JsonWriter& json) {
+    sqlite3_stmt* stmt = statement(InventoryQueries::EXPIRING);
+    if (!stmt) return false;
+    StatementReset reset(stmt);
+
+    sqlite3_bind_int64(stmt, 1, today + withinDays);
+
+    json.beginArray();
+    while (sqlite3_step(stmt) == SQLITE_ROW && json.ok()) {
+        long long daysLeft = sqlite3_column_int64(stmt, 6) - today;
+        writeItem(json, stmt, &daysLeft);
+    }
+    json.endArray();
+    return true;
+}
+
+bool InventoryStore::rollUpHistory() {
+    // Cheap check first, so an idle roll-up never takes the write lock
+    auto pending = [this](long long& rolled, long long& latest) {
+        sqlite3_stmt* stmt = statement(InventoryQueries::PENDING_EVENTS);
+        if (!stmt) return false;
+        StatementReset reset(stmt);
+
+        if (sqlite3_step(stmt) != SQLITE_ROW) return false;
+        rolled = sqlite3_column_int64(stmt, 0);
+        latest = sqlite3_column_int64(stmt, 1);   // NULL (0) with no events
+        return true;
+    };
+
+    long long rolled = 0;
+    long long latest = 0;
+    if (!pending(rolled, latest)) return false;
+    if (latest <= rolled) return true;
+
+    WriteTransaction transaction(db_);
+    if (!transaction.ok()) return false;
+
+    // Another connection may have rolled up while we waited for the lock
+    if (!pending(rolled, latest)) return false;
+    if (latest <= rolled) return true;
+
+    sqlite3_stmt* rollUp = statement(InventoryQueries::ROLL_UP_EVENTS);
+    sqlite3_stmt* mark   = statement(InventoryQueries::MARK_ROLLED_UP);
+    sqlite3_stmt* prune  = statement(InventoryQueries::PRUNE_EVENTS);
+    if (!rollUp || !mark || !prune) return false;
+    StatementReset resetRollUp(rollUp);
+    StatementReset resetMark(mark);
+    StatementReset resetPrune(prune);
+
+    sqlite3_bind_int64(rollUp, 1, rolled);
+    sqlite3_bind_int64(rollUp, 2, latest);
+    sqlite3_bind_int64(mark, 1, latest);
+    sqlite3_bind_int64(prune, 1, latest);
+    sqlite3_bind_int64(prune, 2, static_cast<long long>(time(nullptr)) - RAW_EVENT_DAYS * 86400LL);
+
+    if (sqlite3_step(rollUp) != SQLITE_DONE ||
+        sqlite3_step(mark) != SQLITE_DONE ||
+        sqlite3_step(prune) != SQLITE_DONE) {
+        std::cerr << "[inventory] History roll-up failed: " << sqlite3_errmsg(db_) << "\n";
+        return false;
+    }
+    return transaction.commit();
+}
+
+std::string InventoryStore::getHistory(const std::string& from, const std::string& to,
+                                       const std::string& name) {
+    std::string out;
+    JsonWriter json = JsonWriter::toString(out);
+    if (!writeHistory(from, to, name, json)) return "{\"error\": \"Failed to query history\"}";
+    json.flush();
+    return out;
+}
+
+bool InventoryStore::writeHistory(const std::string& from, const std::string& to,
+                                  const std::string& name, JsonWriter& json) {
+    sqlite3_stmt* stmt = statement(name.empty() ? InventoryQueries::HISTORY
+                                                : InventoryQueries::HISTORY_FOR_NAME);
+    if (!stmt) return false;
+    StatementReset reset(stmt);
+
+    sqlite3_bind_text(stmt, 1, from.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, to.c_str(),   -1, SQLITE_STATIC);
+    if (!name.empty()) sqlite3_bind_text(stmt, 3, name.c_str(), -1, SQLITE_STATIC);
+
+    json.beginObject();
+    json.key("from"); json.value(from);
+    json.key("to");   json.value(to);
+    json.key("days");
+    json.beginArray();
+
+    // Rows come per (day, source); each day's sources are written as they
+    // arrive and its totals when the day changes
+    std::string day;
+    long long added = 0;
+    long long removed = 0;
+    auto endDay = [&] {
+        json.endObject();
+        json.key("added");   json.value(added);
+        json.key("removed"); json.value(removed);
+        json.endObject();
+    };
+
+    while (sqlite3_step(stmt) == SQLITE_ROW && json.ok()) {
+        const char* rowDay = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        const char* source = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        if (!rowDay || day != rowDay) {
+            if (!day.empty()) endDay();
+            day = rowDay ? rowDay : "";
+            added = removed = 0;
+
+            json.beginObject();
+            json.key("day"); json.value(day);
+            json.key("sources");
+            json.beginObject();
+        }
+
+        long long sourceAdded   = sqlite3_column_int64(stmt, 2);
+        long long sourceRemoved = sqlite3_column_int64(stmt, 3);
+        added   += sourceAdded;
+        removed += sourceRemoved;
+
+        json.key(source ? source : "");
+        json.beginObject();
+        json.key("added");   json.value(sourceAdded);
+        json.key("removed"); json.value(sourceRemoved);
+        json.endObject();
+    }
+    if (!day.empty()) endDay();
+
+    json.endArray();
+    json.endObject();
+    return true;
+}
+
+long long InventoryStore::dataVersion() {
+    sqlite3_stmt* stmt = statement(InventoryQueries::DATA_VERSION);
+    if (!stmt) return -1;
+    StatementReset reset(stmt);
+
+    if (sqlite3_step(stmt) != SQLITE_ROW) return -1;
+    return sqlite3_column_int64(stmt, 0);
+}
+
+bool InventoryStore::inTransaction(const std::function<void()>& body) {
+    if (!db_) return false;
+
+    WriteTransaction transaction(db_);
+    if (!transaction.ok()) return false;
+
+    body();
+    return transaction.commit();
+}
+
+std::string InventoryStore::search(const std::string& query, int limit) {
+    std::string out;
+    JsonWriter json = JsonWriter::toString(out);
+    if (!writeSearch(query, limit, json)) return "{\"error\": \"Failed to search inventory\"}";
+    json.flush();
+    return out;
+}
+
+bool InventoryStore::writeSearch(const std::string& query, int limit, JsonWriter& json) {
+    std::string match = matchExpression(query);
+    if (match.empty()) {
+        json.beginArray();
+        json.endArray();
+        return true;
+    }
+
+    sqlite3_stmt* stmt = statement(InventoryQueries::SEARCH);
+    if (!stmt) return false;
+    StatementReset reset(stmt);
+
+    sqlite3_bind_text(stmt, 1, match.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int (stmt, 2, limit);
+
+    json.beginArray();
+    while (sqlite3_step(stmt) == SQLITE_ROW && json.ok()) {
+        writeItem(json, stmt);
+    }
+    json.endArray();
+    return true;
+}
+
+// Inserts a new item — returns true on success
+bool InventoryStore::addItem(const std::string& name, const std::string& barcode,
+                             int quantity, const std::string& bestBefore) {
+    return upsertItem(name, barcode, quantity, bestBefore) > 0;
+}
+
+// Adds to the matching row or inserts a new one in a single statement,
+// so concurrent adds from the UI, scanner and camera can't lose updates
+int InventoryStore::upsertItem(const std::string& name, const std::string& barcode,
+                               int quantity, const std::string& bestBefore,
+                               const std::string& dateAdded) {
+    // Get current date as YYYY-MM-DD, unless the row brings its own
+    char dateBuf[11];
+    if (dateAdded.empty()) {
+        time_t now = time(nullptr);
+        strftime(dateBuf, sizeof(dateBuf), "%Y-%m-%d", localtime(&now));
+    }
+    const char* added = dateAdded.empty() ? dateBuf : dateAdded.c_str();
+
+    // "12/10/26" and "2026-10-12" are the same date, and the same row
+    BestBefore date;
+    bool dated = BestBefore::parse(bestBefore, date);
+    const std::string& bestBeforeText = dated ? date.date : bestBefore;
+
+    sqlite3_stmt* stmt = statement(InventoryQueries::UPSERT);
+    if (!stmt) return -1;
+    StatementReset reset(stmt);
+
+    sqlite3_bind_text(stmt, 1, name.c_str(),    -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, barcode.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int (stmt, 3, quantity);
+    sqlite3_bind_text(stmt, 4, added,           -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 5, bestBeforeText.c_str(), -1, SQLITE_STATIC);
+    if (dated) sqlite3_bind_int64(stmt, 6, date.days);
+    else       sqlite3_bind_null (stmt, 6);
+
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        std::cerr << "[inventory] Upsert failed: " << sqlite3_errmsg(db_) << "\n";
+        return -1;
+    }
+    return sqlite3_column_int(stmt, 0);
+}
+
+// Name of an item already stocked under this barcode, or "" if none
+std::string InventoryStore::nameForBarcode(const std::string& barcode) {
+    sqlite3_stmt* stmt = statement(InventoryQueries::NAME_FOR_BARCODE);
+    if (!stmt) return "";
+    StatementReset reset(stmt);
+
+    sqlite3_bind_text(stmt, 1, barcode.c_str(), -1, SQLITE_STATIC);
+    if (sqlite3_step(stmt) != SQLITE_ROW) return "";
+
+    const char* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    return name ? name : "";
+}
+
+// Deletes an item by id — returns true on success
+bool InventoryStore::deleteItem(int id) {
+    sqlite3_stmt* stmt = statement(InventoryQueries::DELETE_ITEM);
+    if (!stmt) return false;
+    StatementReset reset(stmt);
+
+    sqlite3_bind_int(stmt, 1, id);
+    return sqlite3_step(stmt) == SQLITE_DONE;
+}
+
+bool InventoryStore::decrementItem(int id) {
+    // Decrement and delete-at-zero commit together, so a concurrent
+    // increment can't land between them and be deleted with the row
+    WriteTransaction transaction(db_);
+    if (!transaction.ok()) return false;
+
+    int qty = 0;
+    {
+        sqlite3_stmt* stmt = statement(InventoryQueries::DECREMENT_ITEM);
+        if (!stmt) return false;
+        StatementReset reset(stmt);
+
+        sqlite3_bind_int(stmt, 1, id);
+        if (sqlite3_step(stmt) != SQLITE_ROW) return false;
+        qty = sqlite3_column_int(stmt, 0);
+    }
+
+    if (qty <= 0) {
+        // quantity hit 0 — delete the row entirely
+        if (!deleteItem(id)) return false;
+    }
+
+    return transaction.commit();
+}
+
+// Increments quantity by 1
+bool InventoryStore::incrementItem(int id) {
+    sqlite3_stmt* stmt = statement(InventoryQueries::INCREMENT_ITEM);
+    if (!stmt) return false;
+    StatementReset reset(stmt);
+
+    sqlite3_bind_int(stmt, 1, id);
+    return (sqlite3_step(stmt) == SQLITE_DONE) && (sqlite3_changes(db_) > 0);
+}
+
+// Updates an item
+bool InventoryStore::updateItem(int id, const std::string& name, const std::string& barcode,
+                                int quantity, const std::string& bestBefore) {
+    BestBefore date;
+    bool dated = BestBefore::parse(bestBefore, date);
+    const std::string& bestBeforeText = dated ? date.date : bestBefore;
+
+    sqlite3_stmt* stmt = statement(InventoryQueries::UPDATE_ITEM);
+    if (!stmt) return false;
+    StatementReset reset(stmt);
+
+    sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, barcode.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 3, quantity);
+    sqlite3_bind_text(stmt, 4, bestBeforeText.c_str(), -1, SQLITE_STATIC);
+    if (dated) sqlite3_bind_int64(stmt, 5, date.days);
+    else       sqlite3_bind_null (stmt, 5);
+    sqlite3_bind_int(stmt, 6, id);
+
+    return (sqlite3_step(stmt) == SQLITE_DONE) && (sqlite3_changes(db_) > 0);
+}
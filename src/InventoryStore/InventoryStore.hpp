@@ -0,0 +1,299 @@
+#pragma once
+
+#include "JsonWriter.hpp"
+
+#include <sqlite3.h>
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** One inventory row, as read for InventoryCache. */
+struct InventoryItem {
+    long long   id = 0;
+    std::string name;
+    std::string barcode;
+    long long   quantity = 0;
+    std::string dateAdded;
+    std::string bestBefore;
+    long long   bestBeforeDays = -1;   ///< best_before as a BestBefore day number; -1 if undated
+    long long   changed = 0;   ///< Version of its last change, or the log horizon if older
+};
+
+/** What readChangesSince() found: the rows to replace and the ids to drop. */
+struct InventoryChanges {
+    long long version = 0;
+    long long horizon = 0;
+    bool      full = false;                                  ///< items is the whole table
+    std::vector<InventoryItem> items;                         ///< Added or changed
+    std::vector<std::pair<long long, long long>> deleted;     ///< (id, version), oldest first
+};
+
+/**
+ * @brief Long-lived SQLite connection for the inventory database.
+ *
+ * The connection is opened (in WAL mode) and migrated to SCHEMA_VERSION
+ * once, then kept for the lifetime of the process. Every statement is
+ * prepared the first time it is used and cached by its SQL text; later
+ * calls only reset and rebind it.
+ *
+ * Every change in quantity made through the store is appended to
+ * inventory_events with the store's source ("ui", "barcode", "camera"),
+ * by temporary triggers this connection installs when it opens.
+ *
+ * Not thread-safe: one InventoryStore per thread. Each FastCGI worker owns
+ * its own store, and WAL mode keeps their readers from blocking on a writer.
+ *
+ * Usage:
+ * @code
+ *   InventoryStore store("/var/lib/pifridge/inventory.db");
+ *   if (store.open()) {
+ *       std::string json = store.getAllItems();
+ *   }
+ * @endcode
+ */
+class InventoryStore {
+public:
+    /**
+     * @param dbPath Path to the SQLite database file.
+     * @param source Recorded with this store's inventory events; letters,
+     *               digits and '_' only (others are dropped).
+     */
+    explicit InventoryStore(std::string dbPath, std::string source = "other");
+    ~InventoryStore();
+
+    InventoryStore(const InventoryStore&) = delete;
+    InventoryStore& operator=(const InventoryStore&) = delete;
+
+    /**
+     * @brief Open the connection and run any pending schema migrations.
+     *
+     * Safe to call again after a failure; does nothing if already open.
+     *
+     * @return true if the connection is usable.
+     */
+    bool open();
+
+    /** @brief Finalize every cached statement and close the connection. */
+    void close();
+
+    bool isOpen() const { return db_ != nullptr; }
+
+    /**
+     * @brief Return the inventory change counter.
+     *
+     * Bumped by trigger on every insert, update and delete from any
+     * connection, so equal versions mean identical table contents.
+     *
+     * @return The current version, or -1 on error.
+     */
+    long long version();
+
+    /** @brief Return all items as a JSON array, newest first. */
+    std::string getAllItems();
+
+    /**
+     * @brief Stream all items into @p json as rows come out of the query.
+     *
+     * Memory use does not grow with the number of items. The caller flushes.
+     *
+     * @return false if the query could not be started; nothing is written then.
+     */
+    bool writeAllItems(JsonWriter& json);
+
+    /**
+     * @brief Call @p visit with every item in id order, one row at a time.
+     *
+     * Reads in one statement, so the items are a consistent snapshot, and
+     * only the current row is held. Stops early if @p visit returns false.
+     *
+     * @return false if the query failed.
+     */
+    bool forEachItem(const std::function<bool(const InventoryItem&)>& visit);
+
+    /**
+     * @brief Return what changed after version @p since.
+     *
+     * Reads the change log in one snapshot, so the returned version matches
+     * the changes exactly:
+     * @code
+     *   {"version":12,"full":false,"changes":[{...item...},{"id":7,"deleted":true}]}
+     * @endcode
+     * If @p since is older than the compacted log reaches back (or negative),
+     * the answer is the whole table instead, with "full":true and "items".
+     */
+    std::string getChangesSince(long long since);
+
+    /** @brief Streaming form of getChangesSince(); see writeAllItems(). */
+    bool writeChangesSince(long long since, JsonWriter& json);
+
+    /**
+     * @brief Return up to @p limit items matching @p query, best match first.
+     *
+     * Each word of @p query must match the start of a word in the item's
+     * name or barcode, so "fr egg" finds "Free Range Eggs". Whole-word
+     * matches rank above prefix-only ones, and name matches above barcode
+     * matches. Backed by the inventory_search FTS5 index.
+     *
+     * @return A JSON array; empty if @p query has no words.
+     */
+    std::string search(const std::string& query, int limit);
+
+    /** @brief Streaming form of search(); see writeAllItems(). */
+    bool writeSearch(const std::string& query, int limit, JsonWriter& json);
+
+    /**
+     * @brief Return dated items that expire by day @p today + @p withinDays,
+     *        soonest first, including ones already past.
+     *
+     * Each item is written as in the listing plus "days_left" (negative
+     * once expired). A range scan of the inventory_expiry index.
+     */
+    std::string getExpiring(long long today, int withinDays);
+
+    /** @brief Streaming form of getExpiring(); see writeAllItems(). */
+    bool writeExpiring(long long today, int withinDays, JsonWriter& json);
+
+    /**
+     * @brief Fold events not yet rolled up into the inventory_daily totals.
+     *
+     * Incremental: only events after the last roll-up are read. Raw events
+     * older than RAW_EVENT_DAYS are then dropped; their days stay in
+     * inventory_daily. A no-op read when nothing is pending.
+     *
+     * @return false on error; nothing is changed then.
+     */
+    bool rollUpHistory();
+
+    /**
+     * @brief Return daily added/removed totals from @p from to @p to
+     *        (YYYY-MM-DD, inclusive), optionally for one item @p name.
+     *
+     * Answered from inventory_daily alone, so only rolled-up events count;
+     * call rollUpHistory() first for an up-to-date answer:
+     * @code
+     *   {"from":"2026-10-01","to":"2026-10-07","days":[
+     *     {"day":"2026-10-03",
+     *      "sources":{"barcode":{"added":2,"removed":0},"ui":{"added":1,"removed":1}},
+     *      "added":3,"removed":1}]}
+     * @endcode
+     * Days with no events are left out.
+     */
+    std::string getHistory(const std::string& from, const std::string& to, const std::string& name = "");
+
+    /** @brief Streaming form of getHistory(); see writeAllItems(). */
+    bool writeHistory(const std::string& from, const std::string& to, const std::string& name,
+                      JsonWriter& json);
+
+    /**
+     * @brief Read what changed after version @p since into @p out.
+     *
+     * Same snapshot and rules as getChangesSince(), as structs rather than
+     * JSON. A full answer also lists the tombstones still in the log, so a
+     * copy built from it can answer later deltas itself.
+     */
+    bool readChangesSince(long long since, InventoryChanges& out);
+
+    /**
+     * @brief PRAGMA data_version: differs from the last call once another
+     *        connection (any process) has committed.
+     *
+     * Answered from the WAL index in shared memory, not the database file.
+     *
+     * @return The value, or -1 on error.
+     */
+    long long dataVersion();
+
+    /**
+     * @brief Run @p body inside one write transaction.
+     *
+     * Store calls made from @p body join it, so N writes cost one commit
+     * (and one WAL sync) instead of N, and other connections see them all
+     * at once. Each call stays atomic on its own: one that fails is undone
+     * without affecting the rest. Whatever succeeded is committed when
+     * @p body returns.
+     *
+     * @return false if the transaction could not be started or committed;
+     *         nothing is applied then.
+     */
+    bool inTransaction(const std::function<void()>& body);
+
+    /**
+     * @brief Add @p quantity of an item, merging with an existing row.
+     *
+     * Rows are unique on (name case-insensitively, barcode, best_before);
+     * adding one that exists raises its quantity instead of inserting.
+     * A @p bestBefore that BestBefore::parse() reads is stored as
+     * YYYY-MM-DD with its best_before_days; anything else is kept as given.
+     * One INSERT ... ON CONFLICT DO UPDATE statement, so it is atomic
+     * against the scanner, camera and other workers.
+     *
+     * @param dateAdded YYYY-MM-DD for a new row; today if empty. An
+     *                  existing row keeps its own.
+     * @return The row's quantity afterwards, or -1 on error.
+     */
+    int upsertItem(const std::string& name, const std::string& barcode,
+                   int quantity, const std::string& bestBefore,
+                   const std::string& dateAdded = "");
+
+    /**
+     * @brief Return the name of an item stocked under @p barcode.
+     *
+     * Lets the scanner skip the OpenFoodFacts request for a product it has
+     * seen before. An index-only lookup.
+     *
+     * @return The name, or "" if no row has that barcode.
+     */
+    std::string nameForBarcode(const std::string& barcode);
+
+    /** @brief upsertItem() that only reports success. */
+    bool addItem(const std::string& name, const std::string& barcode,
+                 int quantity, const std::string& bestBefore);
+    bool deleteItem(int id);
+
+    /** @brief Reduce quantity by 1, deleting the row when it reaches 0, in one transaction. */
+    bool decrementItem(int id);
+    bool incrementItem(int id);
+
+    /** @brief Replace an item's fields; @p bestBefore is normalised as in upsertItem(). */
+    bool updateItem(int id, const std::string& name, const std::string& barcode,
+                    int quantity, const std::string& bestBefore);
+
+    /** Schema version stored in PRAGMA user_version once migrations have run. */
+    static constexpr int SCHEMA_VERSION = 8;
+
+    /** Deletions kept in the change log before older ones are compacted away. */
+    static constexpr int MAX_TOMBSTONES = 1000;
+
+    /** Days raw inventory events are kept once rolled up. */
+    static constexpr int RAW_EVENT_DAYS = 90;
+
+private:
+    /** Bring the schema up to SCHEMA_VERSION; a no-op read when it already is. */
+    bool migrate();
+    bool applyMigration(int step);
+    int userVersion();
+    bool exec(const char* sql);
+
+    /** Create this connection's temporary triggers that record events. */
+    bool installEventTriggers();
+
+    /** @return 1 if the column was added, 0 if it already existed, -1 on error. */
+    int addColumnIfMissing(const char* table, const char* columnDef);
+
+    /**
+     * @brief Return the cached statement for @p sql, preparing it on first use.
+     *
+     * Cached by the pointer, not the text, so a hit is one pointer hash:
+     * pass an InventoryQueries constant, never a built string.
+     *
+     * @return nullptr if the statement cannot be prepared.
+     */
+    sqlite3_stmt* statement(const char* sql);
+
+    std::string dbPath_;
+    std::string source_;
+    sqlite3* db_ = nullptr;
+    std::unordered_map<const char*, sqlite3_stmt*> statements_;   // by InventoryQueries pointer
+};
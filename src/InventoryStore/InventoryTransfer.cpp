@@ -0,0 +1,315 @@
+#include "InventoryTransfer.hpp"
+
+#include "BestBefore.hpp"
+#include "InventoryCache.hpp"
+#include "JsonView.hpp"
+
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+const char CSV_HEADER[] = "id,name,barcode,quantity,date_added,best_before\r\n";
+
+// UTF-8 byte-order mark, which spreadsheet programs put before a CSV
+const std::string_view BYTE_ORDER_MARK = "\xEF\xBB\xBF";
+
+// Writes @p text as one CSV field, quoted (with quotes doubled) only if it
+// holds a separator, quote or line break
+void writeCsvField(JsonWriter& out, std::string_view text) {
+    if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out.raw(text);
+        return;
+    }
+    out.raw("\"");
+    for (size_t quote; (quote = text.find('"')) != std::string_view::npos; text.remove_prefix(quote + 1)) {
+        out.raw(text.substr(0, quote + 1));
+        out.raw("\"");
+    }
+    out.raw(text);
+    out.raw("\"");
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back())))  text.remove_suffix(1);
+    return text;
+}
+
+} // namespace
+
+bool InventoryTransfer::parseFormat(std::string_view name, Format& format) {
+    if (name == "ndjson") format = Format::Ndjson;
+    else if (name == "csv") format = Format::Csv;
+    else return false;
+    return true;
+}
+
+const char* InventoryTransfer::contentType(Format format) {
+    return format == Format::Csv ? "text/csv; charset=utf-8" : "application/x-ndjson";
+}
+
+const char* InventoryTransfer::extension(Format format) {
+    return format == Format::Csv ? "csv" : "ndjson";
+}
+
+bool InventoryTransfer::writeExport(InventoryStore& store, Format format, JsonWriter& out) {
+    if (format == Format::Ndjson) {
+        return store.forEachItem([&out](const InventoryItem& item) {
+            InventoryCache::writeItem(out, item);
+            out.endLine();
+            return out.ok();
+        });
+    }
+
+    out.raw(CSV_HEADER);
+    return store.forEachItem([&out](const InventoryItem& item) {
+        out.raw(std::to_string(item.id));        out.raw(",");
+        writeCsvField(out, item.name);           out.raw(",");
+        writeCsvField(out, item.barcode);        out.raw(",");
+        out.raw(std::to_string(item.quantity));  out.raw(",");
+        writeCsvField(out, item.dateAdded);      out.raw(",");
+        writeCsvField(out, item.bestBefore);     out.raw("\r\n");
+        return out.ok();
+    });
+}
+
+InventoryImporter::InventoryImporter(InventoryStore& store, InventoryTransfer::Format format)
+    : store_(store), format_(format) {
+    pending_.reserve(IMPORT_BATCH_ROWS);
+}
+
+bool InventoryImporter::feed(const char* data, size_t size) {
+    if (failure_) return false;
+    if (format_ == InventoryTransfer::Format::Csv) feedCsv(data, size);
+    else feedNdjson(data, size);
+    return !failure_;
+}
+
+bool InventoryImporter::finish() {
+    if (failure_) return false;
+    if (format_ == InventoryTransfer::Format::Csv) {
+        if (inQuotes_) {
+            ++rows_;
+            reject(rows_, "unterminated quote");
+        } else if (!field_.empty() || !fields_.empty() || tooLong_) {
+            endCsvRow();
+        }
+    } else if (!field_.empty() || tooLong_) {
+        endNdjsonRow();
+    }
+    return commit();
+}
+
+void InventoryImporter::writeResult(JsonWriter& json) const {
+    json.beginObject();
+    json.key("imported"); json.value(static_cast<long long>(imported_));
+    json.key("rejected"); json.value(static_cast<long long>(rejected_));
+    json.key("errors");
+    json.beginArray();
+    for (const auto& error : errors_) {
+        json.beginObject();
+        json.key("row");   json.value(static_cast<long long>(error.first));
+        json.key("error"); json.value(error.second);
+        json.endObject();
+    }
+    json.endArray();
+    if (failure_) { json.key("error"); json.value(failure_); }
+    json.endObject();
+}
+
+// Lines are copied in runs up to each '\n'. A line past MAX_ROW_BYTES is
+// dropped as it arrives and only remembered as too long.
+void InventoryImporter::feedNdjson(const char* data, size_t size) {
+    while (size > 0 && !failure_) {
+        const char* newline = static_cast<const char*>(std::memchr(data, '\n', size));
+        size_t run = newline ? static_cast<size_t>(newline - data) : size;
+
+        if (!tooLong_ && field_.size() + run > MAX_ROW_BYTES) {
+            tooLong_ = true;
+            field_.clear();
+        }
+        if (!tooLong_) field_.append(data, run);
+
+        if (!newline) return;
+        endNdjsonRow();
+        data += run + 1;
+        size -= run + 1;
+    }
+}
+
+void InventoryImporter::endNdjsonRow() {
+    std::string_view line = field_;
+    if (firstRow_ && line.substr(0, BYTE_ORDER_MARK.size()) == BYTE_ORDER_MARK) {
+        line.remove_prefix(BYTE_ORDER_MARK.size());
+    }
+    firstRow_ = false;
+    line = trim(line);
+
+    if (!line.empty() || tooLong_) {
+        ++rows_;
+        JsonView item = tooLong_ ? JsonView() : JsonView::parse(line);
+        if (tooLong_) {
+            reject(rows_, "row too long");
+        } else if (item.type() != JsonView::Type::Object) {
+            reject(rows_, "not a JSON object");
+        } else {
+            addRow(item["name"].asString(), item["barcode"].asString(), item["quantity"].asString(),
+                   item["date_added"].asString(), item["best_before"].asString());
+        }
+    }
+
+    field_.clear();
+    tooLong_ = false;
+}
+
+// RFC 4180, read a byte at a time so a record can break anywhere between
+// chunks. Quoted fields may hold separators, doubled quotes and line
+// breaks; '\r' outside quotes is dropped, so CRLF and LF both end a record.
+void InventoryImporter::feedCsv(const char* data, size_t size) {
+    for (size_t i = 0; i < size && !failure_; ++i) {
+        char c = data[i];
+
+        if (inQuotes_) {
+            if (c == '"') {
+                inQuotes_ = false;
+                afterQuote_ = true;
+                continue;
+            }
+        } else if (c == '"' && (afterQuote_ || field_.empty())) {
+            // An opening quote, or the second of a doubled one
+            if (afterQuote_) field_ += '"';
+            inQuotes_ = true;
+            afterQuote_ = false;
+            continue;
+        } else if (c == ',') {
+            endCsvField();
+            continue;
+        } else if (c == '\n') {
+            endCsvRow();
+            continue;
+        } else if (c == '\r') {
+            continue;
+        }
+
+        afterQuote_ = false;
+        if (++rowBytes_ > MAX_ROW_BYTES) tooLong_ = true;
+        if (!tooLong_) field_ += c;
+    }
+}
+
+void InventoryImporter::endCsvField() {
+    afterQuote_ = false;
+    if (!tooLong_) fields_.push_back(std::move(field_));
+    field_.clear();
+}
+
+void InventoryImporter::endCsvRow() {
+    endCsvField();
+
+    if (firstRow_) {
+        firstRow_ = false;
+        if (!fields_.empty() && fields_[0].compare(0, BYTE_ORDER_MARK.size(), BYTE_ORDER_MARK) == 0) {
+            fields_[0].erase(0, BYTE_ORDER_MARK.size());
+        }
+
+        static const char* const NAMES[] = { "name", "barcode", "quantity", "date_added", "best_before" };
+        bool hasName = false;
+        for (const std::string& header : fields_) {
+            std::string name(trim(header));
+            for (char& c : name) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+
+            Column column = COLUMN_IGNORED;
+            for (int i = 0; i < COLUMN_IGNORED; ++i) {
+                if (name == NAMES[i]) column = static_cast<Column>(i);
+            }
+            hasName = hasName || column == COLUMN_NAME;
+            columns_.push_back(column);
+        }
+        if (!hasName) failure_ = "CSV header has no name column";
+    } else if (tooLong_) {
+        reject(++rows_, "row too long");
+    } else if (fields_.size() > 1 || !trim(fields_[0]).empty()) {
+        // A blank line is one empty field
+        std::string values[COLUMN_IGNORED];
+        for (size_t i = 0; i < fields_.size() && i < columns_.size(); ++i) {
+            if (columns_[i] != COLUMN_IGNORED) values[columns_[i]] = std::move(fields_[i]);
+        }
+        ++rows_;
+        addRow(std::move(values[COLUMN_NAME]), std::move(values[COLUMN_BARCODE]), values[COLUMN_QUANTITY],
+               std::move(values[COLUMN_DATE_ADDED]), std::move(values[COLUMN_BEST_BEFORE]));
+    }
+
+    fields_.clear();
+    rowBytes_ = 0;
+    tooLong_ = false;
+}
+
+void InventoryImporter::addRow(std::string name, std::string barcode, std::string_view quantity,
+                               std::string dateAdded, std::string bestBefore) {
+    if (trim(name).empty()) {
+        reject(rows_, "missing name");
+        return;
+    }
+
+    long long count = 1;
+    quantity = trim(quantity);
+    if (!quantity.empty()) {
+        std::string digits(quantity);
+        char* end = nullptr;
+        count = std::strtoll(digits.c_str(), &end, 10);
+        if (*end != '\0' || count <= 0 || count > INT_MAX) {
+            reject(rows_, "invalid quantity");
+            return;
+        }
+    }
+
+    // Kept as the exporting fridge had it; today if absent
+    if (!dateAdded.empty()) {
+        BestBefore date;
+        if (!BestBefore::parse(dateAdded, date)) {
+            reject(rows_, "invalid date_added");
+            return;
+        }
+        dateAdded = date.date;
+    }
+
+    pending_.push_back({ rows_, std::move(name), std::move(barcode), static_cast<int>(count),
+                         std::move(dateAdded), std::move(bestBefore) });
+    if (pending_.size() >= IMPORT_BATCH_ROWS) commit();
+}
+
+void InventoryImporter::reject(size_t row, const char* error) {
+    ++rejected_;
+    if (errors_.size() < MAX_REPORTED_ERRORS) errors_.emplace_back(row, error);
+}
+
+// One transaction per batch: a row whose upsert fails is rejected on its
+// own, but if the batch cannot be committed none of it was imported
+bool InventoryImporter::commit() {
+    if (pending_.empty()) return true;
+
+    size_t written = 0;
+    std::vector<std::pair<size_t, const char*>> failed;
+    bool committed = store_.inTransaction([&] {
+        for (const PendingRow& row : pending_) {
+            if (store_.upsertItem(row.name, row.barcode, row.quantity, row.bestBefore, row.dateAdded) > 0) {
+                ++written;
+            } else {
+                failed.emplace_back(row.row, "insert failed");
+            }
+        }
+    });
+
+    if (committed) {
+        imported_ += written;
+        for (const auto& row : failed) reject(row.first, row.second);
+    } else {
+        rejected_ += pending_.size();
+        failure_ = "database write failed";
+    }
+    pending_.clear();
+    return committed;
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "InventoryStore.hpp"
+#include "JsonWriter.hpp"
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Whole-inventory export as NDJSON or CSV.
+ *
+ * NDJSON is one item object per line, written as in the listing. CSV has
+ * the header row id,name,barcode,quantity,date_added,best_before and
+ * quotes fields that need it as RFC 4180 does. Rows are written in id
+ * order as SQLite returns them, through the writer's fixed buffer, so
+ * exporting 100,000 items uses no more memory than exporting 10.
+ *
+ * Usage:
+ * @code
+ *   InventoryTransfer::Format format;
+ *   if (InventoryTransfer::parseFormat("csv", format)) {
+ *       InventoryTransfer::writeExport(store, format, json);
+ *       json.flush();
+ *   }
+ * @endcode
+ */
+struct InventoryTransfer {
+    enum class Format { Ndjson, Csv };
+
+    /** "ndjson" or "csv". @return false for anything else. */
+    static bool parseFormat(std::string_view name, Format& format);
+
+    /** MIME type for a response body in @p format. */
+    static const char* contentType(Format format);
+
+    /** File extension, without the dot, for a download in @p format. */
+    static const char* extension(Format format);
+
+    /**
+     * @brief Write every item in @p format to @p out. The caller flushes.
+     * @return false if the items could not be read.
+     */
+    static bool writeExport(InventoryStore& store, Format format, JsonWriter& out);
+};
+
+/**
+ * @brief Imports an NDJSON or CSV body fed in chunks of any size.
+ *
+ * A row may span chunks; only the row being parsed is held, and rows are
+ * written IMPORT_BATCH_ROWS at a time, each batch in one transaction, so
+ * memory stays flat however large the body is and other writers wait at
+ * most one batch for the lock.
+ *
+ * Rows take the export's fields, in any order for CSV (matched by header
+ * name). Only name is required; quantity defaults to 1 and date_added to
+ * today, and id is ignored. Each row is added with
+ * InventoryStore::upsertItem(), so it merges with a matching item rather
+ * than replacing it: importing an export into an empty database recreates
+ * it, importing it twice doubles every quantity. A row that cannot be read
+ * is skipped and reported without stopping the import.
+ *
+ * Usage:
+ * @code
+ *   InventoryImporter importer(store, InventoryTransfer::Format::Csv);
+ *   while (int n = FCGX_GetStr(chunk, sizeof(chunk), request.in)) {
+ *       if (!importer.feed(chunk, n)) break;
+ *   }
+ *   importer.finish();
+ *   importer.writeResult(json);
+ * @endcode
+ */
+class InventoryImporter {
+public:
+    InventoryImporter(InventoryStore& store, InventoryTransfer::Format format);
+
+    InventoryImporter(const InventoryImporter&) = delete;
+    InventoryImporter& operator=(const InventoryImporter&) = delete;
+
+    /**
+     * @brief Parse the next @p size bytes of the body.
+     * @return false once the import has failed; later input is ignored.
+     */
+    bool feed(const char* data, size_t size);
+
+    /**
+     * @brief Take a last row without a line ending and write what is left.
+     * @return false if the import failed.
+     */
+    bool finish();
+
+    size_t imported() const { return imported_; }
+    size_t rejected() const { return rejected_; }
+
+    /**
+     * @brief Write the outcome:
+     * @code
+     *   {"imported":998,"rejected":2,"errors":[{"row":17,"error":"missing name"},...]}
+     * @endcode
+     * plus "error" if the import stopped early. Rows count from 1, not
+     * counting the CSV header or blank lines.
+     */
+    void writeResult(JsonWriter& json) const;
+
+    /**
+     * Rows written per transaction. Larger batches barely speed up an
+     * import (the search index and change log dominate each row) but hold
+     * the write lock longer, which the scanner and camera wait behind.
+     */
+    static constexpr size_t IMPORT_BATCH_ROWS = 200;
+
+    /** Longest row accepted, in bytes; longer ones are rejected. */
+    static constexpr size_t MAX_ROW_BYTES = 16 * 1024;
+
+    /** Rejected rows listed in writeResult(); the rest are only counted. */
+    static constexpr size_t MAX_REPORTED_ERRORS = 20;
+
+private:
+    // CSV columns, as named in the header row
+    enum Column { COLUMN_NAME, COLUMN_BARCODE, COLUMN_QUANTITY, COLUMN_DATE_ADDED, COLUMN_BEST_BEFORE,
+                  COLUMN_IGNORED };
+
+    struct PendingRow {
+        size_t row;
+        std::string name;
+        std::string barcode;
+        int quantity;
+        std::string dateAdded;
+        std::string bestBefore;
+    };
+
+    void feedNdjson(const char* data, size_t size);
+    void feedCsv(const char* data, size_t size);
+    void endCsvField();
+
+    /** A complete line or record has been read. */
+    void endNdjsonRow();
+    void endCsvRow();
+
+    /** Check one row's values and queue it. */
+    void addRow(std::string name, std::string barcode, std::string_view quantity,
+                std::string dateAdded, std::string bestBefore);
+    void reject(size_t row, const char* error);
+
+    /** Write the queued rows in one transaction. */
+    bool commit();
+
+    InventoryStore& store_;
+    InventoryTransfer::Format format_;
+
+    std::string field_;                 // NDJSON line, or the CSV field being read
+    std::vector<std::string> fields_;   // CSV fields of the record so far
+    size_t rowBytes_ = 0;
+    bool tooLong_ = false;
+    bool inQuotes_ = false;
+    bool afterQuote_ = false;           // a closing quote, unless another follows
+    bool firstRow_ = true;              // strip a byte-order mark; for CSV, the header
+    std::vector<Column> columns_;
+
+    std::vector<PendingRow> pending_;
+    size_t rows_ = 0;
+    size_t imported_ = 0;
+    size_t rejected_ = 0;
+    std::vector<std::pair<size_t, const char*>> errors_;
+    const char* failure_ = nullptr;
+};
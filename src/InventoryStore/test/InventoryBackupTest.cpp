@@ -0,0 +1,167 @@
+// InventoryBackupTest.cpp
+// Checks that InventoryBackup copies the database it started from while
+// another connection keeps writing between its steps, that the copy is a
+// whole database, that only the newest backups are kept, and that a failed
+// backup leaves nothing behind.
+
+#include "../InventoryBackup.hpp"
+#include "../InventoryStore.hpp"
+#include "JsonView.hpp"
+
+#include <sqlite3.h>
+
+#include <cstdio>
+#include <dirent.h>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+static const char* TEST_DB_PATH    = "/tmp/pifridge_inventory_backup_test.db";
+static const char* TEST_BACKUP_DIR = "/tmp/pifridge_inventory_backup_test";
+
+static void expectTrue(bool condition, const std::string& message, int& failures) {
+    if (!condition) {
+        std::cout << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+static void expectEqual(const std::string& actual, const std::string& expected,
+                        const std::string& message, int& failures) {
+    if (actual != expected) {
+        std::cout << "FAIL: " << message
+                  << " expected \"" << expected
+                  << "\" got \"" << actual << "\"\n";
+        ++failures;
+    }
+}
+
+// First column of the first row of @p sql on the database at @p path
+static std::string scalar(const std::string& path, const char* sql) {
+    sqlite3* db = nullptr;
+    sqlite3_stmt* stmt = nullptr;
+    std::string out;
+    if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK &&
+        sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        out = text ? text : "";
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return out;
+}
+
+static std::vector<std::string> listDir() {
+    std::vector<std::string> names;
+    if (DIR* dir = opendir(TEST_BACKUP_DIR)) {
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') names.emplace_back(entry->d_name);
+        }
+        closedir(dir);
+    }
+    return names;
+}
+
+static void clearDir() {
+    for (const std::string& name : listDir()) std::remove((std::string(TEST_BACKUP_DIR) + "/" + name).c_str());
+    rmdir(TEST_BACKUP_DIR);
+}
+
+static void touch(const std::string& name) {
+    std::fclose(std::fopen((std::string(TEST_BACKUP_DIR) + "/" + name).c_str(), "w"));
+}
+
+static std::string status(const InventoryBackup& backup) {
+    std::string out;
+    JsonWriter json = JsonWriter::toString(out);
+    backup.writeStatus(json);
+    json.flush();
+    return out;
+}
+
+int main() {
+    int failures = 0;
+
+    std::remove(TEST_DB_PATH);
+    clearDir();
+
+    InventoryStore store(TEST_DB_PATH);
+    expectTrue(store.open(), "store should open", failures);
+    store.inTransaction([&] {
+        for (int i = 0; i < 5000; ++i) {
+            store.addItem("Item " + std::to_string(i) + " with a longer name", std::to_string(5000000 + i), 1, "");
+        }
+    });
+
+    // Older backups, one of which should survive rotation, and a file
+    // that is not a backup at all
+    mkdir(TEST_BACKUP_DIR, 0755);
+    touch("inventory-20200101-000000.db");
+    touch("inventory-20200101-000001.db");
+    touch("notes.txt");
+
+    // Writes from another connection between every step
+    InventoryStore writer(TEST_DB_PATH);
+    writer.open();
+    int steps = 0;
+    long long lastDone = -1;
+    bool monotonic = true;
+    InventoryBackup backup(TEST_DB_PATH, TEST_BACKUP_DIR, 2);
+    bool ok = backup.backupNow([&](long long done, long long total) {
+        monotonic = monotonic && done > lastDone && done <= total;
+        lastDone = done;
+        ++steps;
+        writer.addItem("During " + std::to_string(steps), "", 1, "");
+    });
+    expectTrue(ok, "backup should succeed", failures);
+    expectTrue(steps > 1, "backup should take several steps", failures);
+    expectTrue(monotonic, "progress should only move forward, without restarting", failures);
+
+    std::string stateJson = status(backup);
+    JsonView state = JsonView::parse(stateJson);
+    expectTrue(!state["running"].asBool(true) && state["completed"].asInt(0) == 1 &&
+               state["pages_done"].asInt(0) == state["pages_total"].asInt(-1) &&
+               state["last_error"].type() == JsonView::Type::Null,
+               "status should show one complete backup", failures);
+
+    std::string file = state["last_file"].asString();
+    expectEqual(scalar(file, "PRAGMA integrity_check;"), "ok", "backup should be a whole database", failures);
+    expectEqual(scalar(file, "SELECT COUNT(*) FROM inventory;"), "5000",
+                "backup should hold the rows as they were when it started", failures);
+    expectEqual(scalar(file, "PRAGMA user_version;"), std::to_string(InventoryStore::SCHEMA_VERSION),
+                "backup should keep the schema version", failures);
+
+    std::vector<std::string> names = listDir();
+    std::string kept;
+    for (const std::string& name : names) kept += name + " ";
+    expectTrue(names.size() == 3 && kept.find("inventory-20200101-000001.db") != std::string::npos &&
+               kept.find("notes.txt") != std::string::npos &&
+               kept.find(file.substr(file.rfind('/') + 1)) != std::string::npos,
+               "rotation should keep the newest two backups and other files: " + kept, failures);
+
+    // Nothing to back up: no file, and the error is reported
+    InventoryBackup missing("/tmp/pifridge_no_such_dir/inventory.db", TEST_BACKUP_DIR);
+    expectTrue(!missing.backupNow(), "backup of a missing database should fail", failures);
+    std::string failedJson = status(missing);
+    JsonView failed = JsonView::parse(failedJson);
+    expectTrue(failed["failed"].asInt(0) == 1 && !failed["last_error"].asString().empty(),
+               "failure should be in the status", failures);
+    expectTrue(listDir().size() == 3, "a failed backup should leave no file", failures);
+
+    // request() only works once the thread is running
+    expectTrue(!missing.request(), "request without a thread should be refused", failures);
+
+    store.close();
+    writer.close();
+    std::remove(TEST_DB_PATH);
+    clearDir();
+
+    if (failures == 0) {
+        std::cout << "PASS\n";
+        return 0;
+    }
+    std::cout << "FAILURES: " << failures << "\n";
+    return 1;
+}
@@ -0,0 +1,73 @@
+// InventoryBatchBench.cpp
+// Micro-benchmark for unpacking a grocery delivery.
+//
+// Applies the same mix of adds, increments and decrements once as separate
+// writes (one commit each, as separate POSTs do) and once inside a single
+// InventoryStore::inTransaction, as POST /api/inventory/batch does. Only the
+// database side is measured; the batch also saves a FastCGI round trip per
+// operation.
+//
+// Run:
+//   ./build/src/InventoryStore/inventory_batch_bench [operations] [rounds]
+
+#include "../InventoryStore.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+static const char* BENCH_DB_PATH = "/tmp/pifridge_inventory_batch_bench.db";
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+// One delivery: each new item is added, then incremented and decremented
+static void unpack(InventoryStore& store, int operations, int round) {
+    int addsPerRound = (operations + 2) / 3;
+    for (int i = 0; i < operations; ++i) {
+        int id = round * addsPerRound + i / 3 + 1;
+        switch (i % 3) {
+        case 0:  store.addItem("Item " + std::to_string(id), std::to_string(5000000 + id), 1, ""); break;
+        case 1:  store.incrementItem(id); break;
+        default: store.decrementItem(id); break;
+        }
+    }
+}
+
+static double run(bool batched, int operations, int rounds) {
+    std::remove(BENCH_DB_PATH);
+    InventoryStore store(BENCH_DB_PATH);
+    if (!store.open()) return 0;
+
+    auto start = Clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        if (batched) {
+            store.inTransaction([&] { unpack(store, operations, round); });
+        } else {
+            unpack(store, operations, round);
+        }
+    }
+    return elapsedUs(start) / rounds;
+}
+
+int main(int argc, char** argv) {
+    int operations = argc > 1 ? std::stoi(argv[1]) : 40;
+    int rounds     = argc > 2 ? std::stoi(argv[2]) : 50;
+
+    double separateUs = run(false, operations, rounds);
+    double batchedUs  = run(true,  operations, rounds);
+
+    std::cout << "[bench] " << operations << " operations per delivery, " << rounds << " deliveries\n"
+              << "[bench] one commit each:  " << separateUs << " us/delivery\n"
+              << "[bench] one transaction:  " << batchedUs  << " us/delivery\n"
+              << "[bench] speed-up:         " << separateUs / batchedUs << "x\n";
+
+    std::remove(BENCH_DB_PATH);
+    std::remove((std::string(BENCH_DB_PATH) + "-wal").c_str());
+    std::remove((std::string(BENCH_DB_PATH) + "-shm").c_str());
+    return 0;
+}
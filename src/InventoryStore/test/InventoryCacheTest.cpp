@@ -0,0 +1,153 @@
+// InventoryCacheTest.cpp
+// Checks that InventoryCache answers exactly as the database does.
+//
+// Writes go through a separate InventoryStore, as the scanner and camera
+// do from the pifridge process. After each round the cache's listing and
+// its delta for every earlier version must match what InventoryStore
+// produces from SQLite.
+
+#include "../InventoryCache.hpp"
+#include "../InventoryStore.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+static const char* TEST_DB_PATH = "/tmp/pifridge_inventory_cache_test.db";
+
+static void expectTrue(bool condition, const std::string& message, int& failures) {
+    if (!condition) {
+        std::cout << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+static void expectEqual(const std::string& actual, const std::string& expected,
+                        const std::string& message, int& failures) {
+    if (actual != expected) {
+        std::cout << "FAIL: " << message
+                  << " expected \"" << expected
+                  << "\" got \"" << actual << "\"\n";
+        ++failures;
+    }
+}
+
+static std::string cachedChangesSince(const InventoryCache::Snapshot& snapshot, long long since) {
+    std::string out;
+    JsonWriter json = JsonWriter::toString(out);
+    snapshot.writeChangesSince(since, json);
+    json.flush();
+    return out;
+}
+
+// Every dated item, soonest first
+static std::string expiring(const InventoryCache::Snapshot& snapshot) {
+    std::string out;
+    JsonWriter json = JsonWriter::toString(out);
+    snapshot.writeExpiring(0, 1000000, json);
+    json.flush();
+    return out;
+}
+
+// A snapshot patched write by write must index every item as one loaded whole
+static void expectSameIndexes(const InventoryCache::Snapshot& patched, const InventoryCache::Snapshot& loaded,
+                              const std::string& when, int& failures) {
+    expectTrue(patched.items.size() == loaded.items.size(), when + ": item count", failures);
+    for (const InventoryItem& item : loaded.items) {
+        std::string what = when + ": item " + std::to_string(item.id);
+        const InventoryItem* found = patched.findById(item.id);
+        expectTrue(found && found->name == item.name && found->quantity == item.quantity,
+                   what + " by id", failures);
+        expectTrue(patched.findByBarcode(item.barcode).size() == loaded.findByBarcode(item.barcode).size(),
+                   what + " by barcode", failures);
+        expectTrue(patched.findByName(item.name).size() == loaded.findByName(item.name).size(),
+                   what + " by name", failures);
+    }
+    expectEqual(expiring(patched), expiring(loaded), when + ": expiry order", failures);
+}
+
+// The cache must agree with SQLite on the listing and on every delta
+static void expectInSync(InventoryCache& cache, InventoryStore& db, const std::string& when, int& failures) {
+    auto snapshot = cache.current();
+    expectTrue(snapshot != nullptr, when + ": cache should load", failures);
+    if (!snapshot) return;
+
+    expectTrue(snapshot->version == db.version(), when + ": version should match the database", failures);
+    expectEqual(snapshot->listing(), db.getAllItems(), when + ": listing", failures);
+
+    for (long long since = -1; since <= snapshot->version + 1; ++since) {
+        expectEqual(cachedChangesSince(*snapshot, since), db.getChangesSince(since),
+                    when + ": changes since " + std::to_string(since), failures);
+    }
+}
+
+int main() {
+    int failures = 0;
+
+    std::remove(TEST_DB_PATH);
+
+    InventoryStore writer(TEST_DB_PATH);
+    expectTrue(writer.open(), "writer should open", failures);
+    writer.addItem("Milk", "5000112548167", 1, "");
+    writer.addItem("Eggs", "", 6, "");
+    writer.addItem("Butter", "5000000000001", 1, "2026-01-01");
+
+    InventoryCache cache(TEST_DB_PATH);
+    expectInSync(cache, writer, "initial load", failures);
+
+    auto before = cache.current();
+    expectTrue(cache.current() == before, "no commits should mean the same snapshot", failures);
+
+    // Another connection's writes must be picked up via data_version
+    writer.addItem("Cheese", "5000000000002", 1, "");
+    writer.incrementItem(1);
+    writer.decrementItem(2);
+    writer.deleteItem(3);
+    writer.updateItem(2, "Free Range Eggs", "", 5, "");
+    expectTrue(cache.current() != before, "a commit elsewhere should give a new snapshot", failures);
+    expectInSync(cache, writer, "after external writes", failures);
+
+    writer.inTransaction([&] {
+        writer.addItem("MILK", "5000112548167", 2, "");
+        writer.addItem("Yoghurt", "", 4, "");
+        writer.decrementItem(4);
+    });
+    expectInSync(cache, writer, "after a batch", failures);
+
+    auto snapshot = cache.current();
+    if (snapshot) {
+        const InventoryItem* milk = snapshot->findById(1);
+        expectTrue(milk && milk->quantity == 4, "findById should see the merged quantity", failures);
+        expectTrue(snapshot->findById(3) == nullptr, "deleted item should be gone", failures);
+        expectTrue(snapshot->findByBarcode("5000112548167").size() == 1, "findByBarcode should find milk", failures);
+        expectTrue(snapshot->findByBarcode("").empty(), "empty barcode should not be indexed", failures);
+        expectTrue(snapshot->findByName("free RANGE eggs").size() == 1, "findByName should ignore case", failures);
+        expectTrue(snapshot->findByName("Cheese").empty(), "decremented-away item should not be found", failures);
+    }
+
+    // A new cache loading mid-log must still answer old deltas correctly
+    InventoryCache fresh(TEST_DB_PATH);
+    expectInSync(fresh, writer, "fresh load", failures);
+    if (snapshot && fresh.current()) expectSameIndexes(*snapshot, *fresh.current(), "patched", failures);
+
+    // Rows that move in the listing, or to either end of it
+    writer.upsertItem("Apples", "5000000000003", 3, "2026-11-02", "2020-01-01");
+    writer.upsertItem("Zucchini", "", 1, "2026-11-05", "2099-01-01");
+    writer.updateItem(1, "Whole Milk", "5000112548167", 4, "2026-10-25");
+    writer.deleteItem(2);
+    expectInSync(cache, writer, "after moves", failures);
+    InventoryCache reloaded(TEST_DB_PATH);
+    if (cache.current() && reloaded.current()) {
+        expectSameIndexes(*cache.current(), *reloaded.current(), "after moves", failures);
+    }
+
+    writer.close();
+    std::remove(TEST_DB_PATH);
+
+    if (failures == 0) {
+        std::cout << "PASS\n";
+        return 0;
+    }
+    std::cout << "FAILURES: " << failures << "\n";
+    return 1;
+}
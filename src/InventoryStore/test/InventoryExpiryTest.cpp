@@ -0,0 +1,136 @@
+// InventoryExpiryTest.cpp
+// Checks BestBefore::parse on label-style dates, that writes store them
+// normalised, that migration 7 dates existing rows, and that the expiring
+// list from InventoryCache matches the one InventoryStore reads from SQLite.
+
+#include "../BestBefore.hpp"
+#include "../InventoryCache.hpp"
+#include "../InventoryStore.hpp"
+#include "JsonView.hpp"
+
+#include <sqlite3.h>
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+static const char* TEST_DB_PATH = "/tmp/pifridge_inventory_expiry_test.db";
+
+static void expectTrue(bool condition, const std::string& message, int& failures) {
+    if (!condition) {
+        std::cout << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+static void expectEqual(const std::string& actual, const std::string& expected,
+                        const std::string& message, int& failures) {
+    if (actual != expected) {
+        std::cout << "FAIL: " << message
+                  << " expected \"" << expected
+                  << "\" got \"" << actual << "\"\n";
+        ++failures;
+    }
+}
+
+// "YYYY-MM-DD", or "-" if @p text is not read as a date
+static std::string parsed(const std::string& text) {
+    BestBefore date;
+    return BestBefore::parse(text, date) ? date.date : "-";
+}
+
+static std::string cachedExpiring(InventoryCache& cache, long long today, int withinDays) {
+    std::string out;
+    JsonWriter json = JsonWriter::toString(out);
+    cache.current()->writeExpiring(today, withinDays, json);
+    json.flush();
+    return out;
+}
+
+int main() {
+    int failures = 0;
+
+    // Label formats
+    expectEqual(parsed("2026-10-12"), "2026-10-12", "ISO date", failures);
+    expectEqual(parsed("12/10/2026"), "2026-10-12", "day first", failures);
+    expectEqual(parsed("BB 12.10.26"), "2026-10-12", "two-digit year and prefix", failures);
+    expectEqual(parsed("Best before: 12 OCT 2026"), "2026-10-12", "month name", failures);
+    expectEqual(parsed("Oct 12 2026"), "2026-10-12", "month name first", failures);
+    expectEqual(parsed("END FEB 2028"), "2028-02-29", "month only means its last day", failures);
+    expectEqual(parsed("10/2026"), "2026-10-31", "month and year", failures);
+    expectEqual(parsed("20261012"), "2026-10-12", "compact date", failures);
+    expectEqual(parsed("31/02/2026"), "-", "impossible day", failures);
+    expectEqual(parsed("2026-13-01"), "-", "impossible month", failures);
+    expectEqual(parsed("see lid"), "-", "no date", failures);
+    expectEqual(parsed(""), "-", "empty", failures);
+    expectTrue(BestBefore::epochDays(1970, 1, 1) == 0, "epoch should be day 0", failures);
+    expectTrue(BestBefore::epochDays(2000, 3, 1) - BestBefore::epochDays(2000, 2, 28) == 2,
+               "2000 should be a leap year", failures);
+
+    // A database at schema 6, before best_before_days existed
+    std::remove(TEST_DB_PATH);
+    {
+        InventoryStore store(TEST_DB_PATH);
+        expectTrue(store.open(), "store should open", failures);
+    }
+    sqlite3* db = nullptr;
+    sqlite3_open(TEST_DB_PATH, &db);
+    sqlite3_exec(db,
+        "DROP INDEX inventory_expiry;"
+        "ALTER TABLE inventory DROP COLUMN best_before_days;"
+        "INSERT INTO inventory (name, barcode, quantity, date_added, best_before) VALUES"
+        "  ('Yoghurt', '', 1, '2026-10-01', '14/10/26'),"
+        "  ('Ham',     '', 1, '2026-10-01', 'see pack'),"
+        "  ('Cheese',  '', 1, '2026-10-01', '');"
+        "PRAGMA user_version = 6;", nullptr, nullptr, nullptr);
+    sqlite3_close(db);
+
+    InventoryStore store(TEST_DB_PATH);
+    expectTrue(store.open(), "store should migrate to 7", failures);
+
+    long long today = BestBefore::epochDays(2026, 10, 12);
+    expectEqual(store.getExpiring(today, 3),
+                "[{\"id\":1,\"name\":\"Yoghurt\",\"barcode\":\"\",\"quantity\":1,"
+                "\"date_added\":\"2026-10-01\",\"best_before\":\"14/10/26\",\"days_left\":2}]",
+                "migration should date existing rows and leave their text", failures);
+
+    // New writes are normalised, so label and date input land on one row
+    store.addItem("Milk", "", 1, "13.10.26");
+    store.addItem("Milk", "", 1, "2026-10-13");
+    store.addItem("Eggs", "", 6, "2026-10-05");
+    store.addItem("Butter", "", 1, "2026-12-01");
+    store.updateItem(2, "Ham", "", 1, "12 OCT 2026");
+
+    InventoryCache cache(TEST_DB_PATH);
+    std::string expiring = store.getExpiring(today, 3);
+    JsonView items = JsonView::parse(expiring);
+    std::string order;
+    for (JsonView item : items.elements()) {
+        order += item["name"].asString() + ":" + item["best_before"].asString() + ":" +
+                 item["days_left"].asString() + " ";
+    }
+    expectEqual(order, "Eggs:2026-10-05:-7 Ham:2026-10-12:0 Milk:2026-10-13:1 Yoghurt:14/10/26:2 ",
+                "expiring should be soonest first, including expired", failures);
+    expectTrue(items[size_t(2)]["quantity"].asInt(0) == 2, "both Milk adds should share a row", failures);
+
+    for (int within : { 0, 1, 3, 60 }) {
+        expectEqual(cachedExpiring(cache, today, within), store.getExpiring(today, within),
+                    "cache should match SQLite within " + std::to_string(within), failures);
+    }
+
+    // The cache's expiry order follows later writes
+    store.decrementItem(3);
+    store.decrementItem(3);
+    expectEqual(cachedExpiring(cache, today, 3), store.getExpiring(today, 3),
+                "cache should drop a deleted item", failures);
+
+    store.close();
+    std::remove(TEST_DB_PATH);
+
+    if (failures == 0) {
+        std::cout << "PASS\n";
+        return 0;
+    }
+    std::cout << "FAILURES: " << failures << "\n";
+    return 1;
+}
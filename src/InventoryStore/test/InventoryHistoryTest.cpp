@@ -0,0 +1,133 @@
+// InventoryHistoryTest.cpp
+// Checks that every change in quantity is recorded with its source, that
+// rollUpHistory() folds events into daily totals exactly once, and that
+// old raw events are pruned while their days remain queryable.
+
+#include "../InventoryStore.hpp"
+
+#include <sqlite3.h>
+
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+static const char* TEST_DB_PATH = "/tmp/pifridge_inventory_history_test.db";
+
+static void expectTrue(bool condition, const std::string& message, int& failures) {
+    if (!condition) {
+        std::cout << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+static void expectEqual(const std::string& actual, const std::string& expected,
+                        const std::string& message, int& failures) {
+    if (actual != expected) {
+        std::cout << "FAIL: " << message
+                  << " expected \"" << expected
+                  << "\" got \"" << actual << "\"\n";
+        ++failures;
+    }
+}
+
+// First column of the first row of @p sql as text
+static std::string scalar(sqlite3* db, const char* sql) {
+    sqlite3_stmt* stmt = nullptr;
+    std::string out;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        out = text ? text : "";
+    }
+    sqlite3_finalize(stmt);
+    return out;
+}
+
+static std::string localDate(time_t at) {
+    char buf[11];
+    strftime(buf, sizeof(buf), "%Y-%m-%d", localtime(&at));
+    return buf;
+}
+
+int main() {
+    int failures = 0;
+
+    std::remove(TEST_DB_PATH);
+
+    InventoryStore ui(TEST_DB_PATH, "ui");
+    InventoryStore scanner(TEST_DB_PATH, "barcode");
+    InventoryStore camera(TEST_DB_PATH, "ca'me ra");   // quote and space are dropped
+    expectTrue(ui.open() && scanner.open() && camera.open(), "stores should open", failures);
+
+    sqlite3* db = nullptr;
+    sqlite3_open(TEST_DB_PATH, &db);
+    auto idOf = [db](const char* name) {
+        std::string sql = std::string("SELECT id FROM inventory WHERE name = '") + name + "';";
+        return std::stoi("0" + scalar(db, sql.c_str()));
+    };
+
+    scanner.upsertItem("Milk", "5000112548167", 1, "");   // +1
+    scanner.upsertItem("Milk", "5000112548167", 1, "");   // +1 (merged)
+    ui.addItem("Eggs", "", 6, "");                        // +6
+    int eggs = idOf("Eggs");
+    ui.decrementItem(eggs);                               // -1
+    ui.updateItem(eggs, "Free Range Eggs", "", 3, "");    // -2
+    ui.updateItem(eggs, "Eggs", "", 3, "");               // rename only: nothing
+    camera.addItem("apple", "", 1, "");                   // +1
+    ui.decrementItem(idOf("apple"));                      // -1, row deleted
+    scanner.incrementItem(idOf("Milk"));                  // +1
+    ui.deleteItem(idOf("Milk"));                          // -3
+    expectEqual(scalar(db, "SELECT group_concat(source || ':' || name || ':' || delta, ' ') FROM "
+                           "(SELECT * FROM inventory_events ORDER BY id);"),
+                "barcode:Milk:1 barcode:Milk:1 ui:Eggs:6 ui:Eggs:-1 ui:Free Range Eggs:-2 "
+                "camera:apple:1 ui:apple:-1 barcode:Milk:1 ui:Milk:-3",
+                "every change in quantity should be logged with its source", failures);
+
+    // An event from long ago, to be pruned once rolled up
+    time_t now = time(nullptr);
+    time_t old = now - (InventoryStore::RAW_EVENT_DAYS + 10) * 86400L;
+    std::string insertOld = "INSERT INTO inventory_events (at, item_id, name, delta, source) VALUES (" +
+                            std::to_string(old) + ", 9, 'milk', -2, 'ui');";
+    sqlite3_exec(db, insertOld.c_str(), nullptr, nullptr, nullptr);
+
+    std::string today = localDate(now);
+    std::string oldDay = localDate(old);
+    expectEqual(ui.getHistory(oldDay, today), "{\"from\":\"" + oldDay + "\",\"to\":\"" + today + "\",\"days\":[]}",
+                "nothing should count before a roll-up", failures);
+
+    expectTrue(ui.rollUpHistory(), "roll-up should succeed", failures);
+    expectTrue(scanner.rollUpHistory(), "second roll-up should be a no-op", failures);
+
+    expectEqual(ui.getHistory(today, today),
+                "{\"from\":\"" + today + "\",\"to\":\"" + today + "\",\"days\":[{\"day\":\"" + today + "\","
+                "\"sources\":{\"barcode\":{\"added\":3,\"removed\":0},\"camera\":{\"added\":1,\"removed\":0},"
+                "\"ui\":{\"added\":6,\"removed\":7}},\"added\":10,\"removed\":7}]}",
+                "daily totals per source", failures);
+    expectEqual(ui.getHistory(oldDay, today, "MILK"),
+                "{\"from\":\"" + oldDay + "\",\"to\":\"" + today + "\",\"days\":["
+                "{\"day\":\"" + oldDay + "\",\"sources\":{\"ui\":{\"added\":0,\"removed\":2}},\"added\":0,\"removed\":2},"
+                "{\"day\":\"" + today + "\",\"sources\":{\"barcode\":{\"added\":3,\"removed\":0},"
+                "\"ui\":{\"added\":0,\"removed\":3}},\"added\":3,\"removed\":3}]}",
+                "name filter should ignore case and span days", failures);
+    expectEqual(scalar(db, "SELECT COUNT(*) FROM inventory_events;"), "9",
+                "only the old raw event should be pruned", failures);
+
+    // Later events add to the same day rather than replacing it
+    ui.addItem("Eggs", "", 2, "");
+    expectTrue(ui.rollUpHistory(), "incremental roll-up should succeed", failures);
+    expectEqual(scalar(db, "SELECT SUM(added) FROM inventory_daily;"), "12",
+                "incremental roll-up should add only new events", failures);
+
+    sqlite3_close(db);
+    ui.close();
+    scanner.close();
+    camera.close();
+    std::remove(TEST_DB_PATH);
+
+    if (failures == 0) {
+        std::cout << "PASS\n";
+        return 0;
+    }
+    std::cout << "FAILURES: " << failures << "\n";
+    return 1;
+}
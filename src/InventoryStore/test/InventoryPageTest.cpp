@@ -0,0 +1,199 @@
+// InventoryPageTest.cpp
+// Checks InventoryCache::Snapshot::writePage: walking every page with each
+// filter must visit exactly the matching items, in listing order, once
+// each — including when rows are added and removed between pages.
+
+#include "../BestBefore.hpp"
+#include "../InventoryCache.hpp"
+#include "../InventoryStore.hpp"
+#include "JsonView.hpp"
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <string>
+
+static const char* TEST_DB_PATH = "/tmp/pifridge_inventory_page_test.db";
+
+static void expectTrue(bool condition, const std::string& message, int& failures) {
+    if (!condition) {
+        std::cout << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+static void expectEqual(const std::string& actual, const std::string& expected,
+                        const std::string& message, int& failures) {
+    if (actual != expected) {
+        std::cout << "FAIL: " << message
+                  << " expected \"" << expected
+                  << "\" got \"" << actual << "\"\n";
+        ++failures;
+    }
+}
+
+static std::string page(const InventoryCache::Snapshot& snapshot, const InventoryCache::PageQuery& query) {
+    std::string out;
+    JsonWriter json = JsonWriter::toString(out);
+    snapshot.writePage(query, json);
+    json.flush();
+    return out;
+}
+
+// Ids of every page joined with ",", following "next" until it is null
+static std::string walk(InventoryCache& cache, InventoryCache::PageQuery query,
+                        const std::function<void()>& betweenPages = nullptr) {
+    std::string ids;
+    for (int pages = 0; pages < 100; ++pages) {
+        std::string json = page(*cache.current(), query);
+        JsonView body = JsonView::parse(json);
+        for (JsonView item : body["items"].elements()) {
+            if (!ids.empty()) ids += ",";
+            ids += std::to_string(item["id"].asInt(0));
+        }
+        if (body["next"].type() == JsonView::Type::Null) break;
+        if (!InventoryCache::parseCursor(body["next"].asString(), query)) return "bad cursor";
+        if (betweenPages) betweenPages();
+    }
+    return ids;
+}
+
+// Ids of the snapshot's items that @p keep accepts, in listing order
+static std::string expected(InventoryCache& cache, const std::function<bool(const InventoryItem&)>& keep) {
+    std::string ids;
+    for (const InventoryItem& item : cache.current()->items) {
+        if (!keep(item)) continue;
+        if (!ids.empty()) ids += ",";
+        ids += std::to_string(item.id);
+    }
+    return ids;
+}
+
+int main() {
+    int failures = 0;
+
+    std::remove(TEST_DB_PATH);
+
+    InventoryStore store(TEST_DB_PATH);
+    expectTrue(store.open(), "store should open", failures);
+
+    // 24 items over four days, so pages cross date boundaries
+    const char* names[] = { "Milk", "Mince", "Eggs", "Butter" };
+    for (int i = 0; i < 24; ++i) {
+        std::string bestBefore = i % 3 == 0 ? "" : "2026-11-" + std::to_string(10 + i);
+        store.addItem(std::string(names[i % 4]) + " " + std::to_string(i),
+                      i % 4 == 0 ? "5000112548167" : "", 1, bestBefore);
+    }
+    // And two whose best_before is free text: a label as OCR read it, and no date
+    store.addItem("Yoghurt", "", 1, "BB 20.11.26");
+    store.addItem("Leftovers", "", 1, "eat soon");
+    sqlite3* db = nullptr;
+    sqlite3_open(TEST_DB_PATH, &db);
+    sqlite3_exec(db, "UPDATE inventory SET date_added = '2026-10-0' || (1 + id % 4);", nullptr, nullptr, nullptr);
+
+    InventoryCache cache(TEST_DB_PATH);
+    expectTrue(cache.current() != nullptr, "cache should load", failures);
+
+    InventoryCache::PageQuery all;
+    all.limit = 5;
+    expectEqual(walk(cache, all), expected(cache, [](const InventoryItem&) { return true; }),
+                "unfiltered pages should cover the listing", failures);
+
+    InventoryCache::PageQuery barcode = all;
+    barcode.barcode = "5000112548167";
+    expectEqual(walk(cache, barcode),
+                expected(cache, [](const InventoryItem& item) { return item.barcode == "5000112548167"; }),
+                "barcode filter", failures);
+
+    InventoryCache::PageQuery prefix = all;
+    prefix.limit = 2;
+    prefix.namePrefix = "MI";
+    expectEqual(walk(cache, prefix),
+                expected(cache, [](const InventoryItem& item) { return item.name.compare(0, 2, "Mi") == 0; }),
+                "name prefix filter should ignore case", failures);
+
+    const long long nov15 = BestBefore::epochDays(2026, 11, 15);
+    const long long nov25 = BestBefore::epochDays(2026, 11, 25);
+    InventoryCache::PageQuery range = all;
+    range.bestBeforeFromDays = nov15;
+    range.bestBeforeToDays   = nov25;
+    std::string inRange = walk(cache, range);
+    expectEqual(inRange,
+                expected(cache, [=](const InventoryItem& item) {
+                    return item.bestBeforeDays >= nov15 && item.bestBeforeDays <= nov25;
+                }),
+                "best_before range should be inclusive and skip undated items", failures);
+    expectTrue(("," + inRange + ",").find(",25,") != std::string::npos, "a label date in range should match by its day", failures);
+
+    // Free text sorts after any YYYY-MM-DD, but has no day, so it never matches
+    InventoryCache::PageQuery from = all;
+    from.bestBeforeFromDays = nov15;
+    expectTrue(("," + walk(cache, from) + ",").find(",26,") == std::string::npos,
+               "undated free text should not pass a lower bound", failures);
+
+    InventoryCache::PageQuery combined = range;
+    combined.namePrefix = "milk";
+    expectEqual(walk(cache, combined),
+                expected(cache, [=](const InventoryItem& item) {
+                    return item.name.compare(0, 4, "Milk") == 0 &&
+                           item.bestBeforeDays >= nov15 && item.bestBeforeDays <= nov25;
+                }),
+                "filters should combine", failures);
+
+    // Exactly a page of matches leaves no empty page behind
+    InventoryCache::PageQuery exact = all;
+    exact.limit = 6;
+    exact.barcode = "5000112548167";
+    std::string exactPage = page(*cache.current(), exact);
+    expectTrue(JsonView::parse(exactPage)["items"].elements().size() == 6 &&
+               JsonView::parse(exactPage)["next"].type() == JsonView::Type::Null,
+               "a full last page should have no next cursor", failures);
+
+    // Writes between pages. New items are newest, so they sort before the
+    // cursor and are not visited; deleted ones are simply not reached.
+    // Every item present throughout must be visited exactly once.
+    std::string survivors = expected(cache, [](const InventoryItem& item) { return item.id % 2 == 1; });
+    int round = 0;
+    std::string walked = walk(cache, all, [&] {
+        store.addItem("Late " + std::to_string(round++), "", 1, "");
+        sqlite3_exec(db, "UPDATE inventory SET date_added = '2026-10-09' WHERE name LIKE 'Late%';"
+                         "DELETE FROM inventory WHERE id IN (SELECT id FROM inventory WHERE id % 2 = 0 LIMIT 1);",
+                     nullptr, nullptr, nullptr);
+    });
+    std::string walkedSurvivors;
+    for (size_t pos = 0; pos < walked.size();) {
+        size_t comma = std::min(walked.find(',', pos), walked.size());
+        long long id = std::stoll(walked.substr(pos, comma - pos));
+        pos = comma + 1;
+        expectTrue(id <= 26, "item added mid-walk should not be visited", failures);
+        if (id % 2 == 1) walkedSurvivors += (walkedSurvivors.empty() ? "" : ",") + std::to_string(id);
+    }
+    expectEqual(walkedSurvivors, survivors, "paging through writes", failures);
+
+    // Projection and parsing
+    InventoryCache::PageQuery fields = all;
+    fields.limit = 1;
+    expectTrue(InventoryCache::parseFields("id,quantity", fields.fields), "fields should parse", failures);
+    std::string projected = page(*cache.current(), fields);
+    JsonView first = JsonView::parse(projected)["items"][size_t(0)];
+    expectTrue(first["id"].asInt(0) > 0 && first["quantity"].valid() && !first["name"].valid(),
+               "only the chosen fields should be written", failures);
+    expectTrue(!InventoryCache::parseFields("id,colour", fields.fields), "unknown field should fail", failures);
+    expectTrue(!InventoryCache::parseFields("", fields.fields), "empty field list should fail", failures);
+    expectTrue(!InventoryCache::parseCursor("2026-10-01", fields), "cursor without id should fail", failures);
+    expectTrue(!InventoryCache::parseCursor("2026-10-01_x", fields), "cursor with bad id should fail", failures);
+
+    sqlite3_close(db);
+    store.close();
+    std::remove(TEST_DB_PATH);
+
+    if (failures == 0) {
+        std::cout << "PASS\n";
+        return 0;
+    }
+    std::cout << "FAILURES: " << failures << "\n";
+    return 1;
+}
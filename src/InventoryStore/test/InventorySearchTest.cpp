@@ -0,0 +1,88 @@
+// InventorySearchTest.cpp
+// Checks InventoryStore::search: prefix matching, ranking, input that looks
+// like FTS5 syntax, and that the inventory_search index follows every write.
+
+#include "../InventoryStore.hpp"
+#include "JsonView.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const char* TEST_DB_PATH = "/tmp/pifridge_inventory_search_test.db";
+
+static void expectTrue(bool condition, const std::string& message, int& failures) {
+    if (!condition) {
+        std::cout << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+static void expectEqual(const std::string& actual, const std::string& expected,
+                        const std::string& message, int& failures) {
+    if (actual != expected) {
+        std::cout << "FAIL: " << message
+                  << " expected \"" << expected
+                  << "\" got \"" << actual << "\"\n";
+        ++failures;
+    }
+}
+
+// Names of the results, in order, joined with "|"
+static std::string names(InventoryStore& store, const std::string& query, int limit = 10) {
+    std::string json = store.search(query, limit);
+    std::string out;
+    for (JsonView item : JsonView::parse(json).elements()) {
+        if (!out.empty()) out += "|";
+        out += item["name"].asString();
+    }
+    return out;
+}
+
+int main() {
+    int failures = 0;
+
+    std::remove(TEST_DB_PATH);
+
+    InventoryStore store(TEST_DB_PATH);
+    expectTrue(store.open(), "store should open", failures);
+    store.addItem("Eggplant", "", 1, "");
+    store.addItem("Free Range Eggs", "5000112548167", 6, "");
+    store.addItem("Egg", "", 1, "");
+    store.addItem("Crème fraîche", "3033490004521", 1, "");
+    store.addItem("Milk", "5000112637922", 2, "");
+
+    expectEqual(names(store, "egg"), "Egg|Eggplant|Free Range Eggs",
+                "whole-word match should rank first", failures);
+    expectEqual(names(store, "fr eg"), "Free Range Eggs", "every word should have to match", failures);
+    expectEqual(names(store, "FREE"), "Free Range Eggs", "matching should ignore case", failures);
+    expectEqual(names(store, "creme"), "Crème fraîche", "matching should ignore diacritics", failures);
+    expectEqual(names(store, "30334"), "Crème fraîche", "barcode prefixes should match", failures);
+    expectEqual(names(store, "egg", 2), "Egg|Eggplant", "limit should apply", failures);
+    expectEqual(store.search("", 10), "[]", "empty query should give no results", failures);
+    expectEqual(store.search("  \"*( ", 10), "[]", "punctuation only should give no results", failures);
+    expectEqual(names(store, "egg\" OR milk*"), "", "FTS5 syntax in the input should be inert", failures);
+
+    // Writes through every path keep the index in step
+    store.updateItem(3, "Duck Egg", "", 1, "");
+    expectEqual(names(store, "duck"), "Duck Egg", "renamed item should be found by its new name", failures);
+    store.deleteItem(1);
+    expectEqual(names(store, "eggp"), "", "deleted item should not be found", failures);
+    store.decrementItem(5);
+    store.decrementItem(5);
+    expectEqual(names(store, "milk"), "", "decremented-away item should not be found", failures);
+    store.upsertItem("Egg", "", 2, "");
+    expectEqual(names(store, "egg"), "Egg|Duck Egg|Free Range Eggs",
+                "re-added item should be found once", failures);
+
+    store.close();
+    std::remove(TEST_DB_PATH);
+
+    if (failures == 0) {
+        std::cout << "PASS\n";
+        return 0;
+    }
+    std::cout << "FAILURES: " << failures << "\n";
+    return 1;
+}
@@ -0,0 +1,105 @@
+// InventoryStoreBench.cpp
+// Micro-benchmark for the per-request cost of GET /api/inventory.
+//
+// Compares the old request path (open the database, run the schema DDL,
+// prepare, query, close) against a long-lived InventoryStore that reuses its
+// connection and cached statements, and against InventoryCache, which only
+// checks PRAGMA data_version and copies out the listing it already holds.
+// The last row is one 50-item page from the middle of the listing, found
+// by cursor.
+//
+// Run:
+//   ./build/src/InventoryStore/inventory_store_bench [items] [requests]
+
+#include "../InventoryCache.hpp"
+#include "../InventoryStore.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+static const char* BENCH_DB_PATH = "/tmp/pifridge_inventory_bench.db";
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    int items    = argc > 1 ? std::stoi(argv[1]) : 50;
+    int requests = argc > 2 ? std::stoi(argv[2]) : 2000;
+
+    std::remove(BENCH_DB_PATH);
+
+    {
+        InventoryStore seed(BENCH_DB_PATH);
+        if (!seed.open()) return 1;
+        for (int i = 0; i < items; ++i) {
+            seed.addItem("Item " + std::to_string(i), std::to_string(5000000 + i), 1 + i % 4, "");
+        }
+    }
+
+    size_t bytes = 0;
+
+    // Old path: a fresh connection per request
+    auto start = Clock::now();
+    for (int i = 0; i < requests; ++i) {
+        InventoryStore perRequest(BENCH_DB_PATH);
+        perRequest.open();
+        bytes += perRequest.getAllItems().size();
+    }
+    double perRequestUs = elapsedUs(start) / requests;
+
+    // New path: one connection, statements prepared once
+    InventoryStore store(BENCH_DB_PATH);
+    store.open();
+    store.getAllItems();
+
+    start = Clock::now();
+    for (int i = 0; i < requests; ++i) {
+        bytes += store.getAllItems().size();
+    }
+    double persistentUs = elapsedUs(start) / requests;
+
+    // Cached path: a data_version check, then the prebuilt listing
+    InventoryCache cache(BENCH_DB_PATH);
+    cache.current();
+
+    start = Clock::now();
+    for (int i = 0; i < requests; ++i) {
+        std::string body = cache.current()->listing();
+        bytes += body.size();
+    }
+    double cachedUs = elapsedUs(start) / requests;
+
+    // One page from the middle, as ?limit=50&cursor=...
+    InventoryCache::PageQuery page;
+    const InventoryItem& middle = cache.current()->items[static_cast<size_t>(items / 2)];
+    InventoryCache::parseCursor(InventoryCache::cursorAfter(middle), page);
+
+    start = Clock::now();
+    for (int i = 0; i < requests; ++i) {
+        std::string body;
+        JsonWriter json = JsonWriter::toString(body);
+        cache.current()->writePage(page, json);
+        json.flush();
+        bytes += body.size();
+    }
+    double pageUs = elapsedUs(start) / requests;
+
+    std::cout << "[bench] " << items << " items, " << requests << " requests each\n"
+              << "[bench] open per request:   " << perRequestUs << " us/request\n"
+              << "[bench] persistent + cache: " << persistentUs << " us/request\n"
+              << "[bench] in-memory copy:     " << cachedUs << " us/request\n"
+              << "[bench] 50-item page:       " << pageUs << " us/request\n"
+              << "[bench] speed-up:           " << perRequestUs / persistentUs << "x, "
+              << persistentUs / cachedUs << "x\n"
+              << "[bench] (" << bytes << " bytes served)\n";
+
+    std::remove(BENCH_DB_PATH);
+    std::remove((std::string(BENCH_DB_PATH) + "-wal").c_str());
+    std::remove((std::string(BENCH_DB_PATH) + "-shm").c_str());
+    return 0;
+}
@@ -0,0 +1,87 @@
+// InventoryStreamBench.cpp
+// Time and peak memory for GET /api/inventory on a large inventory.
+//
+// Streams the listing through JsonWriter into a counting sink (standing in
+// for FCGX_PutStr), then builds the same listing as one std::string, and
+// reports the process high-water mark after each. Streaming runs first
+// because the high-water mark only ever rises.
+//
+// Run:
+//   ./build/src/InventoryStore/inventory_stream_bench [items] [requests]
+
+#include "../InventoryStore.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+
+static const char* BENCH_DB_PATH = "/tmp/pifridge_inventory_stream_bench.db";
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+static long peakRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+int main(int argc, char** argv) {
+    int items    = argc > 1 ? std::stoi(argv[1]) : 20000;
+    int requests = argc > 2 ? std::stoi(argv[2]) : 20;
+
+    std::remove(BENCH_DB_PATH);
+
+    InventoryStore store(BENCH_DB_PATH);
+    if (!store.open()) return 1;
+
+    sqlite3* db = nullptr;
+    sqlite3_open(BENCH_DB_PATH, &db);
+    sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+    for (int i = 0; i < items; ++i) {
+        std::string sql = "INSERT INTO inventory (name, barcode, quantity, date_added, best_before) "
+                          "VALUES ('Item \"" + std::to_string(i) + "\" with a longer name', '" +
+                          std::to_string(5000000 + i) + "', 1, '2025-04-01', '2025-05-01');";
+        sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
+    }
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    sqlite3_close(db);
+
+    long baselineKb = peakRssKb();
+    size_t bytes = 0;
+
+    auto start = Clock::now();
+    for (int i = 0; i < requests; ++i) {
+        JsonWriter json([&bytes](const char*, size_t size) {
+            bytes += size;
+            return true;
+        });
+        store.writeAllItems(json);
+        json.flush();
+    }
+    double streamUs = elapsedUs(start) / requests;
+    long streamKb = peakRssKb();
+
+    start = Clock::now();
+    for (int i = 0; i < requests; ++i) {
+        bytes += store.getAllItems().size();
+    }
+    double stringUs = elapsedUs(start) / requests;
+    long stringKb = peakRssKb();
+
+    std::cout << "[bench] " << items << " items, " << requests << " requests each\n"
+              << "[bench] streamed:  " << streamUs << " us/request, peak +" << (streamKb - baselineKb) << " KB\n"
+              << "[bench] as string: " << stringUs << " us/request, peak +" << (stringKb - baselineKb) << " KB\n"
+              << "[bench] (" << bytes << " bytes produced)\n";
+
+    store.close();
+    std::remove(BENCH_DB_PATH);
+    std::remove((std::string(BENCH_DB_PATH) + "-wal").c_str());
+    std::remove((std::string(BENCH_DB_PATH) + "-shm").c_str());
+    return 0;
+}
@@ -0,0 +1,116 @@
+// InventoryTransferBench.cpp
+// Time and peak memory for /api/inventory/export and /import on a large
+// inventory.
+//
+// Exports every row as NDJSON and as CSV into a counting sink (standing in
+// for FCGX_PutStr), keeping only the NDJSON, then imports it into an empty
+// database 16 KB at a time, as the handler reads the request body. The
+// high-water mark is taken after each step; the import's figure starts
+// once the body is held, so it is the importer's own.
+//
+// Run:
+//   ./build/src/InventoryStore/inventory_transfer_bench [items]
+
+#include "../InventoryStore.hpp"
+#include "../InventoryTransfer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+
+static const char* SOURCE_DB_PATH = "/tmp/pifridge_inventory_transfer_bench_source.db";
+static const char* TARGET_DB_PATH = "/tmp/pifridge_inventory_transfer_bench_target.db";
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static long peakRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static void removeDatabase(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+int main(int argc, char** argv) {
+    int items = argc > 1 ? std::stoi(argv[1]) : 100000;
+
+    removeDatabase(SOURCE_DB_PATH);
+    removeDatabase(TARGET_DB_PATH);
+
+    InventoryStore source(SOURCE_DB_PATH);
+    if (!source.open()) return 1;
+
+    sqlite3* db = nullptr;
+    sqlite3_open(SOURCE_DB_PATH, &db);
+    sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+    for (int i = 0; i < items; ++i) {
+        std::string sql = "INSERT INTO inventory (name, barcode, quantity, date_added, best_before) "
+                          "VALUES ('Item \"" + std::to_string(i) + "\", with a longer name', '" +
+                          std::to_string(5000000 + i) + "', 1, '2025-04-01', '2025-05-01');";
+        sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
+    }
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    sqlite3_close(db);
+
+    long baselineKb = peakRssKb();
+
+    size_t csvBytes = 0;
+    auto start = Clock::now();
+    {
+        JsonWriter out([&csvBytes](const char*, size_t size) {
+            csvBytes += size;
+            return true;
+        });
+        InventoryTransfer::writeExport(source, InventoryTransfer::Format::Csv, out);
+        out.flush();
+    }
+    double csvMs = elapsedMs(start);
+    long csvKb = peakRssKb();
+
+    std::string body;
+    start = Clock::now();
+    {
+        JsonWriter out = JsonWriter::toString(body);
+        InventoryTransfer::writeExport(source, InventoryTransfer::Format::Ndjson, out);
+        out.flush();
+    }
+    double ndjsonMs = elapsedMs(start);
+    long bodyKb = peakRssKb();
+
+    InventoryStore target(TARGET_DB_PATH);
+    if (!target.open()) return 1;
+
+    start = Clock::now();
+    InventoryImporter importer(target, InventoryTransfer::Format::Ndjson);
+    const size_t CHUNK_BYTES = 16 * 1024;
+    for (size_t pos = 0; pos < body.size(); pos += CHUNK_BYTES) {
+        importer.feed(body.data() + pos, std::min(CHUNK_BYTES, body.size() - pos));
+    }
+    importer.finish();
+    double importMs = elapsedMs(start);
+    long importKb = peakRssKb();
+
+    std::cout << "[bench] " << items << " items\n"
+              << "[bench] export csv:    " << csvMs << " ms, " << csvBytes << " bytes, peak +"
+              << (csvKb - baselineKb) << " KB\n"
+              << "[bench] export ndjson: " << ndjsonMs << " ms, " << body.size() << " bytes\n"
+              << "[bench] import ndjson: " << importMs << " ms, " << importer.imported() << " imported, "
+              << importer.rejected() << " rejected, peak +" << (importKb - bodyKb) << " KB\n";
+
+    source.close();
+    target.close();
+    removeDatabase(SOURCE_DB_PATH);
+    removeDatabase(TARGET_DB_PATH);
+    return 0;
+}
@@ -0,0 +1,169 @@
+// InventoryTransferTest.cpp
+// Checks that an NDJSON or CSV export imported into an empty database
+// exports the same again, however the body is split into chunks; that CSV
+// quoting survives separators, quotes and line breaks; and that bad rows
+// are rejected one by one while the rest are imported in batches.
+
+#include "../InventoryStore.hpp"
+#include "../InventoryTransfer.hpp"
+#include "JsonView.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+static const char* SOURCE_DB_PATH = "/tmp/pifridge_inventory_transfer_source.db";
+static const char* TEST_DB_PATH   = "/tmp/pifridge_inventory_transfer_test.db";
+
+static void expectTrue(bool condition, const std::string& message, int& failures) {
+    if (!condition) {
+        std::cout << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+static void expectEqual(const std::string& actual, const std::string& expected,
+                        const std::string& message, int& failures) {
+    if (actual != expected) {
+        std::cout << "FAIL: " << message
+                  << " expected \"" << expected
+                  << "\" got \"" << actual << "\"\n";
+        ++failures;
+    }
+}
+
+static std::string exported(InventoryStore& store, InventoryTransfer::Format format) {
+    std::string out;
+    JsonWriter json = JsonWriter::toString(out);
+    InventoryTransfer::writeExport(store, format, json);
+    json.flush();
+    return out;
+}
+
+// Imports @p body into a fresh database in chunks of @p chunk bytes and
+// returns the result; @p store is left open on that database
+static std::string imported(InventoryStore& store, InventoryTransfer::Format format,
+                            const std::string& body, size_t chunk) {
+    store.close();
+    std::remove(TEST_DB_PATH);
+    store.open();
+
+    InventoryImporter importer(store, format);
+    for (size_t pos = 0; pos < body.size(); pos += chunk) {
+        importer.feed(body.data() + pos, std::min(chunk, body.size() - pos));
+    }
+    importer.finish();
+
+    std::string out;
+    JsonWriter json = JsonWriter::toString(out);
+    importer.writeResult(json);
+    json.flush();
+    return out;
+}
+
+int main() {
+    int failures = 0;
+
+    std::remove(SOURCE_DB_PATH);
+    InventoryStore source(SOURCE_DB_PATH);
+    expectTrue(source.open(), "source store should open", failures);
+
+    source.addItem("Milk", "5000112548167", 2, "2026-10-20");
+    source.addItem("Cheese, \"Extra\" Mature", "", 1, "");
+    source.addItem("Note\nwith a line break", "", 1, "see lid");
+    source.addItem("Crème fraîche", "3033490004521", 3, "12/11/26");
+    source.addItem("Leftovers", "", 1, "");
+    source.deleteItem(5);
+
+    std::string ndjson = exported(source, InventoryTransfer::Format::Ndjson);
+    std::string csv    = exported(source, InventoryTransfer::Format::Csv);
+
+    size_t lines = 0;
+    for (char c : ndjson) lines += c == '\n';
+    expectTrue(lines == 4 && JsonView::parse(ndjson.substr(0, ndjson.find('\n')))["name"].asString() == "Milk",
+               "NDJSON should be one object per line, in id order", failures);
+    std::string csvStart = "id,name,barcode,quantity,date_added,best_before\r\n1,Milk,5000112548167,2,";
+    expectTrue(csv.compare(0, csvStart.size(), csvStart) == 0, "CSV should start with its header", failures);
+    expectTrue(csv.find(",\"Cheese, \"\"Extra\"\" Mature\",") != std::string::npos,
+               "CSV should quote and double quotes", failures);
+
+    // Round trip: every chunking gives back the same export, ids included
+    InventoryStore target(TEST_DB_PATH);
+    for (size_t chunk : { size_t(1), size_t(7), size_t(4096) }) {
+        std::string result = imported(target, InventoryTransfer::Format::Ndjson, ndjson, chunk);
+        expectEqual(result, "{\"imported\":4,\"rejected\":0,\"errors\":[]}",
+                    "NDJSON import in chunks of " + std::to_string(chunk), failures);
+        expectEqual(exported(target, InventoryTransfer::Format::Ndjson), ndjson,
+                    "NDJSON round trip in chunks of " + std::to_string(chunk), failures);
+
+        result = imported(target, InventoryTransfer::Format::Csv, csv, chunk);
+        expectEqual(result, "{\"imported\":4,\"rejected\":0,\"errors\":[]}",
+                    "CSV import in chunks of " + std::to_string(chunk), failures);
+        expectEqual(exported(target, InventoryTransfer::Format::Csv), csv,
+                    "CSV round trip in chunks of " + std::to_string(chunk), failures);
+    }
+
+    // Importing into a stocked fridge merges rather than duplicating
+    InventoryImporter again(target, InventoryTransfer::Format::Csv);
+    again.feed(csv.data(), csv.size());
+    expectTrue(again.finish() && again.imported() == 4, "second import should succeed", failures);
+    expectEqual(JsonView::parse(target.getAllItems())[size_t(3)]["quantity"].asString(), "4",
+                "second import should add to quantities", failures);
+
+    // Spreadsheet CSV: byte-order mark, columns reordered, extra and
+    // missing columns, LF endings, a blank line and bad rows
+    std::string sheet =
+        "\xEF\xBB\xBF" "Quantity,Notes,NAME,best_before\n"
+        "3,fridge door,Butter,2026-12-01\n"
+        "\n"
+        ",,Yoghurt,\n"
+        "two,,Ham,\n"
+        "1,,,2026-12-01\n"
+        "1,\"unterminated,Bacon,\n";
+    std::string result = imported(target, InventoryTransfer::Format::Csv, sheet, 5);
+    expectEqual(result,
+                "{\"imported\":2,\"rejected\":3,\"errors\":[{\"row\":3,\"error\":\"invalid quantity\"},"
+                "{\"row\":4,\"error\":\"missing name\"},{\"row\":5,\"error\":\"unterminated quote\"}]}",
+                "bad rows should be rejected on their own", failures);
+    expectTrue(JsonView::parse(target.getAllItems()).elements().size() == 2, "good rows should be imported", failures);
+
+    expectEqual(imported(target, InventoryTransfer::Format::Csv, "barcode,quantity\n123,1\n", 64),
+                "{\"imported\":0,\"rejected\":0,\"errors\":[],\"error\":\"CSV header has no name column\"}",
+                "CSV without a name column should fail", failures);
+
+    std::string badJson =
+        "{\"name\":\"Eggs\",\"quantity\":6,\"date_added\":\"2026-09-30\"}\n"
+        "[\"Eggs\"]\n"
+        "{\"name\":\"Jam\",\"date_added\":\"last week\"}\n"
+        "{\"name\":\"" + std::string(InventoryImporter::MAX_ROW_BYTES, 'x') + "\"}\n"
+        "{\"name\":\"Bread\",\"quantity\":\"1\"}";
+    expectEqual(imported(target, InventoryTransfer::Format::Ndjson, badJson, 1000),
+                "{\"imported\":2,\"rejected\":3,\"errors\":[{\"row\":2,\"error\":\"not a JSON object\"},"
+                "{\"row\":3,\"error\":\"invalid date_added\"},{\"row\":4,\"error\":\"row too long\"}]}",
+                "bad NDJSON rows should be rejected on their own", failures);
+    expectTrue(target.getAllItems().find("\"date_added\":\"2026-09-30\"") != std::string::npos,
+               "date_added should be kept from the import", failures);
+
+    // More rows than one batch
+    std::string many;
+    size_t rows = InventoryImporter::IMPORT_BATCH_ROWS * 2 + 17;
+    for (size_t i = 0; i < rows; ++i) many += "{\"name\":\"Item " + std::to_string(i) + "\"}\n";
+    expectEqual(imported(target, InventoryTransfer::Format::Ndjson, many, 4096),
+                "{\"imported\":" + std::to_string(rows) + ",\"rejected\":0,\"errors\":[]}",
+                "rows past one batch should all be imported", failures);
+    expectTrue(JsonView::parse(target.getAllItems()).elements().size() == rows,
+               "every batch should be committed", failures);
+
+    source.close();
+    target.close();
+    std::remove(SOURCE_DB_PATH);
+    std::remove(TEST_DB_PATH);
+
+    if (failures == 0) {
+        std::cout << "PASS\n";
+        return 0;
+    }
+    std::cout << "FAILURES: " << failures << "\n";
+    return 1;
+}
@@ -0,0 +1,169 @@
+// QueryPlanTest.cpp
+// Regression test for the indexes behind every per-request query.
+//
+// Migrates a fresh database through InventoryStore, then runs EXPLAIN QUERY
+// PLAN on each statement in InventoryQueries plus the lookups done inside
+// the change-log triggers and the upsert's conflict check (EXPLAIN QUERY
+// PLAN does not show those). A lookup fails if its plan scans anything —
+// table or index — instead of searching; the full listing may only walk an
+// index in order, and the export may only read the table in rowid order.
+// Any query fails if it sorts in a temporary b-tree.
+
+#include "../InventoryQueries.hpp"
+#include "../InventoryStore.hpp"
+
+#include <sqlite3.h>
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const char* TEST_DB_PATH = "/tmp/pifridge_query_plan_test.db";
+
+static void expectTrue(bool condition, const std::string& message, int& failures) {
+    if (!condition) {
+        std::cout << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+// The detail column of each EXPLAIN QUERY PLAN row, e.g.
+// "SEARCH inventory USING INTEGER PRIMARY KEY (rowid=?)"
+static std::vector<std::string> queryPlan(sqlite3* db, const char* sql) {
+    std::vector<std::string> plan;
+
+    sqlite3_stmt* stmt = nullptr;
+    std::string explain = std::string("EXPLAIN QUERY PLAN ") + sql;
+    if (sqlite3_prepare_v2(db, explain.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cout << "FAIL: could not prepare " << sql << ": " << sqlite3_errmsg(db) << "\n";
+        return plan;
+    }
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* detail = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+        plan.emplace_back(detail ? detail : "");
+    }
+    sqlite3_finalize(stmt);
+    return plan;
+}
+
+// "SCAN inventory" reads every row in rowid order; "SCAN inventory USING
+// INDEX ..." reads every entry of an index, in that index's order. FTS5
+// reports its lookups as "SCAN ... VIRTUAL TABLE INDEX n:M..." — the M is
+// the MATCH constraint, answered from the full-text index.
+static bool isScan(const std::string& step) {
+    if (step.find(" VIRTUAL TABLE INDEX ") != std::string::npos && step.find(":M") != std::string::npos) {
+        return false;
+    }
+    return step.rfind("SCAN ", 0) == 0;
+}
+
+static bool isTableScan(const std::string& step) {
+    return isScan(step) && step.find(" USING ") == std::string::npos;
+}
+
+int main() {
+    int failures = 0;
+
+    std::remove(TEST_DB_PATH);
+    {
+        InventoryStore store(TEST_DB_PATH);
+        expectTrue(store.open(), "store should open and migrate a fresh database", failures);
+        for (int i = 0; i < 50; ++i) {
+            store.addItem("Item " + std::to_string(i), i % 2 ? std::to_string(5000000 + i) : "", 1, "");
+        }
+        for (int i = 0; i < 10; ++i) store.deleteItem(i * 3 + 1);
+    }
+
+    sqlite3* db = nullptr;
+    if (sqlite3_open(TEST_DB_PATH, &db) != SQLITE_OK) {
+        std::cout << "FAIL: could not reopen " << TEST_DB_PATH << "\n";
+        return 1;
+    }
+
+    struct HotQuery {
+        const char* name;
+        const char* sql;
+        bool readsAll = false;   // returns every row, so an ordered index scan is fine
+        bool sortsRange = false; // groups only the rowid range it reads, so a sort is fine
+        bool dumpsTable = false; // every row in rowid order, so a plain table scan is right
+    };
+
+    const HotQuery queries[] = {
+        { "version",             InventoryQueries::VERSION },
+        { "version and horizon", InventoryQueries::VERSION_AND_HORIZON },
+        { "all items",           InventoryQueries::ALL_ITEMS, true },
+        { "all with versions",   InventoryQueries::ALL_ITEMS_WITH_VERSIONS, true },
+        { "export",              InventoryQueries::EXPORT_ITEMS, true, false, true },
+        { "changes since",       InventoryQueries::CHANGES_SINCE },
+        { "tombstones",          InventoryQueries::TOMBSTONES },
+        { "upsert",              InventoryQueries::UPSERT },
+        { "name for barcode",    InventoryQueries::NAME_FOR_BARCODE },
+        { "search",              InventoryQueries::SEARCH },
+        { "expiring",            InventoryQueries::EXPIRING },
+        { "pending events",      InventoryQueries::PENDING_EVENTS },
+        { "roll up events",      InventoryQueries::ROLL_UP_EVENTS, false, true },
+        { "mark rolled up",      InventoryQueries::MARK_ROLLED_UP },
+        { "prune events",        InventoryQueries::PRUNE_EVENTS },
+        { "history",             InventoryQueries::HISTORY },
+        { "history for name",    InventoryQueries::HISTORY_FOR_NAME },
+        { "delete",              InventoryQueries::DELETE_ITEM },
+        { "decrement",           InventoryQueries::DECREMENT_ITEM },
+        { "increment",           InventoryQueries::INCREMENT_ITEM },
+        { "update",              InventoryQueries::UPDATE_ITEM },
+        // DATA_VERSION is a pragma and has no query plan
+
+        // The row the upsert conflicts with
+        { "upsert conflict lookup",
+          "SELECT quantity FROM inventory "
+          "WHERE name = ? COLLATE NOCASE AND barcode = ? AND best_before = ?;" },
+
+        // Statements inside the inventory_change_* triggers
+        { "trigger: supersede change",
+          "DELETE FROM inventory_changes WHERE item_id = ?;" },
+        { "trigger: tombstone horizon",
+          "SELECT version FROM inventory_changes WHERE deleted = 1 "
+          "ORDER BY version DESC LIMIT 1 OFFSET 1000;" },
+        { "trigger: drop old tombstones",
+          "DELETE FROM inventory_changes WHERE deleted = 1 AND version <= ?;" },
+    };
+
+    for (const HotQuery& query : queries) {
+        std::vector<std::string> plan = queryPlan(db, query.sql);
+
+        for (const std::string& step : plan) {
+            bool scans = !query.dumpsTable && (query.readsAll ? isTableScan(step) : isScan(step));
+            expectTrue(!scans, std::string(query.name) + " should not scan: " + step, failures);
+            expectTrue(query.sortsRange || step.find("TEMP B-TREE") == std::string::npos,
+                       std::string(query.name) + " should not sort: " + step, failures);
+        }
+    }
+
+    // The plans above must be the ones the indexes were made for
+    std::vector<std::string> listing = queryPlan(db, InventoryQueries::ALL_ITEMS);
+    expectTrue(!listing.empty() && listing[0].find("inventory_listing") != std::string::npos,
+               "all items should walk inventory_listing", failures);
+
+    std::vector<std::string> barcode = queryPlan(db, InventoryQueries::NAME_FOR_BARCODE);
+    expectTrue(!barcode.empty() && barcode[0].find("COVERING INDEX inventory_barcode") != std::string::npos,
+               "name for barcode should be answered from inventory_barcode alone", failures);
+
+    std::vector<std::string> expiring = queryPlan(db, InventoryQueries::EXPIRING);
+    expectTrue(!expiring.empty() && expiring[0].find("INDEX inventory_expiry (best_before_days<?)") != std::string::npos,
+               "expiring should be a range scan of inventory_expiry", failures);
+
+    std::vector<std::string> history = queryPlan(db, InventoryQueries::HISTORY_FOR_NAME);
+    expectTrue(!history.empty() && history[0].find("INDEX inventory_daily_name") != std::string::npos,
+               "history for a name should walk inventory_daily_name", failures);
+
+    sqlite3_close(db);
+    std::remove(TEST_DB_PATH);
+
+    if (failures == 0) {
+        std::cout << "PASS\n";
+        return 0;
+    }
+    std::cout << "FAILURES: " << failures << "\n";
+    return 1;
+}
@@ -0,0 +1,600 @@
+#include "SensorHistory.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace {
+
+const char* const SERIES_NAMES[SensorHistory::SERIES_COUNT] = {
+    "temperature", "humidity", "pressure", "gas", "lux"
+};
+
+// Rounds toward minus infinity, so steps before 1970 still line up
+int64_t floorTo(int64_t time, int64_t step) {
+    int64_t q = time / step;
+    if (time % step != 0 && time < 0) --q;
+    return q * step;
+}
+
+int64_t roundUpTo(int64_t value, int64_t unit) {
+    return (value + unit - 1) / unit * unit;
+}
+
+// Same two decimals as the /api/fridge JSON
+void writeNumber(JsonWriter& json, double number) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.2f", number);
+    json.rawValue(text);
+}
+
+// Fold one step's worth of samples or buckets into @p points
+void merge(std::vector<SensorHistory::Point>& points, int64_t stepStart,
+           double min, double max, double sum, uint32_t count) {
+    if (points.empty() || points.back().time != stepStart) {
+        SensorHistory::Point point;
+        point.time = stepStart;
+        point.min = min;
+        point.max = max;
+        points.push_back(point);
+    }
+    SensorHistory::Point& point = points.back();
+    point.min = std::min(point.min, min);
+    point.max = std::max(point.max, max);
+    point.sum += sum;
+    point.count += count;
+}
+
+// Milliseconds as Unix seconds, e.g. 1759996800.200
+void writeTime(JsonWriter& json, int64_t timeMs) {
+    int64_t seconds = floorTo(timeMs, 1000);
+    char text[32];
+    std::snprintf(text, sizeof(text), "%lld.%03lld", static_cast<long long>(seconds / 1000),
+                  static_cast<long long>(timeMs - seconds));
+    json.rawValue(text);
+}
+
+// ---------------------------------------------------------------------------
+// Downsampling
+// ---------------------------------------------------------------------------
+
+// Four lanes, through GCC's vector extensions: SSE on x86, NEON on the Pi
+typedef float  Floats  __attribute__((vector_size(16)));
+typedef double Doubles __attribute__((vector_size(32)));
+
+struct Reduced {
+    float  min = std::numeric_limits<float>::infinity();
+    float  max = -std::numeric_limits<float>::infinity();
+    double sum = 0.0;
+};
+
+// Fold @p n values into @p out, four at a time; sums in doubles, as query()
+void reduce(const float* values, size_t n, Reduced& out) {
+    Floats lo = { out.min, out.min, out.min, out.min };
+    Floats hi = { out.max, out.max, out.max, out.max };
+    Doubles sum = { 0.0, 0.0, 0.0, 0.0 };
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        Floats x;
+        std::memcpy(&x, values + i, sizeof(x));
+        lo = x < lo ? x : lo;
+        hi = x > hi ? x : hi;
+        sum += __builtin_convertvector(x, Doubles);
+    }
+    for (int lane = 0; lane < 4; ++lane) {
+        out.min = std::min(out.min, lo[lane]);
+        out.max = std::max(out.max, hi[lane]);
+        out.sum += sum[lane];
+    }
+    for (; i < n; ++i) {
+        out.min = std::min(out.min, values[i]);
+        out.max = std::max(out.max, values[i]);
+        out.sum += values[i];
+    }
+}
+
+/**
+ * A stretch of a ring, column by column. Raw samples have only times and
+ * values; roll-up buckets also carry their min, max, sum and count, and
+ * their average as the value.
+ */
+struct Run {
+    const int64_t*  times = nullptr;
+    const float*    values = nullptr;
+    const float*    mins = nullptr;
+    const float*    maxs = nullptr;
+    const double*   sums = nullptr;
+    const uint32_t* counts = nullptr;
+    size_t size = 0;
+};
+
+/** The samples of a range: one run, or two where the ring wraps. */
+struct Samples {
+    Run    runs[2];
+    size_t runCount = 0;
+    size_t size = 0;
+
+    void add(const Run& run) {
+        if (run.size == 0) return;
+        runs[runCount++] = run;
+        size += run.size;
+    }
+
+    int64_t time(size_t i) const  { return i < runs[0].size ? runs[0].times[i] : runs[1].times[i - runs[0].size]; }
+    float   value(size_t i) const { return i < runs[0].size ? runs[0].values[i] : runs[1].values[i - runs[0].size]; }
+
+    /** Call visit(run, from, to, offset) for each contiguous piece of [begin, end). */
+    template <class Visit>
+    void forEach(size_t begin, size_t end, Visit visit) const {
+        size_t offset = 0;
+        for (size_t r = 0; r < runCount && begin < end; ++r) {
+            const Run& run = runs[r];
+            if (begin < offset + run.size) {
+                size_t to = std::min(end, offset + run.size);
+                visit(run, begin - offset, to - offset, offset);
+                begin = to;
+            }
+            offset += run.size;
+        }
+    }
+};
+
+// Roll-up buckets copied into columns, so they read like raw samples
+struct BucketColumns {
+    std::vector<int64_t>  times;
+    std::vector<float>    values;
+    std::vector<float>    mins;
+    std::vector<float>    maxs;
+    std::vector<double>   sums;
+    std::vector<uint32_t> counts;
+
+    Run run() const {
+        Run run;
+        run.times = times.data();
+        run.values = values.data();
+        run.mins = mins.data();
+        run.maxs = maxs.data();
+        run.sums = sums.data();
+        run.counts = counts.data();
+        run.size = times.size();
+        return run;
+    }
+};
+
+// Equal-width slices of [fromMs, toMs), each with the min, max, sum and count of its samples
+std::vector<SensorHistory::Point> envelope(const Samples& samples, int64_t fromMs, int64_t toMs, size_t points) {
+    std::vector<SensorHistory::Point> out;
+    const int64_t width = std::max<int64_t>(1, (toMs - fromMs + static_cast<int64_t>(points) - 1) /
+                                                   static_cast<int64_t>(points));
+
+    for (size_t r = 0; r < samples.runCount; ++r) {
+        const Run& run = samples.runs[r];
+        size_t i = 0;
+        while (i < run.size) {
+            int64_t start = fromMs + (run.times[i] - fromMs) / width * width;
+            size_t end = static_cast<size_t>(std::lower_bound(run.times + i, run.times + run.size, start + width) -
+                                             run.times);
+
+            Reduced slice;
+            uint32_t count = 0;
+            if (run.mins) {
+                Reduced maxs;
+                reduce(run.mins + i, end - i, slice);
+                reduce(run.maxs + i, end - i, maxs);
+                slice.max = maxs.max;
+                slice.sum = 0.0;
+                for (size_t k = i; k < end; ++k) {
+                    slice.sum += run.sums[k];
+                    count += run.counts[k];
+                }
+            } else {
+                reduce(run.values + i, end - i, slice);
+                count = static_cast<uint32_t>(end - i);
+            }
+            merge(out, start, slice.min, slice.max, slice.sum, count);
+            i = end;
+        }
+    }
+    return out;
+}
+
+/**
+ * Largest-Triangle-Three-Buckets (Steinarsson, 2013). Slices are equal
+ * counts of samples. Each slice is read twice, as the next slice and then
+ * as the current one, while it is still in cache.
+ */
+std::vector<SensorHistory::Point> lttb(const Samples& samples, size_t points) {
+    std::vector<SensorHistory::Point> out;
+    const size_t n = samples.size;
+    auto keep = [&out, &samples](size_t i) {
+        SensorHistory::Point point;
+        point.time = samples.time(i);
+        point.min = point.max = point.sum = samples.value(i);
+        point.count = 1;
+        out.push_back(point);
+    };
+
+    if (n <= points) {
+        for (size_t i = 0; i < n; ++i) keep(i);
+        return out;
+    }
+
+    // Slice b is [boundary(b), boundary(b + 1)); the first and last samples are kept as they are
+    const uint64_t slices = points - 2;
+    auto boundary = [n, slices](uint64_t b) {
+        return static_cast<size_t>(std::min<uint64_t>(1 + b * (n - 2) / slices, n));
+    };
+
+    const int64_t base = samples.time(0);
+    size_t kept = 0;
+    keep(0);
+    for (uint64_t b = 0; b < slices; ++b) {
+        size_t start = boundary(b);
+        size_t end = boundary(b + 1);
+        size_t nextEnd = b + 1 < slices ? boundary(b + 2) : n;   // the last slice's next is the last sample
+
+        // The next slice's average point
+        Reduced next;
+        int64_t timeSum = 0;
+        samples.forEach(end, nextEnd, [&next, &timeSum, base](const Run& run, size_t from, size_t to, size_t) {
+            reduce(run.values + from, to - from, next);
+            for (size_t k = from; k < to; ++k) timeSum += run.times[k] - base;
+        });
+        double count = static_cast<double>(nextEnd - end);
+        double cx = static_cast<double>(timeSum) / count;
+        double cy = next.sum / count;
+
+        // The sample making the largest triangle with the one kept last and that average
+        double ax = static_cast<double>(samples.time(kept) - base);
+        double ay = samples.value(kept);
+        double largest = -1.0;
+        size_t chosen = start;
+        samples.forEach(start, end, [&](const Run& run, size_t from, size_t to, size_t offset) {
+            for (size_t k = from; k < to; ++k) {
+                double x = static_cast<double>(run.times[k] - base);
+                double area = std::fabs((ax - cx) * (run.values[k] - ay) - (ax - x) * (cy - ay));
+                if (area > largest) {
+                    largest = area;
+                    chosen = offset + k;
+                }
+            }
+        });
+        keep(chosen);
+        kept = chosen;
+    }
+    keep(n - 1);
+    return out;
+}
+
+} // namespace
+
+SensorHistory::SensorHistory()
+    : SensorHistory({ 5 * SECOND_MS, 5 * SECOND_MS, 5 * SECOND_MS, 5 * SECOND_MS, 200 }) {}
+
+SensorHistory::SensorHistory(const std::array<int64_t, SERIES_COUNT>& samplePeriodMs) {
+    for (unsigned s = 0; s < SERIES_COUNT; ++s) {
+        Track& track = tracks_[s];
+        size_t capacity = static_cast<size_t>(RAW_RETENTION_MS / std::max<int64_t>(1, samplePeriodMs[s]));
+        track.times.resize(std::max<size_t>(1, capacity));
+        track.values.resize(track.times.size());
+
+        track.minutes.width = MINUTE_MS;
+        track.minutes.buckets.resize(static_cast<size_t>(MINUTE_RETENTION_MS / MINUTE_MS));
+        track.hours.width = HOUR_MS;
+        track.hours.buckets.resize(static_cast<size_t>(HOUR_RETENTION_MS / HOUR_MS));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Rings
+// ---------------------------------------------------------------------------
+size_t SensorHistory::Track::slot(size_t i) const {
+    return (next + times.size() - size + i) % times.size();
+}
+
+const SensorHistory::Bucket& SensorHistory::Rollup::at(size_t i) const {
+    return buckets[(next + buckets.size() - size + i) % buckets.size()];
+}
+
+void SensorHistory::Rollup::add(int64_t timeMs, float value) {
+    int64_t start = floorTo(timeMs, width);
+
+    if (size > 0) {
+        Bucket& newest = buckets[(next + buckets.size() - 1) % buckets.size()];
+        if (newest.start == start) {
+            newest.min = std::min(newest.min, value);
+            newest.max = std::max(newest.max, value);
+            newest.sum += value;
+            ++newest.count;
+            return;
+        }
+    }
+
+    Bucket& bucket = buckets[next];
+    bucket.start = start;
+    bucket.min = value;
+    bucket.max = value;
+    bucket.sum = value;
+    bucket.count = 1;
+    next = (next + 1) % buckets.size();
+    size = std::min(size + 1, buckets.size());
+}
+
+void SensorHistory::Rollup::merge(const Bucket& bucket) {
+    if (size > 0) {
+        Bucket& newest = buckets[(next + buckets.size() - 1) % buckets.size()];
+        if (newest.start == bucket.start) {
+            newest.min = std::min(newest.min, bucket.min);
+            newest.max = std::max(newest.max, bucket.max);
+            newest.sum += bucket.sum;
+            newest.count += bucket.count;
+            return;
+        }
+    }
+
+    buckets[next] = bucket;
+    next = (next + 1) % buckets.size();
+    size = std::min(size + 1, buckets.size());
+}
+
+void SensorHistory::record(Series series, int64_t timeMs, double value) {
+    Track& track = tracks_[series];
+    std::lock_guard<std::mutex> lock(track.mutex);
+
+    timeMs = std::max(timeMs, track.last);
+    track.last = timeMs;
+
+    float stored = static_cast<float>(value);
+    track.times[track.next] = timeMs;
+    track.values[track.next] = stored;
+    track.next = (track.next + 1) % track.times.size();
+    track.size = std::min(track.size + 1, track.times.size());
+
+    track.minutes.add(timeMs, stored);
+    track.hours.add(timeMs, stored);
+}
+
+void SensorHistory::restoreHour(Series series, const Point& hour) {
+    if (hour.count == 0) return;
+
+    Bucket bucket;
+    bucket.start = floorTo(hour.time, HOUR_MS);
+    bucket.min = static_cast<float>(hour.min);
+    bucket.max = static_cast<float>(hour.max);
+    bucket.sum = hour.sum;
+    bucket.count = hour.count;
+
+    Track& track = tracks_[series];
+    std::lock_guard<std::mutex> lock(track.mutex);
+    track.hours.merge(bucket);
+}
+
+// ---------------------------------------------------------------------------
+// Queries
+// ---------------------------------------------------------------------------
+std::vector<SensorHistory::Point> SensorHistory::query(Series series, int64_t fromMs, int64_t toMs,
+                                                       int64_t stepMs) const {
+    std::vector<Point> points;
+    if (stepMs <= 0 || fromMs >= toMs) return points;
+
+    // Whole steps only, so a roll-up bucket is never split
+    fromMs = floorTo(fromMs, stepMs);
+    toMs = floorTo(toMs - 1, stepMs) + stepMs;
+
+    const Track& track = tracks_[series];
+    std::lock_guard<std::mutex> lock(track.mutex);
+
+    const Rollup* rollup = stepMs % HOUR_MS == 0 ? &track.hours
+                         : stepMs % MINUTE_MS == 0 ? &track.minutes
+                         : nullptr;
+
+    if (rollup) {
+        // First bucket of the range; buckets are in time order
+        size_t lo = 0;
+        size_t hi = rollup->size;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (rollup->at(mid).start < fromMs) lo = mid + 1;
+            else hi = mid;
+        }
+        for (size_t i = lo; i < rollup->size; ++i) {
+            const Bucket& bucket = rollup->at(i);
+            if (bucket.start >= toMs) break;
+            merge(points, floorTo(bucket.start, stepMs), bucket.min, bucket.max, bucket.sum, bucket.count);
+        }
+        return points;
+    }
+
+    size_t lo = 0;
+    size_t hi = track.size;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (track.times[track.slot(mid)] < fromMs) lo = mid + 1;
+        else hi = mid;
+    }
+    for (size_t i = lo; i < track.size; ++i) {
+        size_t at = track.slot(i);
+        if (track.times[at] >= toMs) break;
+        double value = track.values[at];
+        merge(points, floorTo(track.times[at], stepMs), value, value, value, 1);
+    }
+    return points;
+}
+
+int64_t SensorHistory::stepFor(int64_t fromMs, int64_t toMs, int64_t stepMs, int64_t nowMs) {
+    int64_t span = std::max<int64_t>(toMs - fromMs, 1);
+    int64_t step = std::max(stepMs, SECOND_MS);
+    step = std::max(step, (span + MAX_POINTS - 1) / MAX_POINTS);
+
+    // Older than a ring keeps: read the next coarser one
+    int64_t age = nowMs - fromMs;
+    if (age > RAW_RETENTION_MS)    step = std::max(step, MINUTE_MS);
+    if (age > MINUTE_RETENTION_MS) step = std::max(step, HOUR_MS);
+
+    if (step >= HOUR_MS)        step = roundUpTo(step, HOUR_MS);
+    else if (step >= MINUTE_MS) step = roundUpTo(step, MINUTE_MS);
+    else                        step = roundUpTo(step, SECOND_MS);
+    return step;
+}
+
+std::vector<SensorHistory::Point> SensorHistory::downsample(Series series, int64_t fromMs, int64_t toMs,
+                                                            size_t points, Downsample mode) const {
+    if (fromMs >= toMs) return {};
+    points = std::max<size_t>(points, 2);
+
+    const Track& track = tracks_[series];
+    std::lock_guard<std::mutex> lock(track.mutex);
+
+    // A ring is read if it reaches back to fromMs, or holds all the coarser
+    // rings do: it starts within the next one's oldest bucket, and that one
+    // holds all of the one after. Whether it has filled up says nothing: a
+    // gap, or hours restored from the archive, leave it short of them.
+    const Rollup& minuteRing = track.minutes;
+    const Rollup& hourRing = track.hours;
+    bool minutesHoldAll = minuteRing.size > 0 &&
+        (hourRing.size == 0 || minuteRing.at(0).start < hourRing.at(0).start + HOUR_MS);
+    bool rawHoldsAll = track.size > 0 && minutesHoldAll &&
+        track.times[track.slot(0)] < minuteRing.at(0).start + MINUTE_MS;
+    bool raw = rawHoldsAll || (track.size > 0 && track.times[track.slot(0)] <= fromMs);
+    bool minutes = minutesHoldAll || (minuteRing.size > 0 && minuteRing.at(0).start <= fromMs);
+
+    Samples samples;
+    BucketColumns columns;
+    if (raw) {
+        // Raw samples, read in place: at most two runs where the ring wraps
+        auto first = [&track](int64_t time) {
+            size_t lo = 0;
+            size_t hi = track.size;
+            while (lo < hi) {
+                size_t mid = (lo + hi) / 2;
+                if (track.times[track.slot(mid)] < time) lo = mid + 1;
+                else hi = mid;
+            }
+            return lo;
+        };
+        size_t begin = first(fromMs);
+        size_t count = first(toMs) - begin;
+        size_t at = count > 0 ? track.slot(begin) : 0;
+        size_t head = std::min(count, track.times.size() - at);
+
+        Run run;
+        run.times = track.times.data() + at;
+        run.values = track.values.data() + at;
+        run.size = head;
+        samples.add(run);
+        run.times = track.times.data();
+        run.values = track.values.data();
+        run.size = count - head;
+        samples.add(run);
+    } else {
+        const Rollup& rollup = minutes ? minuteRing : hourRing;
+        for (size_t i = 0; i < rollup.size; ++i) {
+            const Bucket& bucket = rollup.at(i);
+            if (bucket.start < fromMs) continue;
+            if (bucket.start >= toMs) break;
+            columns.times.push_back(bucket.start);
+            columns.values.push_back(static_cast<float>(bucket.sum / bucket.count));
+            columns.mins.push_back(bucket.min);
+            columns.maxs.push_back(bucket.max);
+            columns.sums.push_back(bucket.sum);
+            columns.counts.push_back(bucket.count);
+        }
+        samples.add(columns.run());
+    }
+
+    return mode == Downsample::LTTB ? lttb(samples, points) : envelope(samples, fromMs, toMs, points);
+}
+
+void SensorHistory::writeJson(int64_t fromMs, int64_t toMs, int64_t stepMs, unsigned seriesMask,
+                              JsonWriter& json) const {
+    json.beginObject();
+    json.key("from"); json.value(static_cast<long long>(fromMs / SECOND_MS));
+    json.key("to");   json.value(static_cast<long long>(toMs / SECOND_MS));
+    json.key("step"); json.value(static_cast<long long>(stepMs / SECOND_MS));
+    json.key("series");
+    json.beginObject();
+    for (unsigned s = 0; s < SERIES_COUNT; ++s) {
+        if (!(seriesMask & (1u << s))) continue;
+
+        json.key(SERIES_NAMES[s]);
+        json.beginArray();
+        for (const Point& point : query(static_cast<Series>(s), fromMs, toMs, stepMs)) {
+            json.beginArray();
+            json.value(static_cast<long long>(floorTo(point.time, SECOND_MS) / SECOND_MS));
+            writeNumber(json, point.avg());
+            writeNumber(json, point.min);
+            writeNumber(json, point.max);
+            json.endArray();
+        }
+        json.endArray();
+    }
+    json.endObject();
+    json.endObject();
+}
+
+void SensorHistory::writeDownsampledJson(int64_t fromMs, int64_t toMs, size_t points, Downsample mode,
+                                         unsigned seriesMask, JsonWriter& json) const {
+    json.beginObject();
+    json.key("from");   json.value(static_cast<long long>(fromMs / SECOND_MS));
+    json.key("to");     json.value(static_cast<long long>(toMs / SECOND_MS));
+    json.key("points"); json.value(static_cast<long long>(points));
+    json.key("mode");   json.value(nameOf(mode));
+    json.key("series");
+    json.beginObject();
+    for (unsigned s = 0; s < SERIES_COUNT; ++s) {
+        if (!(seriesMask & (1u << s))) continue;
+
+        json.key(SERIES_NAMES[s]);
+        json.beginArray();
+        for (const Point& point : downsample(static_cast<Series>(s), fromMs, toMs, points, mode)) {
+            json.beginArray();
+            writeTime(json, point.time);
+            writeNumber(json, point.avg());
+            if (mode == Downsample::MINMAX) {
+                writeNumber(json, point.min);
+                writeNumber(json, point.max);
+            }
+            json.endArray();
+        }
+        json.endArray();
+    }
+    json.endObject();
+    json.endObject();
+}
+
+const char* SensorHistory::nameOf(Series series) {
+    return series < SERIES_COUNT ? SERIES_NAMES[series] : "";
+}
+
+bool SensorHistory::parseSeries(std::string_view list, unsigned& seriesMask) {
+    unsigned mask = 0;
+    while (true) {
+        size_t comma = list.find(',');
+        std::string_view name = list.substr(0, comma);
+
+        unsigned s = 0;
+        while (s < SERIES_COUNT && name != SERIES_NAMES[s]) ++s;
+        if (s == SERIES_COUNT) return false;
+        mask |= 1u << s;
+
+        if (comma == std::string_view::npos) break;
+        list.remove_prefix(comma + 1);
+    }
+    seriesMask = mask;
+    return true;
+}
+
+const char* SensorHistory::nameOf(Downsample mode) {
+    return mode == Downsample::LTTB ? "lttb" : "minmax";
+}
+
+bool SensorHistory::parseDownsample(std::string_view name, Downsample& mode) {
+    if (name == "lttb") mode = Downsample::LTTB;
+    else if (name == "minmax") mode = Downsample::MINMAX;
+    else return false;
+    return true;
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "JsonWriter.hpp"
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Recent BME680 and BH1750 readings, raw and rolled up.
+ *
+ * Every series keeps three rings:
+ * - raw samples for the last 24 h at sensor rate
+ * - 1-minute buckets for 7 days
+ * - 1-hour buckets for 90 days
+ *
+ * Each bucket holds the min, max, sum and count of its samples. record()
+ * adds a sample to the raw ring and folds it into the current minute and
+ * hour, so the roll-ups are always up to date and never rebuilt.
+ *
+ * A query for a step of a minute or more is answered from a roll-up, one
+ * bucket per minute or hour of the range, whatever the sensor rate. Only
+ * steps under a minute read raw samples, and only within the last 24 h.
+ *
+ * Raw samples are held as separate time and value arrays, 12 bytes a
+ * sample. The raw ring holds 24 h at the sample period each series was
+ * sized for. A series sampled faster than that keeps less than 24 h.
+ *
+ * Times are Unix milliseconds. A sample older than the last one for its
+ * series is recorded at the last one's time, so the rings stay in order
+ * if the clock steps back.
+ *
+ * For charts, downsample() reduces a range to a fixed number of points,
+ * by Largest-Triangle-Three-Buckets or as a min/max envelope, in one pass
+ * over the samples.
+ *
+ * Thread-safe: one lock per series, held for one sample or one query.
+ *
+ * Usage:
+ * @code
+ *   SensorHistory history;
+ *   history.record(SensorHistory::TEMPERATURE, nowMs, 4.2);
+ *   int64_t step = SensorHistory::stepFor(from, to, 60000, nowMs);
+ *   for (const auto& point : history.query(SensorHistory::TEMPERATURE, from, to, step)) { ... }
+ * @endcode
+ */
+class SensorHistory {
+public:
+    enum Series : unsigned {
+        TEMPERATURE,
+        HUMIDITY,
+        PRESSURE,
+        GAS,
+        LUX,
+        SERIES_COUNT
+    };
+
+    /** Series selection for ?series=, as a bitmask of (1u << Series). */
+    static constexpr unsigned ALL_SERIES = (1u << SERIES_COUNT) - 1;
+
+    static constexpr int64_t SECOND_MS = 1000;
+    static constexpr int64_t MINUTE_MS = 60 * SECOND_MS;
+    static constexpr int64_t HOUR_MS   = 60 * MINUTE_MS;
+
+    static constexpr int64_t RAW_RETENTION_MS    = 24 * HOUR_MS;
+    static constexpr int64_t MINUTE_RETENTION_MS = 7 * 24 * HOUR_MS;
+    static constexpr int64_t HOUR_RETENTION_MS   = 90 * 24 * HOUR_MS;
+
+    /** Most points a query returns per series; a finer step is raised to fit. */
+    static constexpr int64_t MAX_POINTS = 5000;
+
+    /** The samples of one step, [time, time + step). */
+    struct Point {
+        int64_t  time = 0;
+        double   min = 0.0;
+        double   max = 0.0;
+        double   sum = 0.0;
+        uint32_t count = 0;
+
+        double avg() const { return count ? sum / count : 0.0; }
+    };
+
+    /** How downsample() picks its points. */
+    enum class Downsample {
+        LTTB,     // Largest-Triangle-Three-Buckets: samples that keep the line's shape
+        MINMAX    // the min, max and average of equal-width slices: the envelope
+    };
+
+    /** Sized for the BME680's 5 s and the BH1750's 200 ms. */
+    SensorHistory();
+
+    /** @param samplePeriodMs Expected sample period of each series; sizes its raw ring. */
+    explicit SensorHistory(const std::array<int64_t, SERIES_COUNT>& samplePeriodMs);
+
+    SensorHistory(const SensorHistory&) = delete;
+    SensorHistory& operator=(const SensorHistory&) = delete;
+
+    /** Add one reading of @p series taken at @p timeMs. */
+    void record(Series series, int64_t timeMs, double value);
+
+    /**
+     * @brief Fold a whole hour of @p series into its hour roll-up only.
+     *
+     * For SeriesArchive::replay(), which rebuilds the hours past minute
+     * retention this way rather than sample by sample. @p hour.time is the
+     * start of the hour. Call in time order, before record() for anything
+     * later; an hour already in the ring is merged into.
+     */
+    void restoreHour(Series series, const Point& hour);
+
+    /**
+     * @brief Points of @p series in [fromMs, toMs), one per step that has samples.
+     *
+     * Steps start at multiples of @p stepMs, and the range is widened to
+     * whole steps: a step is read whole or not at all. A step that is a
+     * whole number of hours reads hour buckets, a whole number of minutes
+     * reads minute buckets, and anything else reads raw samples. Pass a
+     * step from stepFor() so that the range is covered.
+     */
+    std::vector<Point> query(Series series, int64_t fromMs, int64_t toMs, int64_t stepMs) const;
+
+    /**
+     * @brief The step a query of [fromMs, toMs) should use for a requested step.
+     *
+     * At least 1 s, and raised so there are at most MAX_POINTS points. It is
+     * rounded up to whole seconds, a step of a minute or more to whole
+     * minutes, and one of an hour or more to whole hours, so it reads a
+     * roll-up. A range reaching past raw retention takes at least a minute,
+     * and past minute retention, an hour.
+     */
+    static int64_t stepFor(int64_t fromMs, int64_t toMs, int64_t stepMs, int64_t nowMs);
+
+    /**
+     * @brief At most @p points points of @p series in [fromMs, toMs), to draw a chart.
+     *
+     * Reads the finest tier that holds the whole range: raw samples, else
+     * minute buckets, else hour buckets, a bucket standing in for one
+     * sample at its average. A tier holds the range if it reaches back to
+     * @p fromMs, or holds everything the coarser tiers do.
+     * - LTTB keeps the first and last sample and, from each of points - 2
+     *   equal-count slices in between, the one that makes the largest
+     *   triangle with the point kept before it and the next slice's average.
+     *   Every point is a stored sample: count 1, min = max = its value.
+     * - MINMAX splits the range into @p points equal-width slices, and gives
+     *   each the min, max, sum and count of its samples. Empty slices are
+     *   left out.
+     *
+     * One pass over the range: each slice's min, max and sum are reduced
+     * four values at a time.
+     */
+    std::vector<Point> downsample(Series series, int64_t fromMs, int64_t toMs, size_t points,
+                                  Downsample mode) const;
+
+    /**
+     * @brief Write {"from", "to", "step", "series": {name: [[time, avg, min, max], ...]}}.
+     *
+     * Times are Unix seconds. Only the series in @p seriesMask are written.
+     */
+    void writeJson(int64_t fromMs, int64_t toMs, int64_t stepMs, unsigned seriesMask, JsonWriter& json) const;
+
+    /**
+     * @brief Write {"from", "to", "points", "mode", "series": {name: [...]}} from downsample().
+     *
+     * LTTB points are [time, value] and MINMAX points [time, avg, min, max].
+     * Times are Unix seconds with milliseconds, since samples and slices
+     * can be under a second apart.
+     */
+    void writeDownsampledJson(int64_t fromMs, int64_t toMs, size_t points, Downsample mode,
+                              unsigned seriesMask, JsonWriter& json) const;
+
+    /** "temperature", "humidity", "pressure", "gas" or "lux", as in /api/fridge. */
+    static const char* nameOf(Series series);
+
+    /**
+     * @brief Parse a comma-separated ?series= list such as "temperature,lux".
+     * @return false if a name is unknown or the list is empty.
+     */
+    static bool parseSeries(std::string_view list, unsigned& seriesMask);
+
+    /** "lttb" or "minmax", as in ?mode=. */
+    static const char* nameOf(Downsample mode);
+    static bool parseDownsample(std::string_view name, Downsample& mode);
+
+private:
+    struct Bucket {
+        int64_t  start = 0;
+        float    min = 0.0f;
+        float    max = 0.0f;
+        double   sum = 0.0;
+        uint32_t count = 0;
+    };
+
+    /** Fixed-size ring of buckets, oldest overwritten first. */
+    struct Rollup {
+        int64_t width = 0;
+        std::vector<Bucket> buckets;
+        size_t next = 0;     // slot the next new bucket goes in
+        size_t size = 0;
+
+        const Bucket& at(size_t i) const;   // 0 is the oldest
+        void add(int64_t timeMs, float value);
+        void merge(const Bucket& bucket);   // bucket.start on the width
+    };
+
+    /** Raw samples of one series: times and values in parallel rings. */
+    struct Track {
+        mutable std::mutex mutex;
+        std::vector<int64_t> times;
+        std::vector<float>   values;
+        size_t  next = 0;
+        size_t  size = 0;
+        int64_t last = INT64_MIN;
+        Rollup  minutes;
+        Rollup  hours;
+
+        size_t slot(size_t i) const;   // physical index of the i-th oldest sample
+    };
+
+    std::array<Track, SERIES_COUNT> tracks_;
+};
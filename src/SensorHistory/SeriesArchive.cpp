@@ -0,0 +1,243 @@
+#include "SeriesArchive.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <iostream>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <utility>
+
+namespace {
+
+int64_t floorTo(int64_t time, int64_t step) {
+    int64_t floored = time - time % step;
+    return time < 0 && floored != time ? floored - step : floored;
+}
+
+// "<series>-YYYY-MM-DD.series" back to the series and the week's start
+bool parseName(const char* name, unsigned& series, int64_t& segment) {
+    for (unsigned s = 0; s < SensorHistory::SERIES_COUNT; ++s) {
+        const char* prefix = SensorHistory::nameOf(static_cast<SensorHistory::Series>(s));
+        size_t length = std::strlen(prefix);
+        if (std::strncmp(name, prefix, length) != 0 || name[length] != '-') continue;
+
+        struct tm date{};
+        int consumed = 0;
+        if (std::sscanf(name + length + 1, "%4d-%2d-%2d.series%n",
+                        &date.tm_year, &date.tm_mon, &date.tm_mday, &consumed) != 3 ||
+            name[length + 1 + static_cast<size_t>(consumed)] != '\0' || consumed != 17) {
+            return false;
+        }
+        date.tm_year -= 1900;
+        date.tm_mon -= 1;
+        series = s;
+        segment = static_cast<int64_t>(::timegm(&date)) * 1000;
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+SeriesArchive::SeriesArchive(std::string directory, std::chrono::milliseconds flushInterval)
+    : directory_(std::move(directory)), flushInterval_(flushInterval) {}
+
+SeriesArchive::~SeriesArchive() {
+    stop();
+}
+
+bool SeriesArchive::open() {
+    if (::mkdir(directory_.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "[SeriesArchive] Failed to create " << directory_ << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    DIR* dir = ::opendir(directory_.c_str());
+    if (!dir) {
+        std::cerr << "[SeriesArchive] Failed to list " << directory_ << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    for (auto& segments : segments_) segments.clear();
+    while (dirent* entry = ::readdir(dir)) {
+        unsigned series;
+        int64_t segment;
+        if (parseName(entry->d_name, series, segment)) segments_[series].push_back(segment);
+    }
+    ::closedir(dir);
+
+    // Appends carry on in each series' newest week; a series without files
+    // gets its first when its first sample is written
+    for (unsigned s = 0; s < SensorHistory::SERIES_COUNT; ++s) {
+        std::sort(segments_[s].begin(), segments_[s].end());
+        if (!segments_[s].empty() && !openSegment(s, segments_[s].back())) {
+            for (auto& file : files_) file.reset();
+            return false;
+        }
+    }
+    open_ = true;
+    return true;
+}
+
+void SeriesArchive::start() {
+    if (thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stopping_ = false;
+    }
+    thread_ = std::thread(&SeriesArchive::run, this);
+}
+
+void SeriesArchive::stop() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stopping_ = true;
+    }
+    stopRequested_.notify_one();
+    if (thread_.joinable()) thread_.join();
+    writeQueued();
+}
+
+void SeriesArchive::record(SensorHistory::Series series, int64_t timeMs, double value) {
+    if (!open_) return;
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    queued_[series].push_back({ timeMs, static_cast<float>(value) });
+}
+
+void SeriesArchive::replay(SensorHistory& history, int64_t nowMs) {
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    if (!open_) return;
+
+    const int64_t hoursFrom   = nowMs - SensorHistory::HOUR_RETENTION_MS;
+    const int64_t samplesFrom = nowMs - SensorHistory::MINUTE_RETENTION_MS;
+
+    for (unsigned s = 0; s < SensorHistory::SERIES_COUNT; ++s) {
+        auto series = static_cast<SensorHistory::Series>(s);
+
+        // Past minute retention, only the hours are needed: sum them here
+        // and hand each over whole
+        SensorHistory::Point hour;
+        auto visit = [&history, &hour, series, samplesFrom](int64_t time, float value) {
+            if (time >= samplesFrom) {
+                history.restoreHour(series, hour);
+                hour.count = 0;
+                history.record(series, time, value);
+                return;
+            }
+            int64_t start = floorTo(time, SensorHistory::HOUR_MS);
+            if (hour.count > 0 && hour.time != start) {
+                history.restoreHour(series, hour);
+                hour.count = 0;
+            }
+            if (hour.count == 0) {
+                hour.time = start;
+                hour.min = hour.max = value;
+                hour.sum = 0.0;
+            }
+            hour.min = std::min(hour.min, static_cast<double>(value));
+            hour.max = std::max(hour.max, static_cast<double>(value));
+            hour.sum += value;
+            ++hour.count;
+        };
+
+        for (int64_t segment : segments_[s]) {
+            if (segment + SEGMENT_MS <= hoursFrom) continue;
+            if (files_[s] && segment == segments_[s].back()) {
+                files_[s]->read(hoursFrom, INT64_MAX, visit);
+                continue;
+            }
+            SeriesFile file(pathOf(s, segment));
+            if (file.open()) file.read(hoursFrom, INT64_MAX, visit);
+        }
+        history.restoreHour(series, hour);
+    }
+}
+
+uint64_t SeriesArchive::samples() const {
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    return written_;
+}
+
+void SeriesArchive::run() {
+    // As SnapshotFileWriter: nice applies to this thread only
+    ::setpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)), 19);
+
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    while (!stopping_) {
+        stopRequested_.wait_for(lock, flushInterval_, [this] { return stopping_; });
+        lock.unlock();
+        writeQueued();
+        lock.lock();
+    }
+}
+
+void SeriesArchive::writeQueued() {
+    // Swapped out, so record() can carry on while the files are written
+    std::array<std::vector<Sample>, SensorHistory::SERIES_COUNT> samples;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        samples.swap(queued_);
+    }
+
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    if (!open_) return;
+    for (unsigned s = 0; s < SensorHistory::SERIES_COUNT; ++s) {
+        for (const Sample& sample : samples[s]) {
+            // An earlier week's sample (the clock stepped back) goes in the
+            // newest file, where SeriesFile keeps it in order
+            int64_t segment = floorTo(sample.time, SEGMENT_MS);
+            bool newWeek = segments_[s].empty() || segment > segments_[s].back();
+            if (newWeek || !files_[s]) {
+                if (files_[s]) files_[s]->flush();
+                if (!newWeek) segment = segments_[s].back();
+                if (!openSegment(s, segment)) break;
+                if (newWeek) {
+                    segments_[s].push_back(segment);
+                    expire(s, sample.time);
+                }
+            }
+            if (!files_[s]->append(sample.time, sample.value)) break;
+            ++written_;
+        }
+        if (files_[s]) files_[s]->flush();
+    }
+}
+
+std::string SeriesArchive::pathOf(unsigned series, int64_t segment) const {
+    time_t seconds = static_cast<time_t>(segment / 1000);
+    struct tm date;
+    ::gmtime_r(&seconds, &date);
+    char day[11];
+    std::strftime(day, sizeof(day), "%Y-%m-%d", &date);
+    return directory_ + "/" + SensorHistory::nameOf(static_cast<SensorHistory::Series>(series)) + "-" + day +
+           ".series";
+}
+
+bool SeriesArchive::openSegment(unsigned series, int64_t segment) {
+    files_[series].reset(new SeriesFile(pathOf(series, segment)));
+    if (files_[series]->open()) return true;
+
+    // Logged by SeriesFile; the next write tries again
+    files_[series].reset();
+    return false;
+}
+
+void SeriesArchive::expire(unsigned series, int64_t newestMs) {
+    // Whole weeks, oldest first, never the one being written
+    std::vector<int64_t>& segments = segments_[series];
+    while (segments.size() > 1 && segments.front() + SEGMENT_MS <= newestMs - RETENTION_MS) {
+        std::string path = pathOf(series, segments.front());
+        if (::unlink(path.c_str()) != 0 && errno != ENOENT) {
+            std::cerr << "[SeriesArchive] Failed to delete " << path << ": " << std::strerror(errno) << "\n";
+            return;
+        }
+        segments.erase(segments.begin());
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "SensorHistory.hpp"
+#include "SeriesFile.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Every sensor sample on disk, one SeriesFile per series and week.
+ *
+ * record() only queues the sample under a mutex, so the sensor threads
+ * never wait on the SD card. A thread at the lowest CPU priority appends
+ * the queue to the files and flushes them every flushInterval, so the card
+ * sees a few page writes a minute, and a crash or power cut loses at most
+ * that long.
+ *
+ * Files are "<directory>/<series>-<YYYY-MM-DD>.series", e.g.
+ * temperature-2026-10-15.series, each holding one SEGMENT_MS week from
+ * that UTC date. A sample in a later week starts a new file. Weeks that
+ * ended more than RETENTION_MS before the newest sample are deleted then,
+ * whole, so the archive keeps what the hour roll-up can show and no more.
+ *
+ * Usage:
+ * @code
+ *   SeriesArchive archive("/var/lib/pifridge/history");
+ *   if (archive.open()) archive.replay(history, nowMs);
+ *   archive.start();
+ *   archive.record(SensorHistory::LUX, nowMs, lux);   // from any thread
+ * @endcode
+ */
+class SeriesArchive {
+public:
+    /** Span of one file; weeks start at multiples of this since the epoch. */
+    static constexpr int64_t SEGMENT_MS = 7 * 24 * SensorHistory::HOUR_MS;
+
+    /** How far back files are kept, behind the newest sample. */
+    static constexpr int64_t RETENTION_MS = SensorHistory::HOUR_RETENTION_MS;
+
+    explicit SeriesArchive(std::string directory,
+                           std::chrono::milliseconds flushInterval = std::chrono::seconds(60));
+    ~SeriesArchive();
+
+    SeriesArchive(const SeriesArchive&) = delete;
+    SeriesArchive& operator=(const SeriesArchive&) = delete;
+
+    /**
+     * @brief Create the directory if needed, find its files and open each series' newest.
+     * @return false if the directory or a file can't be opened; nothing is recorded then.
+     */
+    bool open();
+
+    /** Start the writer thread. */
+    void start();
+
+    /** Write and flush what is queued, then stop the thread. */
+    void stop();
+
+    /** Queue one sample. Safe from any thread. */
+    void record(SensorHistory::Series series, int64_t timeMs, double value);
+
+    /**
+     * @brief Refill @p history from the files as it stood at @p nowMs.
+     *
+     * Samples of the last MINUTE_RETENTION_MS are recorded one by one.
+     * Older ones, back to HOUR_RETENTION_MS, are summed into hours and
+     * restored into the hour roll-up only, so the whole 90 days costs one
+     * decode and about 2,000 hour buckets per series.
+     */
+    void replay(SensorHistory& history, int64_t nowMs);
+
+    /** Samples written to the files since open(). */
+    uint64_t samples() const;
+
+private:
+    struct Sample {
+        int64_t time;
+        float   value;
+    };
+
+    void run();
+
+    /** Append the queue to the files and flush them. */
+    void writeQueued();
+
+    std::string pathOf(unsigned series, int64_t segment) const;
+
+    /** Make the week starting at @p segment the one @p series is written to. */
+    bool openSegment(unsigned series, int64_t segment);
+
+    /** Delete the weeks of @p series that ended RETENTION_MS before @p newestMs. */
+    void expire(unsigned series, int64_t newestMs);
+
+    std::string directory_;
+    std::chrono::milliseconds flushInterval_;
+
+    // Held by record(); never across file I/O
+    std::mutex queueMutex_;
+    std::condition_variable stopRequested_;
+    std::array<std::vector<Sample>, SensorHistory::SERIES_COUNT> queued_;
+    bool stopping_ = false;
+
+    // Held while the files are appended to, flushed, read or deleted
+    mutable std::mutex fileMutex_;
+    std::array<std::vector<int64_t>, SensorHistory::SERIES_COUNT> segments_;   // week starts, oldest first
+    std::array<std::unique_ptr<SeriesFile>, SensorHistory::SERIES_COUNT> files_;   // the newest week's
+    uint64_t written_ = 0;
+    std::atomic<bool> open_{false};
+
+    std::thread thread_;
+};
@@ -0,0 +1,481 @@
+#include "SeriesFile.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace {
+
+const char     FILE_MAGIC[8] = { 'P', 'F', 'S', 'E', 'R', 'I', 'E', 'S' };
+const uint32_t FILE_VERSION  = 1;
+const uint32_t BLOCK_MAGIC   = 0x50464231;   // "PFB1"
+
+/** First page of the file. */
+struct FileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t blockSize;
+};
+
+// Grow the file 256 KB at a time: about a day of lux, and a sparse file
+// costs nothing until written
+const size_t GROW_BLOCKS = 64;
+
+// A time of '1111' + 64 bits and a value of '11' + 5 + 5 + 32 bits
+const uint32_t MAX_SAMPLE_BITS = 112;
+
+// ---------------------------------------------------------------------------
+// CRC-32 (IEEE), for block headers
+// ---------------------------------------------------------------------------
+struct CrcTable {
+    uint32_t entries[256];
+
+    CrcTable() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[i] = c;
+        }
+    }
+};
+
+uint32_t crc32(uint32_t crc, const uint8_t* bytes, size_t size) {
+    static const CrcTable table;
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) crc = table.entries[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// ---------------------------------------------------------------------------
+// Bit streams, most significant bit first
+// ---------------------------------------------------------------------------
+
+// Into zeroed bytes: bits are ORed in
+void writeBits(uint8_t* bytes, uint32_t& pos, uint64_t value, int count) {
+    while (count > 0) {
+        int free = 8 - static_cast<int>(pos & 7);
+        int take = std::min(free, count);
+        uint64_t chunk = (value >> (count - take)) & ((1u << take) - 1);
+        bytes[pos >> 3] |= static_cast<uint8_t>(chunk << (free - take));
+        pos += static_cast<uint32_t>(take);
+        count -= take;
+    }
+}
+
+/**
+ * Reads up to 57 bits at a time with one unaligned 8-byte load. Blocks
+ * leave slack after their last bit (MAX_BITS), so the load stays in the
+ * block.
+ */
+class BitReader {
+public:
+    BitReader(const uint8_t* bytes, uint32_t pos) : bytes_(bytes), pos_(pos) {}
+
+    uint64_t read(int count) {
+        uint64_t word;
+        std::memcpy(&word, bytes_ + (pos_ >> 3), sizeof(word));
+        word = __builtin_bswap64(word) << (pos_ & 7);
+        pos_ += static_cast<uint32_t>(count);
+        return word >> (64 - count);
+    }
+
+    uint64_t read64() {
+        uint64_t high = read(32);
+        return (high << 32) | read(32);
+    }
+
+    /** Count of leading 1 bits, up to @p max; consumes them and the 0 after. */
+    int ones(int max) {
+        int n = 0;
+        while (n < max && read(1)) ++n;
+        return n;
+    }
+
+    uint32_t pos() const { return pos_; }
+
+private:
+    const uint8_t* bytes_;
+    uint32_t pos_;
+};
+
+/** Walks the samples of one block. */
+struct BlockDecoder {
+    BitReader bits;
+    uint32_t  remaining;
+    int64_t   time;
+    int64_t   delta = 0;
+    uint32_t  value;
+    int       leading = -1;
+    int       length = 0;
+
+    BlockDecoder(const uint8_t* payload, int64_t first, uint32_t count)
+        : bits(payload, 0), remaining(count ? count - 1 : 0), time(first),
+          value(static_cast<uint32_t>(bits.read(32))) {}
+
+    bool next() {
+        if (remaining == 0) return false;
+        --remaining;
+
+        int64_t dod;
+        switch (bits.ones(4)) {
+        case 0:  dod = 0; break;
+        case 1:  dod = static_cast<int64_t>(bits.read(7)) - 63; break;
+        case 2:  dod = static_cast<int64_t>(bits.read(9)) - 255; break;
+        case 3:  dod = static_cast<int64_t>(bits.read(12)) - 2047; break;
+        default: dod = static_cast<int64_t>(bits.read64()); break;
+        }
+        delta += dod;
+        time += delta;
+
+        if (bits.read(1)) {
+            if (bits.read(1)) {
+                leading = static_cast<int>(bits.read(5));
+                length = static_cast<int>(bits.read(5)) + 1;
+            }
+            value ^= static_cast<uint32_t>(bits.read(length)) << (32 - leading - length);
+        }
+        return true;
+    }
+
+    float current() const {
+        float out;
+        std::memcpy(&out, &value, sizeof(out));
+        return out;
+    }
+};
+
+// Header fields up to the crc, then the payload's first @p bits bits
+uint32_t blockCrc(const void* header, const uint8_t* payload, uint32_t bits) {
+    uint32_t crc = crc32(0, static_cast<const uint8_t*>(header), 32);
+    crc = crc32(crc, payload, bits / 8);
+    if (bits % 8) {
+        // Only the bits in use: later appends fill in the rest of the byte
+        uint8_t last = static_cast<uint8_t>(payload[bits / 8] & (0xFF00 >> (bits % 8)));
+        crc = crc32(crc, &last, 1);
+    }
+    return crc;
+}
+
+} // namespace
+
+SeriesFile::SeriesFile(std::string path) : path_(std::move(path)) {
+    static_assert(sizeof(BlockHeader) == 40, "block header layout");
+    static_assert(offsetof(BlockHeader, crc) == 32, "crc covers the fields before it");
+}
+
+SeriesFile::~SeriesFile() {
+    if (map_) {
+        flush();
+        ::munmap(map_, (1 + mappedBlocks_) * BLOCK_SIZE);
+    }
+    if (fd_ >= 0) ::close(fd_);
+}
+
+// ---------------------------------------------------------------------------
+// Opening
+// ---------------------------------------------------------------------------
+bool SeriesFile::open() {
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    struct stat st;
+    if (fd_ < 0 || ::fstat(fd_, &st) != 0) {
+        std::cerr << "[SeriesFile] Failed to open " << path_ << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    // A new file, or one whose header never reached the disk, is blank
+    FileHeader header = {};
+    static const FileHeader BLANK = {};
+    if (st.st_size > 0 && ::pread(fd_, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+        header.version = ~0u;
+    }
+    bool blank = std::memcmp(&header, &BLANK, sizeof(header)) == 0;
+    if (!blank && (std::memcmp(header.magic, FILE_MAGIC, sizeof(header.magic)) != 0 ||
+                   header.version != FILE_VERSION || header.blockSize != BLOCK_SIZE)) {
+        std::cerr << "[SeriesFile] " << path_ << " is not a series file\n";
+        return false;
+    }
+
+    size_t blocks = static_cast<size_t>(st.st_size) / BLOCK_SIZE;
+    if (blocks < 1 + GROW_BLOCKS) {
+        blocks = 1 + GROW_BLOCKS;
+        if (::ftruncate(fd_, static_cast<off_t>(blocks * BLOCK_SIZE)) != 0) {
+            std::cerr << "[SeriesFile] Failed to size " << path_ << ": " << std::strerror(errno) << "\n";
+            return false;
+        }
+    }
+
+    void* map = ::mmap(nullptr, blocks * BLOCK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        std::cerr << "[SeriesFile] Failed to map " << path_ << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    map_ = static_cast<uint8_t*>(map);
+    mappedBlocks_ = blocks - 1;
+
+    if (blank) {
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+        header.version = FILE_VERSION;
+        header.blockSize = BLOCK_SIZE;
+        std::memcpy(map_, &header, sizeof(header));
+        ::msync(map_, BLOCK_SIZE, MS_SYNC);
+    }
+
+    // Blocks are written in order, so those with a valid header come first:
+    // binary search for the first without one
+    size_t lo = 0;
+    size_t hi = mappedBlocks_;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        BlockInfo info;
+        if (readHeader(mid, info, /*verify=*/ true)) lo = mid + 1;
+        else hi = mid;
+    }
+    blockCount_ = lo;
+
+    if (blockCount_ > 0) resume();
+    return true;
+}
+
+void SeriesFile::resume() {
+    size_t tail = blockCount_ - 1;
+    BlockInfo info;
+    readHeader(tail, info, /*verify=*/ true);
+
+    BlockDecoder decoder(payload(tail), info.first, info.count);
+    while (decoder.next()) {}
+    prevDelta_ = decoder.delta;
+    prevValue_ = decoder.value;
+    leading_ = decoder.leading;
+    length_ = decoder.length;
+
+    // Drop bits appended after the last flush; appends OR into zeroes
+    uint8_t* bytes = payload(tail);
+    if (info.bits % 8) bytes[info.bits / 8] &= static_cast<uint8_t>(0xFF00 >> (info.bits % 8));
+    size_t used = (info.bits + 7) / 8;
+    std::memset(bytes + used, 0, PAYLOAD_BYTES - used);
+
+    dirtyFrom_ = tail;
+    dirty_.assign(1, info);
+}
+
+// ---------------------------------------------------------------------------
+// Blocks
+// ---------------------------------------------------------------------------
+uint8_t* SeriesFile::block(size_t index) const {
+    return map_ + (1 + index) * BLOCK_SIZE;
+}
+
+bool SeriesFile::readHeader(size_t index, BlockInfo& info, bool verify) const {
+    bool found = false;
+    for (int slot = 0; slot < 2; ++slot) {
+        BlockHeader header;
+        std::memcpy(&header, block(index) + slot * sizeof(BlockHeader), sizeof(header));
+        if (header.magic != BLOCK_MAGIC || header.count == 0 || header.bits > MAX_BITS) continue;
+        if (found && header.sequence <= info.sequence) continue;
+        if (verify && header.crc != blockCrc(&header, payload(index), header.bits)) continue;
+
+        info.first = header.first;
+        info.last = header.last;
+        info.count = header.count;
+        info.bits = header.bits;
+        info.sequence = header.sequence;
+        found = true;
+    }
+    return found;
+}
+
+void SeriesFile::writeHeader(size_t index, BlockInfo& info) {
+    ++info.sequence;
+
+    BlockHeader header = {};
+    header.magic = BLOCK_MAGIC;
+    header.sequence = info.sequence;
+    header.first = info.first;
+    header.last = info.last;
+    header.count = info.count;
+    header.bits = info.bits;
+    header.crc = blockCrc(&header, payload(index), info.bits);
+
+    // Over the older copy: a torn write leaves the newer one intact
+    std::memcpy(block(index) + (info.sequence & 1) * sizeof(BlockHeader), &header, sizeof(header));
+}
+
+SeriesFile::BlockInfo SeriesFile::infoOf(size_t index) const {
+    if (index >= dirtyFrom_ && index - dirtyFrom_ < dirty_.size()) return dirty_[index - dirtyFrom_];
+
+    // Flushed in order, so its newest header is whole; open() checked the tail
+    BlockInfo info;
+    readHeader(index, info, /*verify=*/ false);
+    return info;
+}
+
+bool SeriesFile::reserve(size_t blocks) {
+    if (blocks <= mappedBlocks_) return true;
+
+    size_t grown = (blocks + GROW_BLOCKS - 1) / GROW_BLOCKS * GROW_BLOCKS;
+    size_t oldSize = (1 + mappedBlocks_) * BLOCK_SIZE;
+    size_t newSize = (1 + grown) * BLOCK_SIZE;
+    if (::ftruncate(fd_, static_cast<off_t>(newSize)) != 0) {
+        std::cerr << "[SeriesFile] Failed to grow " << path_ << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    void* map = ::mremap(map_, oldSize, newSize, MREMAP_MAYMOVE);
+    if (map == MAP_FAILED) {
+        std::cerr << "[SeriesFile] Failed to remap " << path_ << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    map_ = static_cast<uint8_t*>(map);
+    mappedBlocks_ = grown;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Appending
+// ---------------------------------------------------------------------------
+bool SeriesFile::append(int64_t timeMs, float value) {
+    if (!map_) return false;
+
+    uint32_t valueBits;
+    std::memcpy(&valueBits, &value, sizeof(valueBits));
+
+    if (blockCount_ > 0) {
+        BlockInfo& tail = dirty_.back();
+        timeMs = std::max(timeMs, tail.last);
+        if (tail.bits + MAX_SAMPLE_BITS <= MAX_BITS) {
+            encode(tail, timeMs, valueBits);
+            ++samples_;
+            unflushed_ = true;
+            return true;
+        }
+    }
+
+    // Start a block: the first time goes in the header, the first value in full
+    if (!reserve(blockCount_ + 1)) return false;
+    std::memset(block(blockCount_), 0, BLOCK_SIZE);   // may hold a block lost in a crash
+
+    BlockInfo info;
+    info.first = timeMs;
+    info.last = timeMs;
+    info.count = 1;
+    writeBits(payload(blockCount_), info.bits, valueBits, 32);
+
+    if (dirty_.empty()) dirtyFrom_ = blockCount_;
+    dirty_.push_back(info);
+    ++blockCount_;
+
+    prevDelta_ = 0;
+    prevValue_ = valueBits;
+    leading_ = -1;
+    length_ = 0;
+    ++samples_;
+    unflushed_ = true;
+    return true;
+}
+
+void SeriesFile::encode(BlockInfo& tail, int64_t timeMs, uint32_t valueBits) {
+    uint8_t* bytes = payload(blockCount_ - 1);
+
+    // Time: delta of the delta, in the smallest of five sizes
+    int64_t delta = timeMs - tail.last;
+    int64_t dod = delta - prevDelta_;
+    if (dod == 0) {
+        writeBits(bytes, tail.bits, 0b0, 1);
+    } else if (dod >= -63 && dod <= 64) {
+        writeBits(bytes, tail.bits, 0b10, 2);
+        writeBits(bytes, tail.bits, static_cast<uint64_t>(dod + 63), 7);
+    } else if (dod >= -255 && dod <= 256) {
+        writeBits(bytes, tail.bits, 0b110, 3);
+        writeBits(bytes, tail.bits, static_cast<uint64_t>(dod + 255), 9);
+    } else if (dod >= -2047 && dod <= 2048) {
+        writeBits(bytes, tail.bits, 0b1110, 4);
+        writeBits(bytes, tail.bits, static_cast<uint64_t>(dod + 2047), 12);
+    } else {
+        writeBits(bytes, tail.bits, 0b1111, 4);
+        writeBits(bytes, tail.bits, static_cast<uint64_t>(dod), 64);
+    }
+    prevDelta_ = delta;
+
+    // Value: XOR with the last one; only the bits that differ
+    uint32_t x = valueBits ^ prevValue_;
+    if (x == 0) {
+        writeBits(bytes, tail.bits, 0b0, 1);
+    } else {
+        int leading = __builtin_clz(x);
+        int trailing = __builtin_ctz(x);
+        if (leading_ >= 0 && leading >= leading_ && trailing >= 32 - leading_ - length_) {
+            // Fits the last window: no need to send it again
+            writeBits(bytes, tail.bits, 0b10, 2);
+            writeBits(bytes, tail.bits, x >> (32 - leading_ - length_), length_);
+        } else {
+            leading_ = leading;
+            length_ = 32 - leading - trailing;
+            writeBits(bytes, tail.bits, 0b11, 2);
+            writeBits(bytes, tail.bits, static_cast<uint64_t>(leading_), 5);
+            writeBits(bytes, tail.bits, static_cast<uint64_t>(length_ - 1), 5);
+            writeBits(bytes, tail.bits, x >> trailing, length_);
+        }
+    }
+    prevValue_ = valueBits;
+
+    tail.last = timeMs;
+    ++tail.count;
+}
+
+bool SeriesFile::flush() {
+    if (!map_ || !unflushed_) return true;
+
+    // The bits first, then the headers that cover them, in block order, so
+    // a valid header never points past bits that are still in memory
+    uint8_t* from = block(dirtyFrom_);
+    size_t size = dirty_.size() * BLOCK_SIZE;
+    bool ok = ::msync(from, size, MS_SYNC) == 0;
+    for (size_t i = 0; ok && i < dirty_.size(); ++i) {
+        writeHeader(dirtyFrom_ + i, dirty_[i]);
+        ok = ::msync(block(dirtyFrom_ + i), BLOCK_SIZE, MS_SYNC) == 0;
+    }
+    if (!ok) {
+        std::cerr << "[SeriesFile] Failed to sync " << path_ << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    // Full blocks are done; only the last is still appended to
+    dirtyFrom_ = blockCount_ - 1;
+    dirty_.erase(dirty_.begin(), dirty_.end() - 1);
+    unflushed_ = false;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Reading
+// ---------------------------------------------------------------------------
+void SeriesFile::read(int64_t fromMs, int64_t toMs, const Visitor& visit) const {
+    if (!map_ || fromMs >= toMs) return;
+
+    // First block that reaches fromMs
+    size_t lo = 0;
+    size_t hi = blockCount_;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (infoOf(mid).last < fromMs) lo = mid + 1;
+        else hi = mid;
+    }
+
+    for (size_t i = lo; i < blockCount_; ++i) {
+        BlockInfo info = infoOf(i);
+        if (info.count == 0) continue;
+        if (info.first >= toMs) return;
+
+        BlockDecoder decoder(payload(i), info.first, info.count);
+        do {
+            if (decoder.time >= toMs) return;
+            if (decoder.time >= fromMs) visit(decoder.time, decoder.current());
+        } while (decoder.next() && decoder.bits.pos() <= info.bits);
+    }
+}
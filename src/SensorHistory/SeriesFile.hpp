@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Append-only, memory-mapped file of one sensor series, Gorilla-compressed.
+ *
+ * The file is a 4 KB header page followed by 4 KB blocks, each holding a
+ * run of (time, value) samples encoded as in Facebook's Gorilla:
+ * - times as delta-of-delta, so a steady 5 s or 200 ms period costs 1 bit
+ *   and a few ms of jitter about 9
+ * - values (32-bit floats) XORed with the previous one, so a repeat costs
+ *   1 bit and a small change only its meaningful bits
+ *
+ * Blocks are written in time order and never rewritten once full, so the
+ * blocks themselves are the index: a range query binary-searches block
+ * headers for its start and decodes from there, touching only the blocks
+ * it returns.
+ *
+ * Crash safety: append() only adds bits after the last flushed ones, in
+ * place in the mapping. flush() syncs those bits, then writes the block's
+ * header, with a CRC of the header and its bits, into the older of two
+ * header slots, and syncs that. On open, the newest slot whose CRC matches
+ * wins. A crash at any point therefore loses at most the samples since the
+ * last flush, and never leaves a block that decodes to garbage.
+ *
+ * Byte order is the host's (little-endian on the Pi).
+ *
+ * Not thread-safe; SeriesArchive gives each file to one thread.
+ *
+ * Usage:
+ * @code
+ *   SeriesFile file("/var/lib/pifridge/history/temperature-2026-10-15.series");
+ *   if (file.open()) {
+ *       file.append(nowMs, 4.2f);
+ *       file.flush();
+ *       file.read(fromMs, toMs, [](int64_t time, float value) { ... });
+ *   }
+ * @endcode
+ */
+class SeriesFile {
+public:
+    using Visitor = std::function<void(int64_t timeMs, float value)>;
+
+    static constexpr size_t BLOCK_SIZE = 4096;
+
+    explicit SeriesFile(std::string path);
+    ~SeriesFile();
+
+    SeriesFile(const SeriesFile&) = delete;
+    SeriesFile& operator=(const SeriesFile&) = delete;
+
+    /**
+     * @brief Open or create the file and map it.
+     *
+     * Finds the last block by binary search and decodes only that one, to
+     * carry on appending where the last flush left off.
+     *
+     * @return false if it can't be opened, or isn't a series file.
+     */
+    bool open();
+
+    /**
+     * @brief Add a sample. Times before the last sample are raised to it.
+     * @return false if the file could not be grown.
+     */
+    bool append(int64_t timeMs, float value);
+
+    /** Make every sample appended so far survive a crash. */
+    bool flush();
+
+    /** Call @p visit for each sample in [fromMs, toMs), in time order. */
+    void read(int64_t fromMs, int64_t toMs, const Visitor& visit) const;
+
+    /** Samples appended since open(), flushed or not. */
+    uint64_t samples() const { return samples_; }
+
+    /** Bytes of blocks in use, the header page included. */
+    uint64_t bytesUsed() const { return (1 + blockCount_) * static_cast<uint64_t>(BLOCK_SIZE); }
+
+private:
+    struct BlockHeader {
+        uint32_t magic;
+        uint32_t sequence;   // higher of the two valid slots wins
+        int64_t  first;      // time of the first sample, stored in full
+        int64_t  last;
+        uint32_t count;
+        uint32_t bits;       // payload bits in use
+        uint32_t crc;        // of the fields above and those bits
+        uint32_t reserved;
+    };
+
+    /** Where a block's samples stand, whether flushed or not. */
+    struct BlockInfo {
+        int64_t  first = 0;
+        int64_t  last = 0;
+        uint32_t count = 0;
+        uint32_t bits = 0;
+        uint32_t sequence = 0;
+    };
+
+    static constexpr size_t HEADERS_BYTES = 2 * sizeof(BlockHeader);
+    static constexpr size_t PAYLOAD_BYTES = BLOCK_SIZE - HEADERS_BYTES;
+
+    // The decoder loads 8 bytes at a time and may read a sample past the
+    // last; the slack keeps that inside the block
+    static constexpr uint32_t MAX_BITS = (PAYLOAD_BYTES - 24) * 8;
+
+    uint8_t* block(size_t index) const;
+    uint8_t* payload(size_t index) const { return block(index) + HEADERS_BYTES; }
+
+    /**
+     * @brief The newest valid header of @p index; false if it has none.
+     * @param verify Also check the CRC, for headers a crash may have torn.
+     */
+    bool readHeader(size_t index, BlockInfo& info, bool verify) const;
+    void writeHeader(size_t index, BlockInfo& info);
+    BlockInfo infoOf(size_t index) const;
+
+    /** Map at least @p blocks blocks, growing the file if needed. */
+    bool reserve(size_t blocks);
+
+    /** Restore the encoder from the last block's samples. */
+    void resume();
+
+    /** Encode one sample after the first of the last block. */
+    void encode(BlockInfo& tail, int64_t timeMs, uint32_t valueBits);
+
+    std::string path_;
+    int fd_ = -1;
+    uint8_t* map_ = nullptr;
+    size_t mappedBlocks_ = 0;
+
+    size_t blockCount_ = 0;        // blocks with samples; the last is being appended to
+    size_t dirtyFrom_ = 0;         // first block whose header is behind
+    std::vector<BlockInfo> dirty_; // infos of blocks dirtyFrom_ onwards
+    uint64_t samples_ = 0;
+    bool unflushed_ = false;
+
+    // Encoder state of the last block
+    int64_t  prevDelta_ = 0;
+    uint32_t prevValue_ = 0;
+    int      leading_ = -1;        // window of the last '11' value; -1 before the first
+    int      length_ = 0;
+};
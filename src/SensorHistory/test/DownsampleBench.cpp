@@ -0,0 +1,95 @@
+// DownsampleBench.cpp
+// Cost of GET /api/fridge/history for a day-long chart, by ?step= and by ?points=.
+//
+// Fills a SensorHistory with 24 h of every series (the BME680 every 5 s,
+// lux every 200 ms), then times writing the history JSON:
+// - at step=5, every BME680 sample: what a chart drew before ?points=
+// - at points=400 by LTTB and by min/max envelope, for a 400-px sparkline
+// and the downsample() call alone on the 432,000 lux samples.
+//
+// Run:
+//   ./build/src/SensorHistory/downsample_bench [iterations]
+
+#include "../SensorHistory.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+static const int64_t T0 = 1759996800000;
+static const int64_t DAY_MS = 24 * SensorHistory::HOUR_MS;
+
+template <class Write>
+static void report(const char* name, int iterations, Write write) {
+    std::string body;
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        body.clear();
+        JsonWriter json = JsonWriter::toString(body);
+        write(json);
+        json.flush();
+    }
+    std::cout << std::left << std::setw(26) << name << std::right
+              << std::setw(12) << body.size()
+              << std::setw(14) << std::fixed << std::setprecision(0) << elapsedUs(start) / iterations << "\n";
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 20;
+    if (iterations < 1) iterations = 1;
+
+    SensorHistory history;
+    for (int64_t time = T0; time < T0 + DAY_MS; time += 5000) {
+        double hours = static_cast<double>(time - T0) / SensorHistory::HOUR_MS;
+        history.record(SensorHistory::TEMPERATURE, time, 4.0 + std::sin(hours * 9.0));
+        history.record(SensorHistory::HUMIDITY, time, 50.0 + 8.0 * std::sin(hours));
+        history.record(SensorHistory::PRESSURE, time, 1013.0 + std::sin(hours / 3.0));
+        history.record(SensorHistory::GAS, time, 120000.0 + 20000.0 * std::sin(hours / 5.0));
+    }
+    for (int64_t time = T0; time < T0 + DAY_MS; time += 200) {
+        bool open = (time / 1000) % 7200 < 30;   // the door, 30 s every 2 h
+        history.record(SensorHistory::LUX, time, open ? 300.0 + static_cast<double>(time % 7) : 0.0);
+    }
+
+    const int64_t from = T0;
+    const int64_t to = T0 + DAY_MS;
+    std::cout << "24 h of all series, " << iterations << " iterations\n\n"
+              << std::left << std::setw(26) << "request" << std::right
+              << std::setw(12) << "JSON bytes" << std::setw(14) << "us/request" << "\n";
+
+    report("step=5", iterations, [&](JsonWriter& json) {
+        history.writeJson(from, to, 5000, SensorHistory::ALL_SERIES, json);
+    });
+    report("step=300", iterations, [&](JsonWriter& json) {
+        history.writeJson(from, to, 300000, SensorHistory::ALL_SERIES, json);
+    });
+    report("points=400&mode=lttb", iterations, [&](JsonWriter& json) {
+        history.writeDownsampledJson(from, to, 400, SensorHistory::Downsample::LTTB, SensorHistory::ALL_SERIES, json);
+    });
+    report("points=400&mode=minmax", iterations, [&](JsonWriter& json) {
+        history.writeDownsampledJson(from, to, 400, SensorHistory::Downsample::MINMAX, SensorHistory::ALL_SERIES,
+                                     json);
+    });
+
+    std::cout << "\ndownsample() alone, lux (432,000 samples) to 400 points\n";
+    for (auto mode : { SensorHistory::Downsample::LTTB, SensorHistory::Downsample::MINMAX }) {
+        size_t points = 0;
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; ++i) points += history.downsample(SensorHistory::LUX, from, to, 400, mode).size();
+        double us = elapsedUs(start) / iterations;
+        std::cout << std::left << std::setw(26) << SensorHistory::nameOf(mode) << std::right
+                  << std::setw(12) << points / static_cast<size_t>(iterations)
+                  << std::setw(14) << std::setprecision(0) << us
+                  << "   (" << std::setprecision(0) << 432000.0 / us << " M samples/s)\n";
+    }
+    return 0;
+}
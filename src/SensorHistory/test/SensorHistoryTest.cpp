@@ -0,0 +1,355 @@
+// SensorHistoryTest.cpp
+// Checks that SensorHistory's minute and hour roll-ups give the same points
+// as aggregating the raw samples, that the rings wrap and keep time order,
+// how stepFor() picks a step, the JSON served at /api/fridge/history, and
+// that downsample() matches straightforward LTTB and min/max envelopes.
+
+#include "../SensorHistory.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void expectTrue(bool condition, const std::string& message, int& failures) {
+    if (!condition) {
+        std::cout << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+static void expectEqual(const std::string& actual, const std::string& expected,
+                        const std::string& message, int& failures) {
+    if (actual != expected) {
+        std::cout << "FAIL: " << message
+                  << " expected \"" << expected
+                  << "\" got \"" << actual << "\"\n";
+        ++failures;
+    }
+}
+
+static bool samePoints(const std::vector<SensorHistory::Point>& a, const std::vector<SensorHistory::Point>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].time != b[i].time || a[i].count != b[i].count || a[i].min != b[i].min ||
+            a[i].max != b[i].max || std::fabs(a[i].sum - b[i].sum) > 1e-6 * std::fabs(b[i].sum) + 1e-9) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Aggregate @p samples the way query() should, without any roll-up
+static std::vector<SensorHistory::Point> bruteForce(const std::vector<std::pair<int64_t, float>>& samples,
+                                                    int64_t from, int64_t to, int64_t step) {
+    std::vector<SensorHistory::Point> points;
+    from = from / step * step;
+    to = (to - 1) / step * step + step;
+    for (const auto& sample : samples) {
+        if (sample.first < from || sample.first >= to) continue;
+        int64_t start = sample.first / step * step;
+        if (points.empty() || points.back().time != start) {
+            SensorHistory::Point point;
+            point.time = start;
+            point.min = point.max = sample.second;
+            points.push_back(point);
+        }
+        SensorHistory::Point& point = points.back();
+        point.min = std::min(point.min, static_cast<double>(sample.second));
+        point.max = std::max(point.max, static_cast<double>(sample.second));
+        point.sum += sample.second;
+        ++point.count;
+    }
+    return points;
+}
+
+// Equal-width slices, as downsample(MINMAX) should give
+static std::vector<SensorHistory::Point> bruteEnvelope(const std::vector<std::pair<int64_t, float>>& samples,
+                                                       int64_t from, int64_t to, int64_t points) {
+    std::vector<SensorHistory::Point> out;
+    int64_t width = (to - from + points - 1) / points;
+    for (const auto& sample : samples) {
+        if (sample.first < from || sample.first >= to) continue;
+        int64_t start = from + (sample.first - from) / width * width;
+        if (out.empty() || out.back().time != start) {
+            SensorHistory::Point point;
+            point.time = start;
+            point.min = point.max = sample.second;
+            out.push_back(point);
+        }
+        SensorHistory::Point& point = out.back();
+        point.min = std::min(point.min, static_cast<double>(sample.second));
+        point.max = std::max(point.max, static_cast<double>(sample.second));
+        point.sum += sample.second;
+        ++point.count;
+    }
+    return out;
+}
+
+// Largest-Triangle-Three-Buckets as in the paper, over a plain array
+static std::vector<std::pair<int64_t, float>> referenceLttb(const std::vector<std::pair<int64_t, float>>& data,
+                                                            size_t points) {
+    size_t n = data.size();
+    if (n <= points) return data;
+
+    std::vector<std::pair<int64_t, float>> out{ data[0] };
+    size_t slices = points - 2;
+    auto boundary = [&](size_t b) { return std::min<size_t>(1 + b * (n - 2) / slices, n); };
+    size_t a = 0;
+    for (size_t b = 0; b < slices; ++b) {
+        size_t start = boundary(b), end = boundary(b + 1);
+        size_t nextEnd = b + 1 < slices ? boundary(b + 2) : n;
+        double cx = 0.0, cy = 0.0;
+        for (size_t i = end; i < nextEnd; ++i) {
+            cx += static_cast<double>(data[i].first - data[0].first);
+            cy += data[i].second;
+        }
+        cx /= static_cast<double>(nextEnd - end);
+        cy /= static_cast<double>(nextEnd - end);
+
+        double ax = static_cast<double>(data[a].first - data[0].first), ay = data[a].second;
+        double largest = -1.0;
+        size_t chosen = start;
+        for (size_t i = start; i < end; ++i) {
+            double x = static_cast<double>(data[i].first - data[0].first);
+            double area = std::fabs((ax - cx) * (data[i].second - ay) - (ax - x) * (cy - ay));
+            if (area > largest) {
+                largest = area;
+                chosen = i;
+            }
+        }
+        out.push_back(data[chosen]);
+        a = chosen;
+    }
+    out.push_back(data[n - 1]);
+    return out;
+}
+
+static bool sameSamples(const std::vector<SensorHistory::Point>& points,
+                        const std::vector<std::pair<int64_t, float>>& samples) {
+    if (points.size() != samples.size()) return false;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (points[i].time != samples[i].first || points[i].count != 1 ||
+            points[i].min != static_cast<double>(samples[i].second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    int failures = 0;
+    const int64_t MINUTE = SensorHistory::MINUTE_MS;
+    const int64_t HOUR   = SensorHistory::HOUR_MS;
+    const int64_t T0     = 1759996800000;   // an hour boundary, October 2025
+
+    // -- Roll-ups agree with the raw samples --
+    {
+        SensorHistory history;
+        std::vector<std::pair<int64_t, float>> samples;
+        for (int64_t i = 0; i < 3 * 720; ++i) {               // 3 h at 5 s
+            int64_t time = T0 + i * 5000 + 7;
+            float value = static_cast<float>(4.0 + std::sin(static_cast<double>(i) / 40.0));
+            history.record(SensorHistory::TEMPERATURE, time, value);
+            samples.emplace_back(time, value);
+        }
+
+        int64_t from = T0 + 17 * MINUTE;
+        int64_t to   = T0 + 2 * HOUR + 43 * MINUTE;
+        expectTrue(samePoints(history.query(SensorHistory::TEMPERATURE, from, to, MINUTE),
+                              bruteForce(samples, from, to, MINUTE)), "minute roll-up should match raw", failures);
+        expectTrue(samePoints(history.query(SensorHistory::TEMPERATURE, from, to, 5 * MINUTE),
+                              bruteForce(samples, from, to, 5 * MINUTE)), "5-minute steps should match raw", failures);
+        expectTrue(samePoints(history.query(SensorHistory::TEMPERATURE, T0, T0 + 3 * HOUR, HOUR),
+                              bruteForce(samples, T0, T0 + 3 * HOUR, HOUR)), "hour roll-up should match raw", failures);
+        expectTrue(samePoints(history.query(SensorHistory::TEMPERATURE, from, to, 10 * 1000),
+                              bruteForce(samples, from, to, 10 * 1000)), "10 s steps should read raw", failures);
+
+        auto hours = history.query(SensorHistory::TEMPERATURE, T0, T0 + 3 * HOUR, HOUR);
+        expectEqual(std::to_string(hours.size()), "3", "three hour points", failures);
+        expectTrue(!hours.empty() && hours[0].count == 720, "an hour at 5 s is 720 samples", failures);
+        expectTrue(history.query(SensorHistory::LUX, T0, T0 + HOUR, MINUTE).empty(),
+                   "other series should be untouched", failures);
+        expectTrue(history.query(SensorHistory::TEMPERATURE, T0 + 5 * HOUR, T0 + 6 * HOUR, MINUTE).empty(),
+                   "a range with no samples should be empty", failures);
+    }
+
+    // -- Rings wrap, and a clock stepping back keeps them in order --
+    {
+        // One sample an hour: a raw ring of 24
+        SensorHistory history({ HOUR, HOUR, HOUR, HOUR, HOUR });
+        for (int64_t i = 0; i < 30; ++i) history.record(SensorHistory::GAS, T0 + i * HOUR, static_cast<double>(i));
+
+        auto raw = history.query(SensorHistory::GAS, T0, T0 + 30 * HOUR, 1000);
+        expectEqual(std::to_string(raw.size()), "24", "raw ring should keep its 24 newest", failures);
+        expectTrue(!raw.empty() && raw.front().min == 6.0 && raw.back().min == 29.0, "oldest six overwritten", failures);
+        expectEqual(std::to_string(history.query(SensorHistory::GAS, T0, T0 + 30 * HOUR, HOUR).size()), "30",
+                    "hour roll-up should keep all 30", failures);
+
+        history.record(SensorHistory::GAS, T0 + 10 * HOUR, 100.0);   // clock stepped back
+        auto last = history.query(SensorHistory::GAS, T0 + 29 * HOUR, T0 + 30 * HOUR, 1000);
+        expectTrue(last.size() == 1 && last[0].count == 2 && last[0].max == 100.0,
+                   "a sample from the past should be recorded at the latest time", failures);
+    }
+
+    // -- stepFor --
+    {
+        int64_t now = T0 + 100 * 24 * HOUR;
+        auto step = [now](int64_t from, int64_t to, int64_t requested) {
+            return std::to_string(SensorHistory::stepFor(from, to, requested, now) / 1000);
+        };
+        expectEqual(step(now - HOUR, now, 0), "1", "at least one second", failures);
+        expectEqual(step(now - HOUR, now, 5000), "5", "a fine step in the last day is kept", failures);
+        expectEqual(step(now - 24 * HOUR, now, 1000), "18", "raised to 5000 points, in whole seconds", failures);
+        expectEqual(step(now - 2 * 24 * HOUR, now - 47 * HOUR, 1000), "60",
+                    "past raw retention: at least a minute", failures);
+        expectEqual(step(now - 8 * 24 * HOUR, now - 8 * 24 * HOUR + HOUR, 1000), "3600",
+                    "past minute retention: at least an hour", failures);
+        expectEqual(step(now - HOUR, now, 90 * 1000), "120", "rounded up to whole minutes", failures);
+        expectEqual(step(now - 24 * HOUR, now, 90 * MINUTE), "7200", "rounded up to whole hours", failures);
+    }
+
+    // -- JSON and ?series= --
+    {
+        SensorHistory history;
+        history.record(SensorHistory::TEMPERATURE, T0 + 1000, 4.0);
+        history.record(SensorHistory::TEMPERATURE, T0 + 6000, 5.0);
+        history.record(SensorHistory::LUX, T0 + 200, 12.5);
+
+        unsigned mask = 0;
+        expectTrue(SensorHistory::parseSeries("temperature,lux", mask), "known series should parse", failures);
+        expectTrue(!SensorHistory::parseSeries("temperature,colour", mask), "unknown series should fail", failures);
+        expectTrue(!SensorHistory::parseSeries("", mask), "empty list should fail", failures);
+
+        std::string out;
+        JsonWriter json = JsonWriter::toString(out);
+        history.writeJson(T0, T0 + MINUTE, MINUTE, (1u << SensorHistory::TEMPERATURE) | (1u << SensorHistory::LUX),
+                          json);
+        json.flush();
+        expectEqual(out,
+                    "{\"from\":1759996800,\"to\":1759996860,\"step\":60,\"series\":{"
+                    "\"temperature\":[[1759996800,4.50,4.00,5.00]],"
+                    "\"lux\":[[1759996800,12.50,12.50,12.50]]}}",
+                    "history JSON", failures);
+    }
+
+    // -- downsample: LTTB and min/max envelope --
+    {
+        // 1000 raw slots, so 3000 samples wrap the ring twice
+        SensorHistory history({ 86, 86, 86, 86, 86 });
+        std::vector<std::pair<int64_t, float>> samples;
+        for (int64_t i = 0; i < 3000; ++i) {
+            int64_t time = T0 + i * 86 + (i % 3);
+            float value = static_cast<float>(std::sin(static_cast<double>(i) / 25.0) * 10.0 + (i % 7 == 0 ? 4.0 : 0.0));
+            history.record(SensorHistory::LUX, time, value);
+            samples.emplace_back(time, value);
+        }
+        std::vector<std::pair<int64_t, float>> kept(samples.end() - 1000, samples.end());
+        int64_t from = kept.front().first;
+        int64_t to = kept.back().first + 1;
+
+        auto points = history.downsample(SensorHistory::LUX, from, to, 50, SensorHistory::Downsample::LTTB);
+        expectEqual(std::to_string(points.size()), "50", "LTTB gives the points asked for", failures);
+        expectTrue(sameSamples(points, referenceLttb(kept, 50)), "LTTB should match the reference, across the wrap",
+                   failures);
+
+        auto few = history.downsample(SensorHistory::LUX, from, kept[10].first, 50,
+                                      SensorHistory::Downsample::LTTB);
+        expectTrue(sameSamples(few, std::vector<std::pair<int64_t, float>>(kept.begin(), kept.begin() + 10)),
+                   "fewer samples than points: all of them", failures);
+
+        for (int64_t target : { 1, 7, 64, 999, 5000 }) {
+            expectTrue(samePoints(history.downsample(SensorHistory::LUX, from, to, static_cast<size_t>(target),
+                                                     SensorHistory::Downsample::MINMAX),
+                                  bruteEnvelope(kept, from, to, std::max<int64_t>(target, 2))),
+                       "envelope of " + std::to_string(target) + " should match brute force", failures);
+        }
+        expectTrue(history.downsample(SensorHistory::TEMPERATURE, from, to, 50,
+                                      SensorHistory::Downsample::LTTB).empty(), "empty series", failures);
+    }
+
+    // -- downsample: ranges the raw ring no longer holds read roll-ups --
+    {
+        SensorHistory history({ HOUR, HOUR, HOUR, HOUR, HOUR });
+        for (int64_t i = 0; i < 30; ++i) history.record(SensorHistory::GAS, T0 + i * HOUR, static_cast<double>(i));
+
+        auto envelope = history.downsample(SensorHistory::GAS, T0, T0 + 30 * HOUR, 3,
+                                           SensorHistory::Downsample::MINMAX);
+        expectTrue(envelope.size() == 3 && envelope[0].count == 10 && envelope[0].min == 0.0 &&
+                   envelope[2].max == 29.0, "evicted raw samples come from minute buckets", failures);
+
+        auto line = history.downsample(SensorHistory::GAS, T0, T0 + 30 * HOUR, 30, SensorHistory::Downsample::LTTB);
+        expectTrue(line.size() == 30 && line[0].time == T0 && line[0].min == 0.0,
+                   "LTTB over buckets keeps their averages", failures);
+    }
+
+    // -- downsample: hours restored from the archive, and a gap since --
+    {
+        SensorHistory history;
+        const int64_t DAY = 24 * HOUR;
+        const int64_t now = T0 + 30 * DAY;
+        for (int64_t t = T0; t < now - 7 * DAY; t += HOUR) {
+            SensorHistory::Point hour;
+            hour.time = t;
+            hour.min = hour.max = hour.sum = 2.0;
+            hour.count = 1;
+            history.restoreHour(SensorHistory::TEMPERATURE, hour);
+        }
+        // A sample a minute since, with an hour's outage: neither the raw
+        // nor the minute ring is full, and neither reaches back
+        for (int64_t t = now - 7 * DAY; t < now; t += MINUTE) {
+            if (t >= now - 3 * DAY && t < now - 3 * DAY + HOUR) continue;
+            history.record(SensorHistory::TEMPERATURE, t, 4.0);
+        }
+
+        auto month = history.downsample(SensorHistory::TEMPERATURE, T0, now, 30,
+                                        SensorHistory::Downsample::MINMAX);
+        expectTrue(month.size() == 30 && month[0].time == T0 && month[0].min == 2.0 &&
+                   month[29].max == 4.0, "a month reads the restored hours, gap or no gap", failures);
+
+        auto week = history.downsample(SensorHistory::TEMPERATURE, now - 7 * DAY, now, 7,
+                                       SensorHistory::Downsample::MINMAX);
+        expectTrue(week.size() == 7 && week[0].count == 1440 && week[0].min == 4.0,
+                   "a week the raw ring reaches back to reads raw samples", failures);
+    }
+
+    // -- Downsampled JSON and ?mode= --
+    {
+        SensorHistory history;
+        history.record(SensorHistory::LUX, T0 + 200, 12.5);
+        history.record(SensorHistory::LUX, T0 + 400, 0.0);
+        history.record(SensorHistory::LUX, T0 + 600, 3.0);
+
+        SensorHistory::Downsample mode = SensorHistory::Downsample::MINMAX;
+        expectTrue(SensorHistory::parseDownsample("lttb", mode) && mode == SensorHistory::Downsample::LTTB,
+                   "lttb should parse", failures);
+        expectTrue(!SensorHistory::parseDownsample("m4", mode), "unknown mode should fail", failures);
+
+        std::string out;
+        JsonWriter json = JsonWriter::toString(out);
+        history.writeDownsampledJson(T0, T0 + 1000, 2, SensorHistory::Downsample::LTTB,
+                                     1u << SensorHistory::LUX, json);
+        json.flush();
+        expectEqual(out,
+                    "{\"from\":1759996800,\"to\":1759996801,\"points\":2,\"mode\":\"lttb\",\"series\":{"
+                    "\"lux\":[[1759996800.200,12.50],[1759996800.600,3.00]]}}",
+                    "LTTB JSON", failures);
+
+        out.clear();
+        JsonWriter minmax = JsonWriter::toString(out);
+        history.writeDownsampledJson(T0, T0 + 1000, 2, SensorHistory::Downsample::MINMAX,
+                                     1u << SensorHistory::LUX, minmax);
+        minmax.flush();
+        expectEqual(out,
+                    "{\"from\":1759996800,\"to\":1759996801,\"points\":2,\"mode\":\"minmax\",\"series\":{"
+                    "\"lux\":[[1759996800.000,6.25,0.00,12.50],[1759996800.500,3.00,3.00,3.00]]}}",
+                    "envelope JSON", failures);
+    }
+
+    if (failures == 0) {
+        std::cout << "PASS\n";
+        return 0;
+    }
+    std::cout << "FAILURES: " << failures << "\n";
+    return 1;
+}
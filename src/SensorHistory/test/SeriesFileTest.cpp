@@ -0,0 +1,295 @@
+// SeriesFileTest.cpp
+// Checks that SeriesFile gives back exactly the samples appended, across
+// blocks, file growth and reopening; that range queries match a scan; and
+// that a crash, or a torn block header, loses only unflushed samples.
+// Also that SeriesArchive keeps a file per week for 90 days, and that its
+// files replay into a SensorHistory, hours past the last week as hours.
+
+#include "../SeriesArchive.hpp"
+#include "../SeriesFile.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+static void expectTrue(bool condition, const std::string& message, int& failures) {
+    if (!condition) {
+        std::cout << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+static void expectEqual(const std::string& actual, const std::string& expected,
+                        const std::string& message, int& failures) {
+    if (actual != expected) {
+        std::cout << "FAIL: " << message
+                  << " expected \"" << expected
+                  << "\" got \"" << actual << "\"\n";
+        ++failures;
+    }
+}
+
+struct Sample {
+    int64_t time;
+    float   value;
+};
+
+// Bit for bit, so NaN and -0.0 count
+static bool sameSamples(const std::vector<Sample>& a, const std::vector<Sample>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].time != b[i].time || std::memcmp(&a[i].value, &b[i].value, sizeof(float)) != 0) return false;
+    }
+    return true;
+}
+
+static std::vector<std::string> listDirectory(const std::string& directory) {
+    std::vector<std::string> names;
+    DIR* dir = ::opendir(directory.c_str());
+    if (!dir) return names;
+    while (dirent* entry = ::readdir(dir)) {
+        if (entry->d_name[0] != '.') names.push_back(entry->d_name);
+    }
+    ::closedir(dir);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+static std::vector<Sample> readAll(const SeriesFile& file, int64_t from, int64_t to) {
+    std::vector<Sample> out;
+    file.read(from, to, [&out](int64_t time, float value) { out.push_back({ time, value }); });
+    return out;
+}
+
+static std::vector<Sample> scan(const std::vector<Sample>& samples, int64_t from, int64_t to) {
+    std::vector<Sample> out;
+    for (const Sample& sample : samples) {
+        if (sample.time >= from && sample.time < to) out.push_back(sample);
+    }
+    return out;
+}
+
+// Sensor-like samples: 5 s with jitter, noisy values, repeats, and the odd
+// gap, step back or special value
+static std::vector<Sample> makeSamples(size_t count, int64_t start) {
+    std::vector<Sample> samples;
+    uint32_t seed = 12345;
+    auto random = [&seed] { seed = seed * 1103515245u + 12345u; return (seed >> 16) & 0x7FFF; };
+
+    int64_t time = start;
+    float value = 4.0f;
+    for (size_t i = 0; i < count; ++i) {
+        time += 5000 + static_cast<int64_t>(random() % 9) - 4;
+        if (i % 5000 == 4999) time += 3 * 3600 * 1000;            // pifridge was down
+        if (i == count / 2) time += int64_t(40) * 24 * 3600 * 1000; // past 32 bits of ms
+
+        if (random() % 4 != 0) value = 4.0f + static_cast<float>(random() % 1000) / 997.0f;
+        float stored = value;
+        if (i == 100) stored = std::numeric_limits<float>::quiet_NaN();
+        if (i == 101) stored = -0.0f;
+        if (i == 102) stored = 1.0e30f;
+        samples.push_back({ time, stored });
+    }
+    return samples;
+}
+
+int main() {
+    int failures = 0;
+    const int64_t T0 = 1759996800000;
+    const std::string path = "/tmp/series_file_test_" + std::to_string(::getpid()) + ".series";
+    std::remove(path.c_str());
+
+    // Enough to grow the file past its first 64 blocks
+    const std::vector<Sample> samples = makeSamples(120000, T0);
+
+    // -- Round trip and range queries --
+    {
+        SeriesFile file(path);
+        expectTrue(file.open(), "a new file should open", failures);
+        for (const Sample& sample : samples) file.append(sample.time, sample.value);
+        expectTrue(file.bytesUsed() > 65 * SeriesFile::BLOCK_SIZE, "file should have grown", failures);
+
+        expectTrue(sameSamples(readAll(file, INT64_MIN, INT64_MAX), samples),
+                   "unflushed samples should read back exactly", failures);
+
+        file.flush();
+        const int64_t last = samples.back().time;
+        const int64_t ranges[][2] = {
+            { T0, T0 + 60000 },                      // start of the first block
+            { T0 + 3600 * 1000, T0 + 2 * 3600 * 1000 },
+            { samples[70000].time, samples[70001].time },   // one sample
+            { samples[5000].time - 1000, samples[5000].time },   // in a gap
+            { last - 86400 * 1000, last + 1 },       // the last block
+            { last + 1, last + 1000 },               // after the end
+        };
+        for (const auto& range : ranges) {
+            expectTrue(sameSamples(readAll(file, range[0], range[1]), scan(samples, range[0], range[1])),
+                       "range " + std::to_string(range[0]) + ".." + std::to_string(range[1]), failures);
+        }
+
+        // Blocks are small enough that sensor data stays compressed
+        double bytesPerSample = static_cast<double>(file.bytesUsed()) / static_cast<double>(samples.size());
+        expectTrue(bytesPerSample < 5.0, "under 5 bytes a sample", failures);
+    }
+
+    // -- Reopen and carry on appending --
+    {
+        SeriesFile file(path);
+        expectTrue(file.open(), "the file should reopen", failures);
+        expectTrue(sameSamples(readAll(file, INT64_MIN, INT64_MAX), samples), "reopened samples", failures);
+
+        std::vector<Sample> more = samples;
+        int64_t time = samples.back().time;
+        for (int i = 0; i < 1000; ++i) {
+            time += 200;
+            more.push_back({ time, static_cast<float>(i % 7) });
+            file.append(time, static_cast<float>(i % 7));
+        }
+        file.append(time - 5000, 3.0f);   // clock stepped back
+        more.push_back({ time, 3.0f });
+        expectTrue(sameSamples(readAll(file, INT64_MIN, INT64_MAX), more),
+                   "appends after reopening should follow on", failures);
+        expectEqual(std::to_string(file.samples()), "1001", "samples since open", failures);
+    }
+
+    // -- A crash loses only what was not flushed --
+    std::vector<Sample> flushed;
+    {
+        SeriesFile reader(path);
+        reader.open();
+        flushed = readAll(reader, INT64_MIN, INT64_MAX);
+    }
+    {
+        pid_t child = ::fork();
+        if (child == 0) {
+            SeriesFile file(path);
+            file.open();
+            int64_t time = flushed.back().time;
+            for (int i = 0; i < 3000; ++i) file.append(time + 1000 * (i + 1), 9.0f);
+            ::_exit(0);   // no flush, no destructor: the bits reach the file, the header doesn't
+        }
+        int status = 0;
+        ::waitpid(child, &status, 0);
+
+        SeriesFile file(path);
+        expectTrue(file.open(), "the file should open after a crash", failures);
+        expectTrue(sameSamples(readAll(file, INT64_MIN, INT64_MAX), flushed),
+                   "unflushed samples should be gone, flushed ones kept", failures);
+
+        // And appending over the lost bits works
+        file.append(flushed.back().time + 1, 1.5f);
+        file.flush();
+        std::vector<Sample> expected = flushed;
+        expected.push_back({ flushed.back().time + 1, 1.5f });
+        expectTrue(sameSamples(readAll(file, INT64_MIN, INT64_MAX), expected), "append after a crash", failures);
+        flushed = expected;
+    }
+
+    // -- A torn header falls back to the other copy --
+    {
+        std::vector<Sample> before = flushed;
+        size_t tailBlock;
+        {
+            SeriesFile file(path);
+            file.open();
+            tailBlock = static_cast<size_t>(file.bytesUsed() / SeriesFile::BLOCK_SIZE) - 2;
+            file.append(flushed.back().time + 1000, 2.5f);
+            file.flush();
+        }
+
+        // Header copies are 40 bytes each at the start of the block; the
+        // sequence is the second word. Garble the newer copy's last byte.
+        int fd = ::open(path.c_str(), O_RDWR);
+        off_t blockAt = static_cast<off_t>((1 + tailBlock) * SeriesFile::BLOCK_SIZE);
+        uint32_t seq[2] = {};
+        ::pread(fd, &seq[0], 4, blockAt + 4);
+        ::pread(fd, &seq[1], 4, blockAt + 40 + 4);
+        off_t newer = blockAt + (seq[1] > seq[0] ? 40 : 0);
+        uint8_t garbage = 0x5A;
+        ::pwrite(fd, &garbage, 1, newer + 30);
+        ::close(fd);
+
+        SeriesFile file(path);
+        expectTrue(file.open(), "the file should open with a torn header", failures);
+        expectTrue(sameSamples(readAll(file, INT64_MIN, INT64_MAX), before),
+                   "the older header copy should be used", failures);
+    }
+
+    // -- Not a series file --
+    {
+        const std::string other = path + ".txt";
+        std::FILE* text = std::fopen(other.c_str(), "w");
+        std::fputs("temperature,4.2\n", text);
+        std::fclose(text);
+
+        SeriesFile file(other);
+        expectTrue(!file.open(), "another file should be refused", failures);
+        expectTrue(!file.append(T0, 1.0f), "a refused file takes no samples", failures);
+        std::remove(other.c_str());
+    }
+
+    std::remove(path.c_str());
+
+    // -- SeriesArchive: recorded, flushed on stop, kept for 90 days, replayed --
+    {
+        const std::string directory = "/tmp/series_archive_test_" + std::to_string(::getpid());
+        const int64_t DAY_MS = 24 * SensorHistory::HOUR_MS;
+        const int64_t ages[] = { 120 * DAY_MS, 30 * DAY_MS, 0 };   // an hour of samples at each
+        {
+            SeriesArchive archive(directory, std::chrono::milliseconds(10));
+            expectTrue(archive.open(), "the archive should open", failures);
+            archive.start();
+            for (int64_t age : ages) {
+                for (int64_t i = 0; i < 720; ++i) {
+                    archive.record(SensorHistory::TEMPERATURE, T0 - age + i * 5000, 4.0 + static_cast<double>(i % 3));
+                }
+            }
+            archive.record(SensorHistory::LUX, T0 + 200, 12.5);
+            archive.stop();
+            expectEqual(std::to_string(archive.samples()), "2161", "all samples written by stop()", failures);
+        }
+
+        std::vector<std::string> files = listDirectory(directory);
+        expectEqual(std::to_string(files.size()), "3", "a file per series and week, past retention deleted", failures);
+        expectTrue(std::find(files.begin(), files.end(), "temperature-2025-10-09.series") != files.end(),
+                   "files are named by the week's UTC start: " + (files.empty() ? "" : files[0]), failures);
+
+        SeriesArchive archive(directory);
+        expectTrue(archive.open(), "the archive should reopen", failures);
+        SensorHistory history;
+        archive.replay(history, T0 + SensorHistory::HOUR_MS);
+
+        auto recent = history.query(SensorHistory::TEMPERATURE, T0, T0 + 3600 * 1000, 60000);
+        expectTrue(recent.size() == 60 && recent[0].count == 12, "the last week is replayed sample by sample", failures);
+
+        auto older = history.query(SensorHistory::TEMPERATURE, T0 - 30 * DAY_MS, T0 - 30 * DAY_MS + 3600 * 1000,
+                                   3600 * 1000);
+        expectTrue(older.size() == 1 && older[0].count == 720 && older[0].min == 4.0 && older[0].max == 6.0 &&
+                   older[0].sum == 720 * 5.0, "older hours are rebuilt into the hour roll-up", failures);
+        expectTrue(history.query(SensorHistory::TEMPERATURE, T0 - 30 * DAY_MS, T0 - 30 * DAY_MS + 3600 * 1000,
+                                 60000).empty(), "older samples stay out of the minute roll-up", failures);
+        expectTrue(history.query(SensorHistory::TEMPERATURE, T0 - 120 * DAY_MS, T0 - 119 * DAY_MS,
+                                 3600 * 1000).empty(), "samples past retention are gone", failures);
+        expectTrue(history.query(SensorHistory::LUX, T0, T0 + 60000, 60000).size() == 1, "lux replayed", failures);
+
+        for (const std::string& file : files) std::remove((directory + "/" + file).c_str());
+        ::rmdir(directory.c_str());
+    }
+
+    if (failures == 0) {
+        std::cout << "PASS\n";
+        return 0;
+    }
+    std::cout << "FAILURES: " << failures << "\n";
+    return 1;
+}
@@ -0,0 +1,32 @@
+#include "EventNotifier.hpp"
+
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <utility>
+
+EventNotifier::EventNotifier(std::string socketPath)
+    : socketPath_(std::move(socketPath)) {
+    fd_ = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+}
+
+EventNotifier::~EventNotifier() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+void EventNotifier::publish(const std::string& event, const std::string& json) {
+    if (fd_ < 0) return;
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socketPath_.c_str(), sizeof(addr.sun_path) - 1);
+
+    // Wire format: "<event>\n<json>"
+    const std::string message = event + "\n" + json;
+
+    // Unconnected send so a restarted listener is picked up automatically.
+    // ENOENT / ECONNREFUSED / EAGAIN all mean "nobody to tell right now".
+    ::sendto(fd_, message.data(), message.size(), MSG_DONTWAIT,
+             reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+}
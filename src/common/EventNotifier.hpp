@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+
+/**
+ * @brief Fire-and-forget change notifications to the web event stream.
+ *
+ * Sends one Unix datagram per event to the socket that pifridge_api's
+ * SseHub listens on. Sends never block: if nothing is listening, or the
+ * listener is behind, the event is dropped. Clients resync on reconnect,
+ * so a lost notification only delays an update.
+ *
+ * Safe to call from any thread.
+ *
+ * Usage:
+ * @code
+ *   EventNotifier notifier;
+ *   notifier.publish("inventory", "{}");
+ * @endcode
+ */
+class EventNotifier {
+public:
+    /** Must match the socket bound by SseHub in pifridge_api. */
+    static constexpr const char* DEFAULT_SOCKET_PATH = "/var/run/pifridge/events.sock";
+
+    explicit EventNotifier(std::string socketPath = DEFAULT_SOCKET_PATH);
+    ~EventNotifier();
+
+    EventNotifier(const EventNotifier&) = delete;
+    EventNotifier& operator=(const EventNotifier&) = delete;
+
+    /**
+     * @brief Publish one event.
+     *
+     * @param event Event name, e.g. "vitals" or "inventory"
+     * @param json  Event payload, a single-line JSON value
+     */
+    void publish(const std::string& event, const std::string& json);
+
+private:
+    std::string socketPath_;
+    int fd_ = -1;
+};
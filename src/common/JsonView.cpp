@@ -0,0 +1,316 @@
+#include "JsonView.hpp"
+
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+constexpr size_t npos = std::string_view::npos;
+
+size_t skipWhitespace(std::string_view s, size_t i) {
+    while (i < s.size() && (s[i] == ' ' || s[i] == '\t' || s[i] == '\n' || s[i] == '\r')) ++i;
+    return i;
+}
+
+// i is at the opening quote; returns the index just past the closing quote.
+// memchr finds the next quote; it is escaped only if an odd number of
+// backslashes runs up to it.
+size_t skipString(std::string_view s, size_t i) {
+    const char* begin = s.data();
+    size_t pos = i + 1;
+
+    while (pos < s.size()) {
+        const void* hit = std::memchr(begin + pos, '"', s.size() - pos);
+        if (!hit) return npos;
+
+        size_t quote = static_cast<size_t>(static_cast<const char*>(hit) - begin);
+        size_t backslashes = 0;
+        while (quote - backslashes > i + 1 && s[quote - backslashes - 1] == '\\') ++backslashes;
+
+        if (backslashes % 2 == 0) return quote + 1;
+        pos = quote + 1;
+    }
+    return npos;
+}
+
+// Bytes that matter while stepping over a container; everything else is
+// skipped without a branch per character class
+struct StructuralBytes {
+    bool table[256] = {};
+    constexpr StructuralBytes() {
+        table[static_cast<unsigned char>('"')] = true;
+        table[static_cast<unsigned char>('{')] = true;
+        table[static_cast<unsigned char>('}')] = true;
+        table[static_cast<unsigned char>('[')] = true;
+        table[static_cast<unsigned char>(']')] = true;
+    }
+};
+constexpr StructuralBytes structural;
+
+// Returns the index just past the value starting at i, or npos if it is
+// malformed. Containers are skipped by bracket depth, stepping over strings
+// so brackets inside them don't count.
+size_t skipValue(std::string_view s, size_t i) {
+    if (i >= s.size()) return npos;
+
+    char c = s[i];
+    if (c == '"') return skipString(s, i);
+
+    if (c == '{' || c == '[') {
+        int depth = 0;
+        while (i < s.size()) {
+            while (i < s.size() && !structural.table[static_cast<unsigned char>(s[i])]) ++i;
+            if (i == s.size()) break;
+
+            c = s[i];
+            if (c == '"') {
+                i = skipString(s, i);
+                if (i == npos) return npos;
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                ++depth;
+            } else if (--depth == 0) {
+                return i + 1;
+            }
+            ++i;
+        }
+        return npos;
+    }
+
+    // Number, true, false or null — runs to the next delimiter
+    size_t end = i;
+    while (end < s.size() && !std::strchr(",}] \t\r\n", s[end])) ++end;
+    return end > i ? end : npos;
+}
+
+void appendUtf8(std::string& out, unsigned long cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// Reads 4 hex digits at s[i]; returns false if they aren't there
+bool readHex4(std::string_view s, size_t i, unsigned long& value) {
+    if (i + 4 > s.size()) return false;
+    unsigned int parsed = 0;
+    auto result = std::from_chars(s.data() + i, s.data() + i + 4, parsed, 16);
+    if (result.ec != std::errc() || result.ptr != s.data() + i + 4) return false;
+    value = parsed;
+    return true;
+}
+
+// Unescapes the contents of a JSON string (without its quotes)
+std::string unescape(std::string_view s) {
+    std::string out;
+    out.reserve(s.size());
+
+    for (size_t i = 0; i < s.size(); ++i) {
+        char c = s[i];
+        if (c != '\\' || i + 1 == s.size()) {
+            out += c;
+            continue;
+        }
+
+        c = s[++i];
+        switch (c) {
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                unsigned long cp = 0;
+                if (!readHex4(s, i + 1, cp)) { out += "\\u"; break; }
+                i += 4;
+
+                // Characters outside the BMP arrive as a surrogate pair
+                unsigned long low = 0;
+                if (cp >= 0xD800 && cp < 0xDC00 && i + 2 < s.size() &&
+                    s[i + 1] == '\\' && s[i + 2] == 'u' && readHex4(s, i + 3, low) &&
+                    low >= 0xDC00 && low < 0xE000) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                }
+                appendUtf8(out, cp);
+                break;
+            }
+            default: out += c; break;   // \" \\ \/
+        }
+    }
+
+    return out;
+}
+
+// Compares a raw (possibly escaped) key with a plain one
+bool keyEquals(std::string_view rawKey, std::string_view key) {
+    if (rawKey.find('\\') == npos) return rawKey == key;
+    return unescape(rawKey) == key;
+}
+
+} // namespace
+
+JsonView JsonView::parse(std::string_view document) {
+    size_t begin = skipWhitespace(document, 0);
+    size_t end = document.size();
+    while (end > begin && skipWhitespace(document, end - 1) == end) --end;
+    if (begin == end) return {};
+
+    // Containers are not walked here — a lookup only reads as far as the
+    // member it wants, and reports malformed text it runs into then
+    std::string_view raw = document.substr(begin, end - begin);
+    char first = raw.front();
+    char last  = raw.back();
+    if (first == '{' && last != '}') return {};
+    if (first == '[' && last != ']') return {};
+    if (first != '{' && first != '[' && skipValue(raw, 0) != raw.size()) return {};
+
+    return at(raw);
+}
+
+JsonView JsonView::at(std::string_view text) {
+    if (text.empty()) return {};
+
+    // A container keeps the rest of the text; lookups stop at its closing
+    // bracket, so finding a nested member never has to measure the parent
+    if (text[0] == '{') return { Type::Object, text };
+    if (text[0] == '[') return { Type::Array,  text };
+
+    size_t end = skipValue(text, 0);
+    if (end == npos) return {};
+    std::string_view raw = text.substr(0, end);
+
+    switch (raw[0]) {
+        case '"': return { Type::String, raw };
+        case 't':
+        case 'f': return { Type::Bool,   raw };
+        case 'n': return { Type::Null,   raw };
+        default:
+            if (raw[0] == '-' || (raw[0] >= '0' && raw[0] <= '9')) return { Type::Number, raw };
+            return {};
+    }
+}
+
+std::string_view JsonView::raw() const {
+    if (type_ != Type::Object && type_ != Type::Array) return raw_;
+
+    size_t end = skipValue(raw_, 0);
+    return end == npos ? std::string_view{} : raw_.substr(0, end);
+}
+
+JsonView JsonView::operator[](std::string_view key) const {
+    if (type_ != Type::Object) return {};
+
+    const std::string_view s = raw_;
+    size_t i = skipWhitespace(s, 1);
+    if (i < s.size() && s[i] == '}') return {};
+
+    while (i < s.size() && s[i] == '"') {
+        size_t keyEnd = skipString(s, i);
+        if (keyEnd == npos) return {};
+        std::string_view name = s.substr(i + 1, keyEnd - i - 2);
+
+        i = skipWhitespace(s, keyEnd);
+        if (i >= s.size() || s[i] != ':') return {};
+
+        size_t valueBegin = skipWhitespace(s, i + 1);
+        if (keyEquals(name, key)) return at(s.substr(valueBegin));
+
+        size_t valueEnd = skipValue(s, valueBegin);
+        if (valueEnd == npos) return {};
+
+        i = skipWhitespace(s, valueEnd);
+        if (i >= s.size() || s[i] != ',') return {};
+        i = skipWhitespace(s, i + 1);
+    }
+
+    return {};
+}
+
+JsonView JsonView::operator[](size_t index) const {
+    if (type_ != Type::Array) return {};
+
+    const std::string_view s = raw_;
+    size_t i = skipWhitespace(s, 1);
+    if (i < s.size() && s[i] == ']') return {};
+
+    for (size_t n = 0; i < s.size(); ++n) {
+        if (n == index) return at(s.substr(i));
+
+        size_t end = skipValue(s, i);
+        if (end == npos) return {};
+
+        i = skipWhitespace(s, end);
+        if (i >= s.size() || s[i] != ',') return {};
+        i = skipWhitespace(s, i + 1);
+    }
+
+    return {};
+}
+
+std::vector<JsonView> JsonView::elements() const {
+    std::vector<JsonView> out;
+    if (type_ != Type::Array) return out;
+
+    const std::string_view s = raw_;
+    size_t i = skipWhitespace(s, 1);
+    if (i < s.size() && s[i] == ']') return out;
+
+    while (i < s.size()) {
+        size_t end = skipValue(s, i);
+        if (end == npos) return {};
+        out.push_back(at(s.substr(i)));
+
+        i = skipWhitespace(s, end);
+        if (i < s.size() && s[i] == ']') return out;
+        if (i >= s.size() || s[i] != ',') return {};
+        i = skipWhitespace(s, i + 1);
+    }
+
+    return {};
+}
+
+std::string JsonView::asString(std::string_view fallback) const {
+    switch (type_) {
+        case Type::String: {
+            std::string_view inner = raw_.substr(1, raw_.size() - 2);
+            if (inner.find('\\') == npos) return std::string(inner);
+            return unescape(inner);
+        }
+        case Type::Number:
+        case Type::Bool:
+            return std::string(raw_);
+        default:
+            return std::string(fallback);
+    }
+}
+
+long long JsonView::asInt(long long fallback) const {
+    std::string_view digits;
+    if (type_ == Type::Number)      digits = raw_;
+    else if (type_ == Type::String) digits = raw_.substr(1, raw_.size() - 2);
+    else                            return fallback;
+
+    long long value = 0;
+    auto result = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+    if (result.ec != std::errc() || result.ptr != digits.data() + digits.size()) return fallback;
+    return value;
+}
+
+bool JsonView::asBool(bool fallback) const {
+    if (raw_ == "true")  return true;
+    if (raw_ == "false") return false;
+    return fallback;
+}
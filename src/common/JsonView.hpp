@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Read-only view of one JSON value inside a caller-owned buffer.
+ *
+ * Nothing is copied or built up front: a lookup walks the members of one
+ * object (or elements of one array) a token at a time, stepping over nested
+ * values without looking inside them. A key name that appears inside a
+ * string value, or inside a nested object, is never mistaken for a member.
+ *
+ * Strings are only unescaped (\", \\, \n, \uXXXX, ...) when asked for with
+ * asString(). The view points into the original text, so that text must
+ * outlive every JsonView taken from it.
+ *
+ * A failed lookup returns an invalid view rather than throwing, so lookups
+ * can be chained and checked once at the end.
+ *
+ * Usage:
+ * @code
+ *   JsonView doc = JsonView::parse(response);
+ *   if (doc["status"].asInt(0) == 1) {
+ *       std::string name = doc["product"]["product_name"].asString();
+ *   }
+ * @endcode
+ */
+class JsonView {
+public:
+    enum class Type { Invalid, Null, Bool, Number, String, Object, Array };
+
+    /** An invalid view, as returned by a failed lookup. */
+    JsonView() = default;
+
+    /**
+     * @brief View the single JSON value making up @p document.
+     *
+     * Objects and arrays are not walked here: each lookup reads only as far
+     * as the member it wants and returns an invalid view if the text it
+     * crosses is malformed. Text after a scalar, or a container that does
+     * not end with its closing bracket, gives an invalid view straight away.
+     */
+    static JsonView parse(std::string_view document);
+
+    Type type() const { return type_; }
+    bool valid() const { return type_ != Type::Invalid; }
+
+    /** The value's source text, e.g. "\"a\\\"b\"" for a string. */
+    std::string_view raw() const;
+
+    /** Member @p key of an object; invalid if absent or not an object. */
+    JsonView operator[](std::string_view key) const;
+
+    /** Element @p index of an array; invalid if out of range or not an array. */
+    JsonView operator[](size_t index) const;
+
+    /**
+     * @brief Every element of an array, found in one pass.
+     *
+     * Use this rather than operator[](size_t) in a loop, which walks from
+     * the start of the array on every call.
+     *
+     * @return Empty if this is not an array or the array is malformed.
+     */
+    std::vector<JsonView> elements() const;
+
+    /**
+     * @brief The value as text.
+     *
+     * Strings are unescaped; numbers and booleans give their source text, so
+     * {"id": 5} and {"id": "5"} read the same.
+     *
+     * @return @p fallback for null, objects, arrays and invalid views.
+     */
+    std::string asString(std::string_view fallback = {}) const;
+
+    /**
+     * @brief The value as an integer. Accepts a number or a numeric string.
+     *
+     * @return @p fallback if the value is not a whole number.
+     */
+    long long asInt(long long fallback) const;
+
+    /** @return @p fallback unless the value is true or false. */
+    bool asBool(bool fallback) const;
+
+private:
+    JsonView(Type type, std::string_view raw) : type_(type), raw_(raw) {}
+
+    /** View of the value at the start of @p text. */
+    static JsonView at(std::string_view text);
+
+    Type type_ = Type::Invalid;
+    std::string_view raw_;   // exact for scalars; runs past the end of a container
+};
@@ -0,0 +1,167 @@
+#include "JsonWriter.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+// Escape for each byte: 0 = copy as-is, 'u' = \u00XX, otherwise the
+// character that follows the backslash
+struct EscapeTable {
+    char table[256] = {};
+    constexpr EscapeTable() {
+        for (int c = 0; c < 0x20; ++c) table[c] = 'u';
+        table[static_cast<unsigned char>('"')]  = '"';
+        table[static_cast<unsigned char>('\\')] = '\\';
+        table[static_cast<unsigned char>('\b')] = 'b';
+        table[static_cast<unsigned char>('\f')] = 'f';
+        table[static_cast<unsigned char>('\n')] = 'n';
+        table[static_cast<unsigned char>('\r')] = 'r';
+        table[static_cast<unsigned char>('\t')] = 't';
+    }
+};
+constexpr EscapeTable escapes;
+
+const char HEX[] = "0123456789abcdef";
+
+} // namespace
+
+JsonWriter::JsonWriter(Sink sink)
+    : sink_(std::move(sink)) {}
+
+JsonWriter JsonWriter::toString(std::string& out) {
+    return JsonWriter([&out](const char* data, size_t size) {
+        out.append(data, size);
+        return true;
+    });
+}
+
+void JsonWriter::beginObject() {
+    separate();
+    put('{');
+    if (depth_ < MAX_DEPTH - 1) hasItems_[++depth_] = false;
+}
+
+void JsonWriter::endObject() {
+    if (depth_ > 0) --depth_;
+    put('}');
+}
+
+void JsonWriter::beginArray() {
+    separate();
+    put('[');
+    if (depth_ < MAX_DEPTH - 1) hasItems_[++depth_] = false;
+}
+
+void JsonWriter::endArray() {
+    if (depth_ > 0) --depth_;
+    put(']');
+}
+
+void JsonWriter::key(std::string_view name) {
+    separate();
+    put('"');
+    putEscaped(name);
+    put("\":");
+    afterKey_ = true;
+}
+
+void JsonWriter::value(std::string_view text) {
+    separate();
+    put('"');
+    putEscaped(text);
+    put('"');
+}
+
+void JsonWriter::value(const char* text) {
+    value(text ? std::string_view(text) : std::string_view());
+}
+
+void JsonWriter::value(long long number) {
+    separate();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    put(std::string_view(digits, static_cast<size_t>(result.ptr - digits)));
+}
+
+void JsonWriter::value(bool flag) {
+    separate();
+    put(flag ? "true" : "false");
+}
+
+void JsonWriter::null() {
+    separate();
+    put("null");
+}
+
+void JsonWriter::rawValue(std::string_view json) {
+    separate();
+    put(json);
+}
+
+void JsonWriter::endLine() {
+    put('\n');
+    if (depth_ == 0) hasItems_[0] = false;
+}
+
+void JsonWriter::raw(std::string_view text) {
+    put(text);
+}
+
+bool JsonWriter::flush() {
+    if (used_ > 0 && ok_) ok_ = sink_(buffer_, used_);
+    used_ = 0;
+    return ok_;
+}
+
+// Writes the comma before a member or element, unless it is the first one
+// at this level or the value belonging to a key just written
+void JsonWriter::separate() {
+    if (afterKey_) {
+        afterKey_ = false;
+        return;
+    }
+    if (hasItems_[depth_]) put(',');
+    hasItems_[depth_] = true;
+}
+
+void JsonWriter::put(char c) {
+    if (used_ == BUFFER_SIZE) flush();
+    buffer_[used_++] = c;
+}
+
+void JsonWriter::put(std::string_view text) {
+    while (!text.empty()) {
+        if (used_ == BUFFER_SIZE) flush();
+        size_t n = std::min(text.size(), BUFFER_SIZE - used_);
+        std::memcpy(buffer_ + used_, text.data(), n);
+        used_ += n;
+        text.remove_prefix(n);
+    }
+}
+
+void JsonWriter::putEscaped(std::string_view text) {
+    size_t runStart = 0;
+
+    for (size_t i = 0; i < text.size(); ++i) {
+        char escape = escapes.table[static_cast<unsigned char>(text[i])];
+        if (escape == 0) continue;
+
+        // Copy the clean run before this byte in one go
+        put(text.substr(runStart, i - runStart));
+        runStart = i + 1;
+
+        if (escape == 'u') {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            const char sequence[] = { '\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0x0F] };
+            put(std::string_view(sequence, sizeof(sequence)));
+        } else {
+            const char sequence[] = { '\\', escape };
+            put(std::string_view(sequence, sizeof(sequence)));
+        }
+    }
+
+    put(text.substr(runStart));
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Streaming JSON writer with a fixed-size buffer.
+ *
+ * Values are escaped straight into a small internal buffer, which is handed
+ * to the sink whenever it fills and on flush(). Nothing else is held, so
+ * writing 20 rows or 20,000 uses the same memory. Commas between members
+ * and elements are inserted automatically.
+ *
+ * Escaping is table-driven: runs of bytes that need no escape are copied
+ * in one go, and only '"', '\\' and control characters are rewritten.
+ *
+ * Usage:
+ * @code
+ *   JsonWriter json([&](const char* data, size_t size) {
+ *       return FCGX_PutStr(data, static_cast<int>(size), request.out) >= 0;
+ *   });
+ *   json.beginObject();
+ *   json.key("name");  json.value("Milk");
+ *   json.key("qty");   json.value(2);
+ *   json.endObject();
+ *   json.flush();
+ * @endcode
+ */
+class JsonWriter {
+public:
+    /** Receives each filled buffer; returns false if the output has failed. */
+    using Sink = std::function<bool(const char* data, size_t size)>;
+
+    static constexpr size_t BUFFER_SIZE = 4096;
+    static constexpr int MAX_DEPTH = 32;
+
+    explicit JsonWriter(Sink sink);
+
+    /** A writer that appends to @p out, for callers that want a string. */
+    static JsonWriter toString(std::string& out);
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    /** Member name; the next call writes its value. */
+    void key(std::string_view name);
+
+    void value(std::string_view text);
+    void value(const char* text);           ///< nullptr is written as ""
+    void value(long long number);
+    void value(int number) { value(static_cast<long long>(number)); }
+    void value(bool flag);
+    void null();
+
+    /** Write already-encoded JSON (e.g. a stored document) as a value. */
+    void rawValue(std::string_view json);
+
+    /**
+     * End a top-level value with '\n'; the next one starts a new line
+     * rather than following a comma. One JSON document per line (NDJSON).
+     */
+    void endLine();
+
+    /** Write @p text unchanged, for non-JSON output (CSV) sharing the buffer. */
+    void raw(std::string_view text);
+
+    /** Hand any buffered output to the sink. @return false if a write failed. */
+    bool flush();
+
+    /** @return false once any write to the sink has failed. */
+    bool ok() const { return ok_; }
+
+private:
+    void separate();
+    void put(char c);
+    void put(std::string_view text);
+    void putEscaped(std::string_view text);
+
+    Sink sink_;
+    char buffer_[BUFFER_SIZE];
+    size_t used_ = 0;
+    bool ok_ = true;
+
+    // Per nesting level: has it had a member/element yet? A key sets
+    // afterKey_ so its value doesn't get a comma of its own.
+    bool hasItems_[MAX_DEPTH] = {};
+    int depth_ = 0;
+    bool afterKey_ = false;
+};
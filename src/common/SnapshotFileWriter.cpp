@@ -0,0 +1,86 @@
+#include "SnapshotFileWriter.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <utility>
+
+SnapshotFileWriter::SnapshotFileWriter(std::string path, Render render, std::chrono::milliseconds minInterval)
+    : path_(std::move(path)), render_(std::move(render)), minInterval_(minInterval) {}
+
+SnapshotFileWriter::~SnapshotFileWriter() {
+    stop();
+}
+
+void SnapshotFileWriter::start() {
+    if (thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = false;
+    }
+    thread_ = std::thread(&SnapshotFileWriter::run, this);
+}
+
+void SnapshotFileWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_one();
+    if (thread_.joinable()) thread_.join();
+}
+
+void SnapshotFileWriter::notify() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = true;
+    }
+    changed_.notify_one();
+}
+
+void SnapshotFileWriter::run() {
+    // Linux applies nice to the calling thread only: the sensor and door
+    // threads keep their priority, and this one runs when they are idle
+    ::setpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)), 19);
+
+    std::string written;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        changed_.wait(lock, [this] { return pending_ || stopping_; });
+        if (!pending_) return;   // stopping, nothing left to write
+        pending_ = false;
+        bool stopping = stopping_;
+        lock.unlock();
+
+        // Rendered now, not at notify(), so a burst is written once, as it ended
+        std::string contents = render_();
+        if (contents != written && replace(contents)) {
+            written = std::move(contents);
+            ++writes_;
+        }
+
+        lock.lock();
+        if (stopping) return;
+
+        // Let changes collect; stop() cuts the wait short
+        changed_.wait_for(lock, minInterval_, [this] { return stopping_; });
+    }
+}
+
+bool SnapshotFileWriter::replace(const std::string& contents) {
+    const std::string temp = path_ + ".tmp";
+    std::FILE* file = std::fopen(temp.c_str(), "w");
+    bool ok = file && std::fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+    if (file && std::fclose(file) != 0) ok = false;
+
+    if (ok && std::rename(temp.c_str(), path_.c_str()) != 0) ok = false;
+    if (!ok) {
+        std::cerr << "[SnapshotFileWriter] Failed to write " << path_ << ": " << std::strerror(errno) << "\n";
+        std::remove(temp.c_str());
+    }
+    return ok;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Writes the latest state to a file from a low-priority thread.
+ *
+ * Callers only mark the state changed with notify(), which takes a mutex
+ * for a flag and never touches the disk. The writer thread, run at the
+ * lowest CPU priority, then renders the state and replaces the file:
+ * written to "<path>.tmp" and renamed over it, so a reader sees the old
+ * file or the new one, never a partial one.
+ *
+ * Bursts are coalesced: after each write the thread waits minInterval,
+ * and every notify() in that time results in one more write, of whatever
+ * the state is by then. Content identical to the last write is skipped.
+ *
+ * Usage:
+ * @code
+ *   SnapshotFileWriter writer("/tmp/fridge_data.json",
+ *                             [&] { return stateToJson(*state.current()); },
+ *                             std::chrono::milliseconds(500));
+ *   writer.start();
+ *   writer.notify();   // from any thread, after each change
+ * @endcode
+ */
+class SnapshotFileWriter {
+public:
+    /** Returns the file contents for the current state. Called on the writer thread. */
+    using Render = std::function<std::string()>;
+
+    SnapshotFileWriter(std::string path, Render render,
+                       std::chrono::milliseconds minInterval = std::chrono::milliseconds(500));
+    ~SnapshotFileWriter();
+
+    SnapshotFileWriter(const SnapshotFileWriter&) = delete;
+    SnapshotFileWriter& operator=(const SnapshotFileWriter&) = delete;
+
+    /** Start the writer thread. */
+    void start();
+
+    /** Write any pending change, then stop the thread. */
+    void stop();
+
+    /** The state changed; write it out soon. Safe from any thread. */
+    void notify();
+
+    /** Files written so far. */
+    long writes() const { return writes_.load(); }
+
+private:
+    void run();
+
+    /** Replace the file with @p contents. */
+    bool replace(const std::string& contents);
+
+    std::string path_;
+    Render render_;
+    std::chrono::milliseconds minInterval_;
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    bool pending_ = false;
+    bool stopping_ = false;
+
+    std::thread thread_;
+    std::atomic<long> writes_{0};
+};
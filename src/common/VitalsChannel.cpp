@@ -0,0 +1,157 @@
+#include "VitalsChannel.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+
+static_assert(std::is_trivially_copyable<Vitals>::value, "Vitals is copied as raw words");
+
+namespace {
+
+// Changes whenever the layout below does, so an old reader ignores a new
+// segment rather than misreading it
+constexpr uint32_t MAGIC = 0x50465601;   // "PFV" 1
+
+constexpr size_t WORDS = (sizeof(Vitals) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+// read() spins this many times, then yields until MAX_READ_WAIT has passed
+constexpr int SPIN_ATTEMPTS = 100;
+constexpr std::chrono::milliseconds MAX_READ_WAIT(1);
+
+} // namespace
+
+// The record is held as atomic words so that a reader copying it while the
+// publisher writes is a retried read, not undefined behaviour
+struct VitalsChannel::Segment {
+    std::atomic<uint32_t> magic;
+    std::atomic<uint32_t> sequence;      // odd while a write is in progress; 0 before the first
+    std::atomic<uint64_t> words[WORDS];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "shared atomics must not need a lock");
+
+std::string vitalsToJson(const Vitals& vitals) {
+    char json[192];
+    std::snprintf(json, sizeof(json),
+        "{\"temperature\": %.2f, \"humidity\": %.2f, \"pressure\": %.2f, \"lux\": %.2f, \"door_open\": %s}",
+        static_cast<double>(vitals.temperature_c), static_cast<double>(vitals.humidity_rh),
+        static_cast<double>(vitals.pressure_hpa), vitals.lux, vitals.door_open ? "true" : "false");
+    return json;
+}
+
+VitalsChannel::VitalsChannel(std::string name) : name_(std::move(name)) {}
+
+VitalsChannel::~VitalsChannel() {
+    Segment* segment = segment_.load();
+    if (segment) ::munmap(segment, sizeof(Segment));
+}
+
+bool VitalsChannel::create() {
+    // Readable by pifridge_api, which runs as another user
+    int fd = ::shm_open(name_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    ::fchmod(fd, 0644);   // the umask may have narrowed the mode
+
+    void* mapped = MAP_FAILED;
+    if (::ftruncate(fd, sizeof(Segment)) == 0) {
+        mapped = ::mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    // A new segment is zero-filled: sequence 0, nothing published. One left
+    // by an earlier run keeps its last record and sequence.
+    auto* segment = static_cast<Segment*>(mapped);
+    if (segment->magic.load(std::memory_order_relaxed) != MAGIC) {
+        segment->sequence.store(0, std::memory_order_relaxed);
+        segment->magic.store(MAGIC, std::memory_order_release);
+    }
+    writable_ = true;
+    segment_.store(segment, std::memory_order_release);
+    return true;
+}
+
+void VitalsChannel::publish(const Vitals& vitals) {
+    Segment* segment = segment_.load(std::memory_order_relaxed);
+    if (!segment || !writable_) return;
+
+    uint64_t words[WORDS] = {};
+    std::memcpy(words, &vitals, sizeof(Vitals));
+
+    uint32_t sequence = segment->sequence.load(std::memory_order_relaxed);
+    if (sequence & 1) ++sequence;   // an earlier publisher died mid-write
+    segment->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (size_t i = 0; i < WORDS; ++i) {
+        segment->words[i].store(words[i], std::memory_order_relaxed);
+    }
+    segment->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool VitalsChannel::read(Vitals& vitals) {
+    Segment* segment = segment_.load(std::memory_order_acquire);
+    if (!segment) segment = attach();
+    if (!segment || segment->magic.load(std::memory_order_acquire) != MAGIC) return false;
+
+    uint64_t words[WORDS];
+    std::chrono::steady_clock::time_point deadline;
+    for (int attempt = 0;; ++attempt) {
+        uint32_t before = segment->sequence.load(std::memory_order_acquire);
+        if (before == 0) return false;
+
+        if ((before & 1) == 0) {
+            for (size_t i = 0; i < WORDS; ++i) {
+                words[i] = segment->words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (segment->sequence.load(std::memory_order_relaxed) == before) break;
+        }
+
+        // A write takes nanoseconds; only a publisher descheduled
+        // mid-write keeps us here, so let it run. One killed mid-write
+        // leaves the sequence odd until it restarts: give up rather than
+        // hold the caller's thread.
+        if (attempt == SPIN_ATTEMPTS) deadline = std::chrono::steady_clock::now() + MAX_READ_WAIT;
+        if (attempt >= SPIN_ATTEMPTS) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            std::this_thread::yield();
+        }
+    }
+
+    std::memcpy(&vitals, words, sizeof(Vitals));
+    return true;
+}
+
+VitalsChannel::Segment* VitalsChannel::attach() {
+    std::lock_guard<std::mutex> lock(attachMutex_);
+    Segment* segment = segment_.load(std::memory_order_acquire);
+    if (segment) return segment;
+
+    int fd = ::shm_open(name_.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) return nullptr;   // publisher not started yet
+
+    struct stat info{};
+    void* mapped = MAP_FAILED;
+    if (::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(Segment)) {
+        mapped = ::mmap(nullptr, sizeof(Segment), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapped == MAP_FAILED) return nullptr;
+
+    segment = static_cast<Segment*>(mapped);
+    segment_.store(segment, std::memory_order_release);
+    return segment;
+}
+
+void VitalsChannel::remove(const std::string& name) {
+    ::shm_unlink(name.c_str());
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+/** Latest fridge readings, as shared between processes. */
+struct Vitals {
+    float    temperature_c = 0.0f;
+    float    pressure_hpa  = 0.0f;
+    float    humidity_rh   = 0.0f;
+    uint32_t gas_ohms      = 0;
+    double   lux           = 0.0;
+    bool     door_open     = false;
+};
+
+/** The /api/fridge JSON for @p vitals, on one line. */
+std::string vitalsToJson(const Vitals& vitals);
+
+/**
+ * @brief Latest Vitals in POSIX shared memory, guarded by a seqlock.
+ *
+ * pifridge publishes into a small segment under /dev/shm; pifridge_api maps
+ * it read-only and copies the record out on each GET /api/fridge. A read is
+ * a few loads and no syscalls, and never blocks the publisher.
+ *
+ * The publisher makes the sequence odd, writes the record and makes it even
+ * again. A reader copies the record between two reads of the sequence and
+ * retries if they differ or are odd, so it never returns a record that was
+ * half written. It gives up after about a millisecond of retries.
+ *
+ * One publisher at a time. read() is safe from any number of threads and
+ * processes.
+ *
+ * Usage:
+ * @code
+ *   // pifridge
+ *   VitalsChannel channel;
+ *   channel.create();
+ *   channel.publish(vitals);
+ *
+ *   // pifridge_api
+ *   VitalsChannel channel;
+ *   Vitals vitals;
+ *   if (channel.read(vitals)) body = vitalsToJson(vitals);
+ * @endcode
+ */
+class VitalsChannel {
+public:
+    /** shm_open() name; the segment appears as /dev/shm/pifridge_vitals. */
+    static constexpr const char* DEFAULT_NAME = "/pifridge_vitals";
+
+    explicit VitalsChannel(std::string name = DEFAULT_NAME);
+    ~VitalsChannel();
+
+    VitalsChannel(const VitalsChannel&) = delete;
+    VitalsChannel& operator=(const VitalsChannel&) = delete;
+
+    /**
+     * @brief Create (or reuse) the segment and map it for publishing.
+     *
+     * The segment is not removed on exit, so a reader that has it mapped
+     * carries on across a publisher restart.
+     */
+    bool create();
+
+    /** Publish @p vitals. No effect until create() has succeeded. */
+    void publish(const Vitals& vitals);
+
+    /**
+     * @brief Copy out the latest vitals.
+     *
+     * Maps the segment read-only on first use, so the reader may start
+     * before the publisher.
+     *
+     * @return false if nothing has been published yet, or if a write has
+     *         been in progress for over a millisecond (a publisher killed
+     *         mid-write, until it restarts and publishes again).
+     */
+    bool read(Vitals& vitals);
+
+    /** Remove the segment from /dev/shm (tests). */
+    static void remove(const std::string& name);
+
+private:
+    struct Segment;
+
+    /** Map the segment if it exists, for reading. */
+    Segment* attach();
+
+    std::string name_;
+    std::atomic<Segment*> segment_{nullptr};
+    std::mutex attachMutex_;
+    bool writable_ = false;
+};
@@ -0,0 +1,134 @@
+// JsonViewBench.cpp
+// Micro-benchmark for pulling fields out of OpenFoodFacts product responses.
+//
+// Compares the old find()-based extractJsonString against JsonView on two
+// payloads: the small reply to "?fields=product_name" that the scanner asks
+// for, and a full product record (nutriments, ingredients, image metadata)
+// as returned when no field list is given.
+//
+// Run:
+//   ./build/src/common/json_view_bench [iterations]
+
+#include "../JsonView.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsedNs(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// The extractor previously copied into pifridge_inventory and BarcodeScanner
+static std::string legacyExtract(const std::string& json, const std::string& key) {
+    std::string search = "\"" + key + "\"";
+    size_t pos = json.find(search);
+    if (pos == std::string::npos) return "";
+
+    pos = json.find(':', pos);
+    if (pos == std::string::npos) return "";
+    pos++;
+
+    while (pos < json.size() && (json[pos] == ' ' || json[pos] == '\t')) pos++;
+
+    if (json[pos] == '"') {
+        pos++;
+        size_t end = json.find('"', pos);
+        if (end == std::string::npos) return "";
+        return json.substr(pos, end - pos);
+    }
+
+    size_t end = pos;
+    while (end < json.size() && (isdigit(json[end]) || json[end] == '-')) end++;
+    return json.substr(pos, end - pos);
+}
+
+static std::string smallPayload() {
+    return R"({"code":"3017620422003","product":{"product_name":"Nutella"},)"
+           R"("status":1,"status_verbose":"product found"})";
+}
+
+// Shaped like a full /api/v2/product response; product_name comes late in
+// the product object and "status" after it, as in the real thing
+static std::string fullPayload() {
+    std::string p = R"({"code":"3017620422003","product":{"_id":"3017620422003",)"
+                    R"("_keywords":["chocolate","hazelnut","spread","breakfast","ferrero"],)";
+
+    p += R"("ingredients":[)";
+    for (int i = 0; i < 40; ++i) {
+        if (i) p += ",";
+        p += R"({"id":"en:ingredient-)" + std::to_string(i) +
+             R"(","percent_estimate":)" + std::to_string(40 - i) +
+             R"(,"text":"Ingredient \")" + std::to_string(i) +
+             R"(\"","vegan":"maybe","vegetarian":"yes","rank":)" + std::to_string(i + 1) + "}";
+    }
+    p += "],";
+
+    p += R"("nutriments":{)";
+    const char* nutrients[] = { "energy", "fat", "saturated-fat", "carbohydrates", "sugars",
+                                "fiber", "proteins", "salt", "sodium", "calcium" };
+    bool first = true;
+    for (const char* n : nutrients) {
+        for (const char* suffix : { "_100g", "_serving", "_unit", "_value" }) {
+            if (!first) p += ",";
+            first = false;
+            p += std::string("\"") + n + suffix + "\":" + (suffix[1] == 'u' ? "\"g\"" : "12.5");
+        }
+    }
+    p += "},";
+
+    p += R"("images":{)";
+    for (int i = 1; i <= 20; ++i) {
+        if (i > 1) p += ",";
+        p += "\"" + std::to_string(i) + R"(":{"sizes":{"100":{"h":100,"w":75},"400":{"h":400,"w":300},)"
+             R"("full":{"h":1200,"w":900}},"uploaded_t":1700000000,"uploader":"openfoodfacts-contributors"})";
+    }
+    p += "},";
+
+    p += R"("ingredients_text":"Sugar, palm oil, hazelnuts 13%, skimmed milk powder 8.7%, fat-reduced cocoa 7.4%, )"
+         R"(emulsifier: lecithins [soya], vanillin. \"Contains\" nuts.",)"
+         R"("product_name_en":"Nutella","product_name_fr":"Nutella","brands":"Ferrero",)"
+         R"("product_name":"Nutella Hazelnut Spread \"Original\"","quantity":"400 g"},)"
+         R"("status":1,"status_verbose":"product found"})";
+    return p;
+}
+
+static void run(const std::string& label, const std::string& payload, int iterations) {
+    size_t checksum = 0;
+
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        std::string status = legacyExtract(payload, "status");
+        std::string name   = legacyExtract(payload, "product_name");
+        checksum += status.size() + name.size();
+    }
+    double legacyNs = elapsedNs(start) / iterations;
+
+    start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        JsonView doc = JsonView::parse(payload);
+        long long status = doc["status"].asInt(0);
+        std::string name = doc["product"]["product_name"].asString();
+        checksum += static_cast<size_t>(status) + name.size();
+    }
+    double viewNs = elapsedNs(start) / iterations;
+
+    std::cout << "[bench] " << label << " (" << payload.size() << " bytes)\n"
+              << "[bench]   find + substr: " << legacyNs << " ns/response\n"
+              << "[bench]   JsonView:      " << viewNs << " ns/response\n"
+              << "[bench]   (checksum " << checksum << ")\n";
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::stoi(argv[1]) : 20000;
+
+    const std::string full = fullPayload();
+    std::cout << "[bench] full payload product_name: \""
+              << JsonView::parse(full)["product"]["product_name"].asString() << "\"\n";
+
+    run("fields=product_name", smallPayload(), iterations);
+    run("full product",        full,           iterations);
+    return 0;
+}
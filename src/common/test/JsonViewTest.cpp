@@ -0,0 +1,98 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../JsonView.hpp"
+
+static void expectTrue(bool condition, const std::string& message, int& failures) {
+    if (!condition) {
+        std::cout << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+static void expectEqual(const std::string& actual, const std::string& expected,
+                        const std::string& message, int& failures) {
+    if (actual != expected) {
+        std::cout << "FAIL: " << message
+                  << " expected \"" << expected
+                  << "\" got \"" << actual << "\"\n";
+        ++failures;
+    }
+}
+
+int main() {
+    int failures = 0;
+
+    {
+        const std::string body =
+            R"({"id": 12, "name": "Eggs", "barcode": "", "quantity": "6", "best_before": null})";
+        JsonView doc = JsonView::parse(body);
+
+        expectTrue(doc.type() == JsonView::Type::Object, "request body should parse as an object", failures);
+        expectTrue(doc["id"].asInt(-1) == 12, "numeric id should read as 12", failures);
+        expectEqual(doc["id"].asString(), "12", "numeric id should read as text", failures);
+        expectEqual(doc["name"].asString(), "Eggs", "name should be unquoted", failures);
+        expectTrue(doc["barcode"].valid() && doc["barcode"].asString("x").empty(),
+                   "empty string should be present and empty", failures);
+        expectTrue(doc["quantity"].asInt(-1) == 6, "numeric string should read as an integer", failures);
+        expectTrue(doc["best_before"].type() == JsonView::Type::Null, "null should be typed as null", failures);
+        expectTrue(!doc["missing"].valid(), "absent key should give an invalid view", failures);
+        expectTrue(doc["name"].asInt(-1) == -1, "non-numeric string should give the fallback", failures);
+    }
+
+    {
+        // The old find()-based extractor returned the first "status" it saw
+        // and stopped at the first quote
+        const std::string body =
+            R"({"product": {"product_name": "Ben \"Cookie\" Dough", "note": "\"status\": 0"},)"
+            R"( "status_verbose": "product found", "status": 1})";
+        JsonView doc = JsonView::parse(body);
+
+        expectTrue(doc["status"].asInt(-1) == 1, "key inside a value should not match", failures);
+        expectEqual(doc["product"]["product_name"].asString(), "Ben \"Cookie\" Dough",
+                    "escaped quotes should be unescaped", failures);
+        expectTrue(!doc["product_name"].valid(), "nested key should not match at top level", failures);
+    }
+
+    {
+        const std::string body = R"({"s": "tab\there\\ \u00e9 \ud83e\udd5a \/"})";
+        expectEqual(JsonView::parse(body)["s"].asString(), "tab\there\\ \xc3\xa9 \xf0\x9f\xa5\x9a /",
+                    "escapes and surrogate pairs should decode to UTF-8", failures);
+    }
+
+    {
+        const std::string body = R"([1, "two", {"three": [3]}, true])";
+        JsonView doc = JsonView::parse(body);
+
+        expectTrue(doc[size_t{0}].asInt(0) == 1, "first element should be 1", failures);
+        expectEqual(doc[1].asString(), "two", "second element should be \"two\"", failures);
+        expectTrue(doc[2]["three"][size_t{0}].asInt(0) == 3, "nested lookups should chain", failures);
+        expectTrue(doc[3].asBool(false), "fourth element should be true", failures);
+        expectTrue(!doc[4].valid(), "out-of-range index should be invalid", failures);
+
+        std::vector<JsonView> elements = doc.elements();
+        expectTrue(elements.size() == 4, "elements() should find all four elements", failures);
+        expectTrue(elements.size() == 4 && elements[2]["three"][size_t{0}].asInt(0) == 3,
+                   "elements() should return usable views", failures);
+        expectTrue(JsonView::parse("[]").elements().empty(), "empty array should have no elements", failures);
+        expectTrue(JsonView::parse("[1, 2,").elements().empty(), "malformed array should give no elements", failures);
+        expectTrue(JsonView::parse(R"({"a": 1})").elements().empty(), "object should give no elements", failures);
+    }
+
+    {
+        expectTrue(!JsonView::parse("").valid(), "empty input should be invalid", failures);
+        expectTrue(!JsonView::parse(R"({"a": "unterminated})")["a"].valid(), "unterminated string should be invalid", failures);
+        expectTrue(!JsonView::parse(R"({"a": 1} trailing)").valid(), "trailing text should be invalid", failures);
+        expectTrue(!JsonView::parse(R"({"a" 1})")["a"].valid(), "missing colon should not match", failures);
+        expectTrue(!JsonView::parse("{}")["a"].valid(), "empty object should have no members", failures);
+    }
+
+    if (failures == 0) {
+        std::cout << "PASS\n";
+        return 0;
+    }
+
+    std::cout << "FAILURES: " << failures << "\n";
+    return 1;
+}
@@ -0,0 +1,103 @@
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "../SnapshotFileWriter.hpp"
+
+static void expectTrue(bool condition, const std::string& message, int& failures) {
+    if (!condition) {
+        std::cout << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+static void expectEqual(const std::string& actual, const std::string& expected,
+                        const std::string& message, int& failures) {
+    if (actual != expected) {
+        std::cout << "FAIL: " << message
+                  << " expected \"" << expected
+                  << "\" got \"" << actual << "\"\n";
+        ++failures;
+    }
+}
+
+static std::string readFile(const std::string& path) {
+    std::ifstream in(path);
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+// Large enough that a partial write would be visible to a reader
+static std::string contentsFor(long n) {
+    return "{\"n\": " + std::to_string(n) + ", \"pad\": \"" + std::string(4096, 'x') + "\"}";
+}
+
+int main() {
+    int failures = 0;
+    const std::string path = "/tmp/pifridge_snapshot_test_" + std::to_string(::getpid()) + ".json";
+    std::remove(path.c_str());
+
+    std::atomic<long> state{0};
+    SnapshotFileWriter writer(path, [&] {
+        return contentsFor(state.load());
+    }, std::chrono::milliseconds(50));
+    writer.start();
+
+    // A burst of changes: a handful of writes, the last one of the final state
+    std::atomic<bool> stopReading{false};
+    std::atomic<long> partial{0};
+    std::thread reader([&] {
+        while (!stopReading) {
+            std::string contents = readFile(path);
+            if (!contents.empty() && contents.back() != '}') ++partial;
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    for (long n = 1; n <= 10000; ++n) {
+        state = n;
+        writer.notify();
+    }
+    auto notifyTime = std::chrono::steady_clock::now() - start;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    stopReading = true;
+    reader.join();
+
+    expectEqual(readFile(path), contentsFor(10000), "file should hold the last state", failures);
+    expectTrue(writer.writes() >= 1 && writer.writes() <= 10, "burst should be coalesced into a few writes, got " +
+               std::to_string(writer.writes()), failures);
+    expectEqual(std::to_string(partial.load()), "0", "readers should never see a partial file", failures);
+    expectTrue(std::chrono::duration_cast<std::chrono::milliseconds>(notifyTime).count() < 1000,
+               "notify() should not wait for the disk", failures);
+    expectTrue(access((path + ".tmp").c_str(), F_OK) != 0, "temporary file should be renamed away", failures);
+
+    // Notifying without a change writes nothing
+    long before = writer.writes();
+    writer.notify();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    expectEqual(std::to_string(writer.writes()), std::to_string(before), "unchanged contents should not be rewritten",
+                failures);
+
+    // A change pending at stop() is written before the thread exits
+    state = 42;
+    writer.notify();
+    writer.stop();
+    expectEqual(readFile(path), contentsFor(42), "stop() should flush the pending change", failures);
+
+    std::remove(path.c_str());
+
+    if (failures == 0) {
+        std::cout << "PASS\n";
+        return 0;
+    }
+
+    std::cout << "FAILURES: " << failures << "\n";
+    return 1;
+}
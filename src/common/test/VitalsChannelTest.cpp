@@ -0,0 +1,151 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+
+#include "../VitalsChannel.hpp"
+
+static void expectTrue(bool condition, const std::string& message, int& failures) {
+    if (!condition) {
+        std::cout << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+static void expectEqual(const std::string& actual, const std::string& expected,
+                        const std::string& message, int& failures) {
+    if (actual != expected) {
+        std::cout << "FAIL: " << message
+                  << " expected \"" << expected
+                  << "\" got \"" << actual << "\"\n";
+        ++failures;
+    }
+}
+
+// Every field derived from @p n, so a record mixing two writes shows up
+static Vitals vitalsFor(uint32_t n) {
+    Vitals vitals;
+    vitals.temperature_c = static_cast<float>(n % 1000);
+    vitals.pressure_hpa  = static_cast<float>(n % 1000) + 1000.0f;
+    vitals.humidity_rh   = static_cast<float>(n % 100);
+    vitals.gas_ohms      = n;
+    vitals.lux           = static_cast<double>(n) * 0.5;
+    vitals.door_open     = (n & 1) != 0;
+    return vitals;
+}
+
+static bool consistent(const Vitals& vitals) {
+    Vitals expected = vitalsFor(vitals.gas_ohms);
+    return vitals.temperature_c == expected.temperature_c && vitals.pressure_hpa == expected.pressure_hpa &&
+           vitals.humidity_rh == expected.humidity_rh && vitals.lux == expected.lux &&
+           vitals.door_open == expected.door_open;
+}
+
+int main() {
+    int failures = 0;
+    const std::string name = "/pifridge_vitals_test_" + std::to_string(::getpid());
+    VitalsChannel::remove(name);
+
+    {
+        VitalsChannel reader(name);
+        Vitals vitals;
+        expectTrue(!reader.read(vitals), "read before the segment exists should fail", failures);
+
+        VitalsChannel publisher(name);
+        expectTrue(publisher.create(), "create should succeed", failures);
+        expectTrue(!reader.read(vitals), "read before the first publish should fail", failures);
+
+        publisher.publish(vitalsFor(7));
+        expectTrue(reader.read(vitals), "reader started first should attach once the segment exists", failures);
+        expectEqual(vitalsToJson(vitals),
+                    "{\"temperature\": 7.00, \"humidity\": 7.00, \"pressure\": 1007.00, \"lux\": 3.50, \"door_open\": true}",
+                    "published vitals", failures);
+    }
+
+    {
+        // A restarted publisher keeps the last record until it publishes
+        VitalsChannel publisher(name);
+        expectTrue(publisher.create(), "create over an existing segment should succeed", failures);
+        VitalsChannel reader(name);
+        Vitals vitals;
+        expectTrue(reader.read(vitals) && vitals.gas_ohms == 7, "record should survive a publisher restart", failures);
+
+        // One thread publishing as fast as it can, two reading
+        std::atomic<bool> stop{false};
+        std::atomic<long> reads{0};
+        std::atomic<long> torn{0};
+        std::atomic<long> backwards{0};
+
+        auto readLoop = [&] {
+            uint32_t last = 0;
+            Vitals seen;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (!reader.read(seen)) continue;
+                if (!consistent(seen)) ++torn;
+                if (seen.gas_ohms < last) ++backwards;
+                last = seen.gas_ohms;
+                ++reads;
+            }
+        };
+        std::thread first(readLoop);
+        std::thread second(readLoop);
+
+        uint32_t published = 8;
+        auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+        while (std::chrono::steady_clock::now() < end) {
+            publisher.publish(vitalsFor(published++));
+        }
+        stop = true;
+        first.join();
+        second.join();
+
+        expectTrue(reads > 0, "readers should have read", failures);
+        expectEqual(std::to_string(torn.load()), "0", "no read should mix two records", failures);
+        expectEqual(std::to_string(backwards.load()), "0", "reads should never go back in time", failures);
+        expectTrue(reader.read(vitals) && vitals.gas_ohms == published - 1, "last write should be visible", failures);
+    }
+
+    {
+        // A publisher killed mid-write leaves the sequence odd: readers give
+        // up instead of spinning until it comes back
+        VitalsChannel publisher(name);
+        publisher.create();
+        publisher.publish(vitalsFor(42));
+
+        int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        void* mapped = fd >= 0 ? ::mmap(nullptr, 8, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        if (fd >= 0) ::close(fd);
+        expectTrue(mapped != MAP_FAILED, "segment should map for the test", failures);
+        if (mapped != MAP_FAILED) {
+            auto* sequence = static_cast<std::atomic<uint32_t>*>(mapped) + 1;   // after the magic
+            sequence->fetch_add(1);
+
+            VitalsChannel reader(name);
+            Vitals vitals;
+            auto start = std::chrono::steady_clock::now();
+            bool read = reader.read(vitals);
+            auto waited = std::chrono::steady_clock::now() - start;
+            expectTrue(!read, "a write stuck in progress should fail the read", failures);
+            expectTrue(waited < std::chrono::milliseconds(100), "and fail within a few milliseconds", failures);
+
+            publisher.publish(vitalsFor(43));
+            expectTrue(reader.read(vitals) && vitals.gas_ohms == 43, "the next publish should recover", failures);
+            ::munmap(mapped, 8);
+        }
+    }
+
+    VitalsChannel::remove(name);
+
+    if (failures == 0) {
+        std::cout << "PASS\n";
+        return 0;
+    }
+
+    std::cout << "FAILURES: " << failures << "\n";
+    return 1;
+}
@@ -4,112 +4,267 @@
 // Build from repo root:
 //   cmake -B build && cmake --build build
 // Run:
-//   sudo ./build/src/pifridge
+//   sudo ./build/src/pifridge [--http-port 8080]
 
 #include "BME680Sensor.hpp"
 #include "Bh1750Sensor.hpp"
 #include "DoorLightController.hpp"
 #include "BarcodeScanner.hpp"
 #include "Camera.hpp"
+#include "EventNotifier.hpp"
+#include "VitalsChannel.hpp"
+#include "SnapshotFileWriter.hpp"
+#include "InventoryStore.hpp"
+#include "InventoryCache.hpp"
+#include "HttpServer.hpp"
+#include "SensorHistory.hpp"
+#include "SeriesArchive.hpp"
+#include "JsonWriter.hpp"
 #include <fstream>
-#include <iomanip>
 #include <atomic>
 #include <chrono>
 #include <csignal>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <sstream>
+#include <string_view>
 #include <thread>
 #include <vector>
 #include <algorithm>
-#include <sqlite3.h>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <ctime>
 #include <unistd.h>
 
-struct FridgeState {
+// Everything the dashboard shows, at one moment. Never modified once
+// published: a change builds a new snapshot.
+struct FridgeSnapshot {
     BME680Sample    vitals{};
     bool            door_open = false;
-    std::mutex      mutex;
     double          lux = 0.0;
+    unsigned long   version = 0;    // +1 per change
 };
 
-// writes the JSON file that the API will serve to the PIFRIDGE app
-void saveStateToJson(const FridgeState& state) {
-    // We create the file in the current working directory (usually /build)
-    std::ofstream outFile("/tmp/fridge_data.json");
-    if (outFile.is_open()) {
-        outFile << "{\n"
-                << "  \"temperature\": " << std::fixed << std::setprecision(2) << state.vitals.temperature_c << ",\n"
-                << "  \"humidity\": " << state.vitals.humidity_rh << ",\n"
-                << "  \"pressure\": " << state.vitals.pressure_hpa << ",\n"
-                << "  \"lux\": " << state.lux << ",\n"
-                << "  \"door_open\": " << (state.door_open ? "true" : "false") << "\n"
-                << "}";
-        outFile.close();
+// The current FridgeSnapshot, swapped atomically. Readers take a shared_ptr
+// and never wait. Writers copy, change and swap under a mutex that covers
+// only that and the shared-memory publish: file I/O happens elsewhere,
+// so the sensor and door threads never wait on the disk.
+class FridgeState {
+public:
+    explicit FridgeState(VitalsChannel& channel) : channel_(channel) {}
+
+    std::shared_ptr<const FridgeSnapshot> current() const {
+        return std::atomic_load(&snapshot_);
     }
+
+    // Publish a copy of the current snapshot with @p change applied
+    template <typename Change>
+    std::shared_ptr<const FridgeSnapshot> update(Change change);
+
+private:
+    VitalsChannel& channel_;
+    std::mutex writeMutex_;   // one writer at a time, for the channel's seqlock
+    std::shared_ptr<const FridgeSnapshot> snapshot_ = std::make_shared<const FridgeSnapshot>();
+};
+
+// The readings pifridge_api serves, as published to the shared-memory channel
+static Vitals vitalsOf(const FridgeSnapshot& state) {
+    Vitals vitals;
+    vitals.temperature_c = state.vitals.temperature_c;
+    vitals.pressure_hpa  = state.vitals.pressure_hpa;
+    vitals.humidity_rh   = state.vitals.humidity_rh;
+    vitals.gas_ohms      = state.vitals.gas_ohms;
+    vitals.lux           = state.lux;
+    vitals.door_open     = state.door_open;
+    return vitals;
+}
+
+// Serialises the vitals shown on the dashboard as single-line JSON, so the
+// same string can be written to the file and sent as an SSE data line
+static std::string stateToJson(const FridgeSnapshot& state) {
+    return vitalsToJson(vitalsOf(state));
+}
+
+template <typename Change>
+std::shared_ptr<const FridgeSnapshot> FridgeState::update(Change change) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    auto next = std::make_shared<FridgeSnapshot>(*std::atomic_load(&snapshot_));
+    change(*next);
+    ++next->version;
+
+    std::shared_ptr<const FridgeSnapshot> published = std::move(next);
+    std::atomic_store(&snapshot_, published);
+    channel_.publish(vitalsOf(*published));
+    return published;
 }
 
 // Upserts a camera-detected item into inventory.
 // Matches on name (no barcode for loose produce).
-// Increments quantity if already exists, inserts new row if not.
-static void addCameraItemToInventory(const std::string& name) {
-    static const char* DB_PATH = "/var/lib/pifridge/inventory.db";
-
-    sqlite3* db = nullptr;
-    if (sqlite3_open(DB_PATH, &db) != SQLITE_OK) {
-        std::cerr << "[Camera] Failed to open inventory DB\n";
-        return;
+// Increments quantity if already exists, inserts new row if not — in a
+// single INSERT ... ON CONFLICT statement, so it can't race the scanner.
+static void addCameraItemToInventory(InventoryStore& store, const std::string& name) {
+    int quantity = store.upsertItem(name, "", 1, "");
+    if (quantity == 1) {
+        std::cout << "[Camera] Added to inventory: " << name << "\n";
+    } else if (quantity > 1) {
+        std::cout << "[Camera] Incremented inventory for: " << name << "\n";
     }
+}
 
-    // Check if item already exists by name (no barcode for camera detections)
-    const char* selectQuery =
-        "SELECT id, quantity FROM inventory WHERE name = ? AND (barcode IS NULL OR barcode = '');";
-    sqlite3_stmt* stmt = nullptr;
+// ---------------------------------------------------------------------------
+// Embedded HTTP server (--http-port) - read-only routes answered from memory
+// ---------------------------------------------------------------------------
+
+// Dashboard page, read once at startup; nginx serves it from the same place
+static std::string readIndexHtml() {
+    std::ifstream in("/var/www/pifridge/index.html", std::ios::binary);
+    std::ostringstream html;
+    html << in.rdbuf();
+    return html.str();
+}
 
-    if (sqlite3_prepare_v2(db, selectQuery, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "[Camera] Failed to prepare select\n";
-        sqlite3_close(db);
-        return;
+// Value of ?key=... in a query string. False if absent. The values read
+// here are numbers and series names, so nothing is percent-decoded.
+static bool queryValue(std::string_view query, std::string_view key, std::string& value) {
+    while (!query.empty()) {
+        size_t amp = query.find('&');
+        std::string_view pair = query.substr(0, amp);
+        query = amp == std::string_view::npos ? std::string_view() : query.substr(amp + 1);
+
+        size_t eq = pair.find('=');
+        if (pair.substr(0, eq) != key) continue;
+        value = eq == std::string_view::npos ? std::string() : std::string(pair.substr(eq + 1));
+        return true;
     }
+    return false;
+}
+
+// @p text as an integer, or @p fallback if it is empty or not one
+static long long numberOr(const std::string& text, long long fallback) {
+    char* end = nullptr;
+    long long number = std::strtoll(text.c_str(), &end, 10);
+    return !text.empty() && *end == '\0' ? number : fallback;
+}
+
+static int64_t unixMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Points per series when ?step= is not given: enough for a chart
+static const int64_t DEFAULT_HISTORY_POINTS = 300;
+
+// Largest ?from=, ?to= or ?step= in seconds: in milliseconds, a time plus
+// a step still fits in int64_t
+static const long long MAX_HISTORY_SECONDS = INT64_MAX / 1000 / 2;
+
+// Same bodies, ETags and 304s as pifridge_api's GET /, /api/fridge and
+// /api/inventory, without the trip through nginx and FastCGI. Also the one
+// place /api/fridge/history is served, since the history lives here.
+static void addHttpRoutes(HttpServer& server, FridgeState& state, InventoryCache& cache,
+                          const SensorHistory& history) {
+    auto html = std::make_shared<const std::string>(readIndexHtml());
+    auto page = [html](const HttpServer::Request&, HttpServer::Response& response) {
+        response.contentType = "text/html; charset=utf-8";
+        response.body = *html;
+    };
+    server.route("/", page);
+    server.route("/index.html", page);
+
+    server.route("/api/fridge", [&state](const HttpServer::Request&, HttpServer::Response& response) {
+        response.body = stateToJson(*state.current());
+    });
 
-    sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
-
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        // Exists — increment quantity
-        int id  = sqlite3_column_int(stmt, 0);
-        int qty = sqlite3_column_int(stmt, 1);
-        sqlite3_finalize(stmt);
-
-        const char* updateQuery = "UPDATE inventory SET quantity = ? WHERE id = ?;";
-        sqlite3_stmt* upStmt = nullptr;
-        if (sqlite3_prepare_v2(db, updateQuery, -1, &upStmt, nullptr) == SQLITE_OK) {
-            sqlite3_bind_int(upStmt, 1, qty + 1);
-            sqlite3_bind_int(upStmt, 2, id);
-            sqlite3_step(upStmt);
-            sqlite3_finalize(upStmt);
-            std::cout << "[Camera] Incremented inventory for: " << name << "\n";
+    server.route("/api/inventory", [&cache](const HttpServer::Request& request, HttpServer::Response& response) {
+        auto snapshot = cache.current();
+        if (!snapshot) {
+            response.status = 503;
+            response.body = "{\"error\": \"database unavailable\"}";
+            return;
         }
-    } else {
-        // Does not exist — insert new row with empty barcode
-        sqlite3_finalize(stmt);
-
-        time_t now = time(nullptr);
-        char dateBuf[11];
-        strftime(dateBuf, sizeof(dateBuf), "%Y-%m-%d", localtime(&now));
-
-        const char* insertQuery =
-            "INSERT INTO inventory (name, barcode, quantity, date_added) VALUES (?, '', 1, ?);";
-        sqlite3_stmt* insStmt = nullptr;
-
-        if (sqlite3_prepare_v2(db, insertQuery, -1, &insStmt, nullptr) == SQLITE_OK) {
-            sqlite3_bind_text(insStmt, 1, name.c_str(), -1, SQLITE_STATIC);
-            sqlite3_bind_text(insStmt, 2, dateBuf,      -1, SQLITE_STATIC);
-            sqlite3_step(insStmt);
-            sqlite3_finalize(insStmt);
-            std::cout << "[Camera] Added to inventory: " << name << "\n";
+        response.headers = "Cache-Control: no-cache\r\n";
+
+        std::string value;
+        if (queryValue(request.query, "since", value)) {
+            long long since = numberOr(value, -1);   // unreadable — resend everything
+            if (since == snapshot->version) {
+                response.status = 304;
+                return;
+            }
+            JsonWriter json = JsonWriter::toString(response.body);
+            snapshot->writeChangesSince(since, json);
+            json.flush();
+            return;
         }
-    }
 
-    sqlite3_close(db);
+        // Body and ETag come from the same snapshot, so they always agree
+        std::string etag = "\"v" + std::to_string(snapshot->version) + "\"";
+        response.headers += "ETag: " + etag + "\r\n";
+        if (request.ifNoneMatch == etag) {
+            response.status = 304;
+            return;
+        }
+        response.body = snapshot->listing();
+    });
+
+    // ?from=&to= in Unix seconds (default: the last 24 h), ?step= in
+    // seconds, ?series= a comma-separated subset. ?points= instead of
+    // ?step= downsamples to that many points, ?mode=lttb (default) or minmax.
+    server.route("/api/fridge/history", [&history](const HttpServer::Request& request,
+                                                   HttpServer::Response& response) {
+        int64_t now = unixMs();
+        std::string value;
+        long long to   = queryValue(request.query, "to", value)   ? numberOr(value, -1) : now / 1000;
+        long long from = queryValue(request.query, "from", value) ? numberOr(value, -1) : to - 24 * 3600;
+        long long step = queryValue(request.query, "step", value) ? numberOr(value, -1) : 0;
+        unsigned series = SensorHistory::ALL_SERIES;
+
+        if (from < 0 || to <= from || step < 0 || to > MAX_HISTORY_SECONDS || step > MAX_HISTORY_SECONDS) {
+            response.status = 400;
+            response.body = "{\"error\": \"invalid range\"}";
+            return;
+        }
+        if (queryValue(request.query, "series", value) && !SensorHistory::parseSeries(value, series)) {
+            response.status = 400;
+            response.body = "{\"error\": \"unknown series\"}";
+            return;
+        }
+
+        int64_t fromMs = from * 1000;
+        int64_t toMs = to * 1000;
+
+        if (queryValue(request.query, "points", value)) {
+            long long points = numberOr(value, -1);
+            auto mode = SensorHistory::Downsample::LTTB;
+            if (points < 2) {
+                response.status = 400;
+                response.body = "{\"error\": \"invalid points\"}";
+                return;
+            }
+            if (queryValue(request.query, "mode", value) && !SensorHistory::parseDownsample(value, mode)) {
+                response.status = 400;
+                response.body = "{\"error\": \"unknown mode\"}";
+                return;
+            }
+            points = std::min<long long>(points, SensorHistory::MAX_POINTS);
+
+            response.headers = "Cache-Control: no-cache\r\n";
+            JsonWriter json = JsonWriter::toString(response.body);
+            history.writeDownsampledJson(fromMs, toMs, static_cast<size_t>(points), mode, series, json);
+            json.flush();
+            return;
+        }
+
+        int64_t stepMs = step > 0 ? step * 1000 : (toMs - fromMs) / DEFAULT_HISTORY_POINTS;
+        stepMs = SensorHistory::stepFor(fromMs, toMs, stepMs, now);
+
+        response.headers = "Cache-Control: no-cache\r\n";
+        JsonWriter json = JsonWriter::toString(response.body);
+        history.writeJson(fromMs, toMs, stepMs, series, json);
+        json.flush();
+    });
 }
 
 // ---------------------------------------------------------------------------
@@ -118,12 +273,54 @@ static void addCameraItemToInventory(const std::string& name) {
 static std::atomic<bool> g_quit{false};
 static void sigHandler(int) { g_quit = true; }
 
-int main() {
+int main(int argc, char** argv) {
     std::signal(SIGINT,  sigHandler);
     std::signal(SIGTERM, sigHandler);
 
+    // Latest vitals for pifridge_api's GET /api/fridge, read from shared
+    // memory without a file or a lock. FridgeState publishes every change.
+    VitalsChannel vitalsChannel;
+    if (!vitalsChannel.create()) {
+        std::cerr << "[Vitals] Failed to create shared memory " << VitalsChannel::DEFAULT_NAME << "\n";
+    }
+
     // -- Shared state --
-    FridgeState state;
+    FridgeState state(vitalsChannel);
+
+    // /tmp/fridge_data.json, for scripts and debugging. Written from its own
+    // low-priority thread, at most every 500 ms, whatever the update rate.
+    SnapshotFileWriter stateFile("/tmp/fridge_data.json",
+                                 [&state] { return stateToJson(*state.current()); },
+                                 std::chrono::milliseconds(500));
+    stateFile.start();
+
+    // Pushes vitals and inventory changes to browsers via pifridge_api's
+    // /api/events stream
+    EventNotifier events;
+
+    // Every sample, for /api/fridge/history: 24 h raw, plus minute and hour
+    // roll-ups updated as each sample is recorded
+    SensorHistory history;
+
+    // And every sample on disk, compressed, so the history outlives a
+    // restart: the last 7 days go back into the rings now, and the rest of
+    // the last 90 days into the hour roll-up. New samples are flushed once a minute
+    // from a low-priority thread.
+    SeriesArchive archive("/var/lib/pifridge/history");
+    if (archive.open()) {
+        archive.replay(history, unixMs());
+        archive.start();
+    }
+
+    auto recordSample = [&history, &archive](SensorHistory::Series series, int64_t timeMs, double value) {
+        history.record(series, timeMs, value);
+        archive.record(series, timeMs, value);
+    };
+
+    // The inventory: an in-memory copy for the HTTP server's reads, and one
+    // connection for the camera's writes, opened on its first detection
+    InventoryCache inventoryCache("/var/lib/pifridge/inventory.db");
+    InventoryStore cameraStore("/var/lib/pifridge/inventory.db", "camera");
 
 // ---------------------------------------------------------------------------
 // main
@@ -149,11 +346,14 @@ int main() {
     );
 
     bme680.registerCallback([&](const BME680Sample& sample) {
-        {
-            std::lock_guard<std::mutex> lock(state.mutex);
-            state.vitals = sample;
-            saveStateToJson(state); // Export to JSON whenever climate updates
-        }
+        auto snapshot = state.update([&sample](FridgeSnapshot& next) { next.vitals = sample; });
+        int64_t now = unixMs();
+        recordSample(SensorHistory::TEMPERATURE, now, sample.temperature_c);
+        recordSample(SensorHistory::HUMIDITY, now, sample.humidity_rh);
+        recordSample(SensorHistory::PRESSURE, now, sample.pressure_hpa);
+        recordSample(SensorHistory::GAS, now, sample.gas_ohms);
+        stateFile.notify();
+        events.publish("vitals", stateToJson(*snapshot));
         std::cout
             << "[BME680] "
             << "T="   << sample.temperature_c << "°C  "
@@ -168,15 +368,13 @@ int main() {
         std::string code = barcode;
 
         std::cout << "[Barcode] Scanned: " << code << "\n";
-        fetch_product(code);
+        fetch_product(scanner.inventory(), code);
+        events.publish("inventory", "{}");
 
         std::this_thread::sleep_for(std::chrono::milliseconds(1000));
         // Re-arm the scanner if the door is still open
-        {
-            std::lock_guard<std::mutex> lock(state.mutex);
-            if (state.door_open) {
-                scanner.triggerScan();
-            }
+        if (state.current()->door_open) {
+            scanner.triggerScan();
         }
     });
 
@@ -216,8 +414,16 @@ int main() {
 
     camera.registerCallback([&](const CameraEvent& event) {
         if (event.type == CameraEvent::Type::Object) {
+            // open() is a no-op once it has succeeded
+            if (!cameraStore.open()) {
+                std::cerr << "[Camera] Failed to open inventory DB\n";
+                return;
+            }
             for (const auto& label : event.labels) {
-                addCameraItemToInventory(label);
+                addCameraItemToInventory(cameraStore, label);
+            }
+            if (!event.labels.empty()) {
+                events.publish("inventory", "{}");
             }
         }
 
@@ -237,12 +443,12 @@ int main() {
 
     // Callback: fires only when door state CHANGES (open->closed or closed->open)
     doorController.registerDoorStateCallback([&](bool isOpen, double lux) {
-        {
-            std::lock_guard<std::mutex> lock(state.mutex);
-            state.door_open = isOpen;
-            state.lux = lux;
-            saveStateToJson(state); // Export to JSON whenever door state changes
-        }
+        auto snapshot = state.update([isOpen, lux](FridgeSnapshot& next) {
+            next.door_open = isOpen;
+            next.lux = lux;
+        });
+        stateFile.notify();
+        events.publish("vitals", stateToJson(*snapshot));
 
         camera.setDoorOpen(isOpen); // tell camera bout the door state so it can trigger immediate capture
 
@@ -261,8 +467,22 @@ int main() {
         /*i2cAddress=*/    0x23
     );
 
-    lightSensor.registerCallback([&doorController](double lux) {
+    // Live lux for the event stream. Samples arrive every 200 ms, so only
+    // push when the reading has moved noticeably since the last push.
+    double lastPushedLux = -1.0;
+
+    lightSensor.registerCallback([&](double lux) {
         doorController.hasLightSample(lux);
+
+        // A copy and a few stores, so every sample; only this thread
+        // touches lastPushedLux
+        auto snapshot = state.update([lux](FridgeSnapshot& next) { next.lux = lux; });
+        recordSample(SensorHistory::LUX, unixMs(), lux);
+        if (std::abs(lux - lastPushedLux) >= 1.0) {
+            lastPushedLux = lux;
+            stateFile.notify();
+            events.publish("vitals", stateToJson(*snapshot));
+        }
     });
 
     bme680.start();
@@ -271,7 +491,16 @@ int main() {
     lightSensor.start(/*intervalMs=*/ 200);
     std::cout << "PiFridge: Light Sensor Thread Started" << std::endl;
 
-    // sever.start()
+    // Optional: answer the dashboard's reads directly, bypassing nginx and
+    // FastCGI. Writes still go to pifridge_api.
+    uint16_t httpPort = HttpServer::portFromArgs(argc, argv);
+    HttpServer server(httpPort);
+    if (httpPort != 0) {
+        addHttpRoutes(server, state, inventoryCache, history);
+        if (server.start()) {
+            std::cout << "PiFridge: HTTP server listening on port " << server.port() << std::endl;
+        }
+    }
 
     std::cout << "PiFridge running. Press Ctrl+C to stop.\n";
 
@@ -281,10 +510,13 @@ int main() {
 
     //----- Clean shutdown -----
     std::cout << "\nPiFridge shutting down...\n";
+    server.stop();
     lightSensor.stop();
     bme680.stop();
     scanner.stop();
     camera.stop();
+    stateFile.stop();   // writes the final state
+    archive.stop();     // flushes the last samples
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "FcgiWorkerPool.hpp"
+
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+// Serialises FCGX_Accept_r across workers, as in the libfcgi threaded example.
+// Only one thread sits in accept() at a time; the rest are handling requests.
+std::mutex acceptMutex;
+}
+
+FcgiWorkerPool::FcgiWorkerPool(int socketFd, int workers, std::string logPrefix)
+    : socketFd_(socketFd),
+      workers_(workers < 1 ? 1 : workers),
+      logPrefix_(std::move(logPrefix)) {}
+
+void FcgiWorkerPool::run(const HandlerFactory& makeHandler) {
+    std::vector<std::thread> threads;
+    threads.reserve(static_cast<size_t>(workers_));
+
+    for (int i = 0; i < workers_; ++i) {
+        threads.emplace_back(&FcgiWorkerPool::workerLoop, this, std::cref(makeHandler));
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+void FcgiWorkerPool::workerLoop(const HandlerFactory& makeHandler) {
+    // Heap-allocated so a handler can keep a request past this iteration
+    auto request = std::make_unique<FCGX_Request>();
+    if (FCGX_InitRequest(request.get(), socketFd_, 0) != 0) {
+        std::cerr << logPrefix_ << " FCGX_InitRequest failed\n";
+        return;
+    }
+
+    Handler handler = makeHandler();
+
+    while (true) {
+        int rc;
+        {
+            std::lock_guard<std::mutex> lock(acceptMutex);
+            rc = FCGX_Accept_r(request.get());
+        }
+        if (rc < 0) break;
+
+        Result result = Result::Finished;
+
+        // A malformed request (e.g. a non-numeric id) must not take the
+        // whole process down with it
+        try {
+            result = handler(*request);
+        } catch (const std::exception& e) {
+            std::cerr << logPrefix_ << " Request failed: " << e.what() << "\n";
+            FCGX_FPrintF(request->out,
+                "Status: 400 Bad Request\r\n"
+                "Content-Type: application/json\r\n"
+                "\r\n"
+                "{\"error\": \"bad request\"}");
+        }
+
+        if (result == Result::Detached) {
+            // The handler owns the old request now; accept into a fresh one
+            request.release();
+            request = std::make_unique<FCGX_Request>();
+            if (FCGX_InitRequest(request.get(), socketFd_, 0) != 0) {
+                std::cerr << logPrefix_ << " FCGX_InitRequest failed\n";
+                return;
+            }
+        } else {
+            FCGX_Finish_r(request.get());
+        }
+    }
+}
+
+int FcgiWorkerPool::workersFromArgs(int argc, char** argv, int fallback) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--workers") == 0) {
+            int n = std::atoi(argv[i + 1]);
+            return n > 0 ? n : fallback;
+        }
+    }
+    return fallback;
+}
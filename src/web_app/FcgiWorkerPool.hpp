@@ -0,0 +1,69 @@
+#pragma once
+
+#include <fcgiapp.h>
+
+#include <functional>
+#include <string>
+
+/**
+ * @brief Fixed pool of threads serving one FastCGI listen socket.
+ *
+ * Each worker owns its own FCGX_Request and its own handler, so per-worker
+ * state such as a database connection is never shared between threads.
+ * A slow request only occupies one worker; the others keep accepting.
+ *
+ * Usage:
+ * @code
+ *   FcgiWorkerPool pool(socketFd, 4, "[inventory]");
+ *   pool.run([] {
+ *       auto store = std::make_shared<InventoryStore>(DB_PATH);
+ *       return [store](FCGX_Request& request) {
+ *           handle(*store, request);
+ *           return FcgiWorkerPool::Result::Finished;
+ *       };
+ *   });
+ * @endcode
+ */
+class FcgiWorkerPool {
+public:
+    /** What a handler did with the request it was given. */
+    enum class Result {
+        Finished,   ///< Response written; the pool calls FCGX_Finish_r
+        Detached,   ///< Handler took ownership (e.g. an event stream)
+    };
+
+    /**
+     * Handles one accepted request. The request is heap-allocated; a handler
+     * that returns Detached now owns it and must FCGX_Finish_r and delete it.
+     */
+    using Handler = std::function<Result(FCGX_Request&)>;
+
+    /** Called once on each worker thread to build that worker's handler. */
+    using HandlerFactory = std::function<Handler()>;
+
+    /**
+     * @param socketFd  Listen socket returned by FCGX_OpenSocket
+     * @param workers   Number of worker threads (at least 1)
+     * @param logPrefix Prefix for log lines, e.g. "[inventory]"
+     */
+    FcgiWorkerPool(int socketFd, int workers, std::string logPrefix);
+
+    /** Start the workers and block until all of them have exited. */
+    void run(const HandlerFactory& makeHandler);
+
+    int workers() const { return workers_; }
+
+    /**
+     * @brief Read the worker count from "--workers N" on the command line.
+     *
+     * @return @p fallback if the option is absent or not a positive number.
+     */
+    static int workersFromArgs(int argc, char** argv, int fallback);
+
+private:
+    void workerLoop(const HandlerFactory& makeHandler);
+
+    int socketFd_;
+    int workers_;
+    std::string logPrefix_;
+};
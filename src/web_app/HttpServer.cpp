@@ -0,0 +1,383 @@
+#include "HttpServer.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+
+namespace {
+
+const char* reasonPhrase(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 431: return "Request Header Fields Too Large";
+    case 503: return "Service Unavailable";
+    default:  return "Error";
+    }
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && strncasecmp(a.data(), b.data(), a.size()) == 0;
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+    return text;
+}
+
+} // namespace
+
+HttpServer::HttpServer(uint16_t port) : port_(port) {}
+
+HttpServer::~HttpServer() {
+    stop();
+}
+
+void HttpServer::route(std::string path, Handler handler) {
+    routes_[std::move(path)] = std::move(handler);
+}
+
+bool HttpServer::start() {
+    listenFd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        std::cerr << "[http] socket failed: " << strerror(errno) << "\n";
+        return false;
+    }
+
+    int one = 1;
+    ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port_);
+    if (::bind(listenFd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listenFd_, 128) != 0) {
+        std::cerr << "[http] bind/listen on port " << port_ << " failed: " << strerror(errno) << "\n";
+        ::close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+
+    socklen_t length = sizeof(addr);
+    ::getsockname(listenFd_, reinterpret_cast<sockaddr*>(&addr), &length);
+    port_ = ntohs(addr.sin_port);
+
+    // eventfd wakes the blocked epoll thread during shutdown
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    stopFd_  = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    epoll_event listenEvent{};
+    listenEvent.events  = EPOLLIN;
+    listenEvent.data.fd = listenFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &listenEvent);
+    epoll_event stopEvent{};
+    stopEvent.events  = EPOLLIN;
+    stopEvent.data.fd = stopFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, stopFd_, &stopEvent);
+
+    running_ = true;
+    thread_ = std::thread(&HttpServer::run, this);
+    return true;
+}
+
+void HttpServer::stop() {
+    if (running_.exchange(false)) {
+        uint64_t one = 1;
+        ::write(stopFd_, &one, sizeof(one));
+    }
+    if (thread_.joinable()) thread_.join();
+
+    for (auto& entry : connections_) ::close(entry.first);
+    connections_.clear();
+
+    if (listenFd_ >= 0) { ::close(listenFd_); listenFd_ = -1; }
+    if (epollFd_ >= 0)  { ::close(epollFd_);  epollFd_ = -1; }
+    if (stopFd_ >= 0)   { ::close(stopFd_);   stopFd_ = -1; }
+}
+
+uint16_t HttpServer::portFromArgs(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--http-port") == 0) {
+            int n = std::atoi(argv[i + 1]);
+            return n > 0 && n <= 65535 ? static_cast<uint16_t>(n) : 0;
+        }
+    }
+    return 0;
+}
+
+void HttpServer::run() {
+    epoll_event events[64];
+    time_t lastSweep = time(nullptr);
+
+    while (running_) {
+        int ready = epoll_wait(epollFd_, events, 64, 1000);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[http] epoll_wait failed: " << strerror(errno) << "\n";
+            break;
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == stopFd_) return;
+            if (fd == listenFd_) {
+                acceptAll();
+                continue;
+            }
+
+            auto it = connections_.find(fd);
+            if (it == connections_.end()) continue;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                close(fd);
+                continue;
+            }
+            if (events[i].events & EPOLLIN)  readFrom(fd, it->second);
+            // readFrom may have closed it
+            it = connections_.find(fd);
+            if (it != connections_.end() && (events[i].events & EPOLLOUT)) writeTo(fd, it->second);
+        }
+
+        time_t now = time(nullptr);
+        if (now != lastSweep) {
+            lastSweep = now;
+            closeIdle(now);
+        }
+    }
+}
+
+void HttpServer::acceptAll() {
+    for (;;) {
+        int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;   // EAGAIN: accepted everything pending
+
+        if (connections_.size() >= MAX_CONNECTIONS) {
+            ::close(fd);
+            continue;
+        }
+
+        // Responses go out in one write; don't hold them back for an ACK
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        Connection& connection = connections_[fd];
+        connection.lastActive = time(nullptr);
+        connection.events = EPOLLIN;
+        epoll_event event{};
+        event.events  = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+void HttpServer::readFrom(int fd, Connection& connection) {
+    char buffer[4096];
+    bool ended = false;
+
+    // No more than one request head's worth a wakeup: epoll is level
+    // triggered, so the rest is read once what is buffered is answered, and
+    // answer() refuses a head that doesn't end within it. After a refused
+    // request the rest of the input is ignored.
+    while (!connection.closing && connection.in.size() <= MAX_REQUEST_BYTES) {
+        ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            connection.in.append(buffer, static_cast<size_t>(n));
+            continue;
+        }
+        if (n == 0) {
+            ended = true;
+            break;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        close(fd);
+        return;
+    }
+
+    connection.lastActive = time(nullptr);
+    answer(connection);
+
+    // The client has stopped sending: answer what it sent, then close
+    if (ended) connection.closing = true;
+    writeTo(fd, connection);
+}
+
+void HttpServer::writeTo(int fd, Connection& connection) {
+    while (connection.sent < connection.out.size()) {
+        ssize_t n = ::send(fd, connection.out.data() + connection.sent,
+                           connection.out.size() - connection.sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                watch(fd, connection);
+                return;
+            }
+            close(fd);
+            return;
+        }
+        // A slow reader taking a long response is busy, not idle
+        if (n > 0) connection.lastActive = time(nullptr);
+        connection.sent += static_cast<size_t>(n);
+    }
+
+    connection.out.clear();
+    connection.sent = 0;
+    if (connection.closing) {
+        close(fd);
+        return;
+    }
+    watch(fd, connection);
+}
+
+void HttpServer::answer(Connection& connection) {
+    size_t consumed = 0;
+
+    while (!connection.closing) {
+        size_t end = connection.in.find("\r\n\r\n", consumed);
+        if (end == std::string::npos) {
+            if (connection.in.size() - consumed > MAX_REQUEST_BYTES) {
+                Response response;
+                response.status = 431;
+                response.body = "{\"error\": \"request too large\"}";
+                respond(connection, Request{}, response, false);
+            }
+            break;
+        }
+
+        std::string_view head(connection.in.data() + consumed, end - consumed);
+        consumed = end + 4;
+
+        // Request line: METHOD SP target SP HTTP/1.x
+        size_t lineEnd = head.find("\r\n");
+        std::string_view line = head.substr(0, lineEnd);
+        size_t firstSpace = line.find(' ');
+        size_t lastSpace  = line.rfind(' ');
+        if (firstSpace == std::string_view::npos || lastSpace == firstSpace ||
+            line.substr(lastSpace + 1, 7) != "HTTP/1.") {
+            Response response;
+            response.status = 400;
+            response.body = "{\"error\": \"bad request\"}";
+            respond(connection, Request{}, response, false);
+            break;
+        }
+
+        Request request;
+        request.method = line.substr(0, firstSpace);
+        std::string_view target = line.substr(firstSpace + 1, lastSpace - firstSpace - 1);
+        size_t question = target.find('?');
+        request.path  = target.substr(0, question);
+        request.query = question == std::string_view::npos ? std::string_view() : target.substr(question + 1);
+
+        // HTTP/1.1 keeps the connection unless told otherwise; 1.0 the reverse
+        bool keepAlive = line.substr(lastSpace + 1) != "HTTP/1.0";
+        bool hasBody = false;
+
+        std::string_view headers = lineEnd == std::string_view::npos ? std::string_view() : head.substr(lineEnd + 2);
+        while (!headers.empty()) {
+            size_t next = headers.find("\r\n");
+            std::string_view header = headers.substr(0, next);
+            headers = next == std::string_view::npos ? std::string_view() : headers.substr(next + 2);
+
+            size_t colon = header.find(':');
+            if (colon == std::string_view::npos) continue;
+            std::string_view name  = header.substr(0, colon);
+            std::string_view value = trim(header.substr(colon + 1));
+
+            if (equalsIgnoreCase(name, "Connection")) {
+                if (equalsIgnoreCase(value, "close")) keepAlive = false;
+                else if (equalsIgnoreCase(value, "keep-alive")) keepAlive = true;
+            } else if (equalsIgnoreCase(name, "If-None-Match")) {
+                request.ifNoneMatch = value;
+            } else if (equalsIgnoreCase(name, "Content-Length")) {
+                hasBody = value != "0";
+            } else if (equalsIgnoreCase(name, "Transfer-Encoding")) {
+                hasBody = true;
+            }
+        }
+
+        Response response;
+        bool readOnly = request.method == "GET" || request.method == "HEAD";
+        auto route = routes_.find(request.path);
+
+        if (!readOnly || hasBody) {
+            // Without reading the body the next request can't be found, so close
+            response.status = 405;
+            response.headers = "Allow: GET, HEAD\r\n";
+            response.body = "{\"error\": \"method not supported\"}";
+            keepAlive = false;
+        } else if (route == routes_.end()) {
+            response.status = 404;
+            response.body = "{\"error\": \"not found\"}";
+        } else {
+            route->second(request, response);
+        }
+        respond(connection, request, response, keepAlive);
+    }
+
+    connection.in.erase(0, consumed);
+}
+
+void HttpServer::respond(Connection& connection, const Request& request, Response& response, bool keepAlive) {
+    bool withBody = request.method != "HEAD" && response.status != 304;
+
+    std::string& out = connection.out;
+    out += "HTTP/1.1 ";
+    out += std::to_string(response.status);
+    out += ' ';
+    out += reasonPhrase(response.status);
+    out += "\r\nContent-Type: ";
+    out += response.contentType;
+    out += "\r\nContent-Length: ";
+    out += std::to_string(response.body.size());
+    out += "\r\nAccess-Control-Allow-Origin: *\r\n";
+    if (!keepAlive) out += "Connection: close\r\n";
+    out += response.headers;
+    out += "\r\n";
+    if (withBody) out += response.body;
+
+    if (!keepAlive) connection.closing = true;
+}
+
+void HttpServer::watch(int fd, Connection& connection) {
+    size_t queued = connection.out.size() - connection.sent;
+
+    // A client that pipelines requests without reading the responses is
+    // not read from until it catches up
+    bool reading = !connection.closing && queued < MAX_QUEUED_BYTES;
+    uint32_t events = (reading ? EPOLLIN : 0u) | (queued > 0 ? EPOLLOUT : 0u);
+    if (events == connection.events) return;   // the usual case: one syscall saved per request
+
+    connection.events = events;
+    epoll_event event{};
+    event.events  = events;
+    event.data.fd = fd;
+    epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event);
+}
+
+void HttpServer::close(int fd) {
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections_.erase(fd);
+}
+
+void HttpServer::closeIdle(time_t now) {
+    for (auto it = connections_.begin(); it != connections_.end();) {
+        int fd = it->first;
+        bool idle = now - it->second.lastActive >= IDLE_TIMEOUT_SECONDS;
+        ++it;
+        if (idle) close(fd);
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+/**
+ * @brief Minimal HTTP/1.1 server for read-only routes, on one epoll thread.
+ *
+ * Lets the pifridge daemon answer GET /, /api/fridge and /api/inventory
+ * from the state it already holds, without the nginx -> FastCGI socket ->
+ * pifridge_api round trip. Connections are kept alive, and pipelined
+ * requests are answered in order.
+ *
+ * Only GET and HEAD are served; anything else gets 405 and the connection
+ * is closed, so request bodies never need reading. Writes stay with
+ * pifridge_api behind nginx.
+ *
+ * Handlers run on the server thread, one request at a time, and must not
+ * block: they build the whole response from memory.
+ *
+ * Usage:
+ * @code
+ *   HttpServer server(8080);
+ *   server.route("/api/fridge", [&](const HttpServer::Request&, HttpServer::Response& response) {
+ *       response.body = currentVitalsJson();
+ *   });
+ *   server.start();
+ * @endcode
+ */
+class HttpServer {
+public:
+    /** One parsed request. Views point into the connection's buffer. */
+    struct Request {
+        std::string_view method;        ///< "GET" or "HEAD"
+        std::string_view path;          ///< Target without the query string
+        std::string_view query;         ///< After '?'; empty if none
+        std::string_view ifNoneMatch;   ///< If-None-Match header; empty if none
+    };
+
+    struct Response {
+        int         status = 200;
+        std::string contentType = "application/json";
+        std::string headers;            ///< Extra header lines, each ending "\r\n"
+        std::string body;               ///< Not sent for HEAD or 304
+    };
+
+    using Handler = std::function<void(const Request&, Response&)>;
+
+    /** @param port TCP port on all interfaces; 0 picks a free one (see port()). */
+    explicit HttpServer(uint16_t port);
+    ~HttpServer();
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    /** Serve GET and HEAD of exactly @p path. Add routes before start(). */
+    void route(std::string path, Handler handler);
+
+    /** Bind, listen and start the server thread. */
+    bool start();
+
+    /** Stop the thread and close every connection. */
+    void stop();
+
+    /** Port listened on, once started. */
+    uint16_t port() const { return port_; }
+
+    /**
+     * @brief Read the port from "--http-port N" on the command line.
+     * @return 0 (server off) if the option is absent or not a valid port.
+     */
+    static uint16_t portFromArgs(int argc, char** argv);
+
+    /** Longest request head (request line and headers) accepted. */
+    static constexpr size_t MAX_REQUEST_BYTES = 8 * 1024;
+
+    /** Open connections beyond this are closed as soon as they are accepted. */
+    static constexpr size_t MAX_CONNECTIONS = 256;
+
+    /** An idle keep-alive connection is closed after this long. */
+    static constexpr int IDLE_TIMEOUT_SECONDS = 30;
+
+    /** Unsent response bytes at which a connection stops being read. */
+    static constexpr size_t MAX_QUEUED_BYTES = 1024 * 1024;
+
+private:
+    struct Connection {
+        std::string in;            // bytes received, not yet answered
+        std::string out;           // bytes to send
+        size_t      sent = 0;      // of out
+        bool        closing = false;   // close once out is sent
+        time_t      lastActive = 0;
+        uint32_t    events = 0;    // polled for, as last set by watch()
+    };
+
+    void run();
+    void acceptAll();
+    void readFrom(int fd, Connection& connection);
+    void writeTo(int fd, Connection& connection);
+
+    /** Answer every complete request in the buffer, in order. */
+    void answer(Connection& connection);
+    void respond(Connection& connection, const Request& request, Response& response, bool keepAlive);
+
+    /** Poll @p fd for what @p connection is waiting on. */
+    void watch(int fd, Connection& connection);
+    void close(int fd);
+    void closeIdle(time_t now);
+
+    uint16_t port_;
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    int stopFd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    std::map<std::string, Handler, std::less<>> routes_;
+    std::unordered_map<int, Connection> connections_;   // server thread only
+};
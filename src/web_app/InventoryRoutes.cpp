@@ -0,0 +1,717 @@
+// InventoryRoutes.cpp
+// Inventory routes of pifridge_api:
+//
+// GET  /api/inventory        — returns all items as JSON (ETag / 304 aware)
+// GET  /api/inventory?since=N — returns only what changed after version N
+// GET  /api/inventory?limit=&cursor=&... — one filtered page, by cursor
+// GET  /api/inventory?id=|barcode=|name= — returns the matching items
+// GET  /api/inventory/search?q= — ranked prefix search over names and barcodes
+// GET  /api/inventory/expiring?within=3d — dated items expiring soonest first
+// GET  /api/inventory/history?from=&to=&name= — daily added/removed totals
+// GET  /api/inventory/export?format=ndjson|csv — every item, streamed
+// POST /api/inventory        — adds a new item (JSON body)
+// POST /api/inventory/delete — deletes an item by id (JSON body)
+// POST /api/inventory/update — updates an item by id (JSON body)
+// POST /api/inventory/increment, /decrement — adjusts quantity by 1 (JSON body)
+// POST /api/inventory/batch  — several of the above in one transaction
+// POST /api/inventory/import?format=ndjson|csv — bulk add from an export
+// GET  /api/admin/backup     — progress and outcome of online backups
+// POST /api/admin/backup     — starts a backup now
+
+#include "InventoryRoutes.hpp"
+
+#include "BestBefore.hpp"
+#include "InventoryTransfer.hpp"
+#include "JsonView.hpp"
+#include "JsonWriter.hpp"
+
+#include <fcgiapp.h>
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Online backups of DB_PATH: where they go, how often, and how many are kept
+static const char* BACKUP_DIR = "/var/lib/pifridge/backups";
+static const std::chrono::minutes BACKUP_INTERVAL(24 * 60);
+static const size_t BACKUP_KEEP = 7;
+
+// Results per /api/inventory/search request: default and ceiling for ?limit=
+static const int DEFAULT_SEARCH_RESULTS = 10;
+static const int MAX_SEARCH_RESULTS     = 50;
+
+// Horizon of /api/inventory/expiring: default and ceiling for ?within=, in days
+static const int DEFAULT_EXPIRY_DAYS = 3;
+static const int MAX_EXPIRY_DAYS     = 365;
+
+// /api/inventory/history: days shown without ?from=, and the longest range
+static const int DEFAULT_HISTORY_DAYS = 30;
+static const int MAX_HISTORY_DAYS     = 366;
+
+// How often pending inventory events are rolled up into daily totals.
+// A history request also rolls up first, so this only bounds its work.
+static const std::chrono::minutes HISTORY_ROLLUP_INTERVAL(10);
+
+// Items per page of GET /api/inventory: default and ceiling for ?limit=
+static const size_t DEFAULT_PAGE_ITEMS = 50;
+static const size_t MAX_PAGE_ITEMS     = 500;
+
+// Longest body the single-operation and batch routes read: a full batch
+// of MAX_BATCH_OPERATIONS fits several times over
+static const size_t MAX_POST_BODY_BYTES = 128 * 1024;
+
+// Bytes of an import body read per FCGX_GetStr; the importer keeps only
+// the row it is in the middle of between reads
+static const size_t IMPORT_CHUNK_BYTES = 16 * 1024;
+
+// Any of these switches GET /api/inventory to the paged form
+static const char* const PAGE_PARAMS[] = {
+    "limit", "cursor", "name_prefix", "best_before_from", "best_before_to", "fields"
+};
+
+// ---------------------------------------------------------------------------
+// Read the full POST body from the FastCGI request. An absent, empty or
+// unreadable CONTENT_LENGTH is an empty body; false if it is over
+// MAX_POST_BODY_BYTES, and nothing is read.
+// ---------------------------------------------------------------------------
+static bool readPostBody(FCGX_Request& request, std::string& body) {
+    body.clear();
+    const char* lenStr = FCGX_GetParam("CONTENT_LENGTH", request.envp);
+    if (!lenStr) return true;
+
+    // Out of range comes back as LLONG_MAX, so it is refused below
+    char* end = nullptr;
+    long long len = std::strtoll(lenStr, &end, 10);
+    if (end == lenStr || *end != '\0' || len <= 0) return true;
+    if (len > static_cast<long long>(MAX_POST_BODY_BYTES)) return false;
+
+    body.resize(static_cast<size_t>(len));
+    int read = FCGX_GetStr(&body[0], static_cast<int>(len), request.in);
+    body.resize(read > 0 ? static_cast<size_t>(read) : 0);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Mutations — shared by the single-operation endpoints and the batch
+// ---------------------------------------------------------------------------
+
+// Most operations accepted in one batch. The batch holds the write lock
+// throughout, and the scanner and camera wait behind it.
+static const size_t MAX_BATCH_OPERATIONS = 200;
+
+// Applies one operation described by @p json ({"id": ...} or the item's
+// fields). Returns nullptr on success, otherwise the error to report.
+static const char* applyOperation(InventoryStore& store, std::string_view op, const JsonView& json) {
+    if (op == "add" || op == "update") {
+        long long   id         = json["id"].asInt(-1);
+        std::string name       = json["name"].asString();
+        std::string barcode    = json["barcode"].asString();
+        std::string bestBefore = json["best_before"].asString();
+        long long   quantity   = json["quantity"].valid() ? json["quantity"].asInt(0) : 1;
+
+        // The store takes int; as the importer, refuse rather than wrap
+        if (quantity > INT_MAX) return "invalid quantity";
+        if (id > INT_MAX) return "invalid id";
+
+        if (op == "add") {
+            if (name.empty() || quantity <= 0) return "missing name";
+            return store.addItem(name, barcode, static_cast<int>(quantity), bestBefore)
+                       ? nullptr : "insert failed";
+        }
+
+        if (id < 0 || name.empty() || quantity <= 0) return "missing id, name, or invalid quantity";
+        return store.updateItem(static_cast<int>(id), name, barcode, static_cast<int>(quantity), bestBefore)
+                   ? nullptr : "update failed";
+    }
+
+    long long id = json["id"].asInt(-1);
+    if (id > INT_MAX) return "invalid id";
+
+    if (op == "increment") {
+        if (id < 0) return "missing id";
+        return store.incrementItem(static_cast<int>(id)) ? nullptr : "increment failed";
+    }
+    if (op == "decrement") {
+        if (id < 0) return "missing id";
+        return store.decrementItem(static_cast<int>(id)) ? nullptr : "decrement failed";
+    }
+    if (op == "delete") {
+        if (id < 0) return "missing id";
+        return store.deleteItem(static_cast<int>(id)) ? nullptr : "delete failed";
+    }
+
+    return "unknown op";
+}
+
+// Applies {"op": ..., ...} entries in order inside one transaction and
+// returns the response body. A failed operation is undone on its own and
+// reported in its slot of "results"; the rest still commit together.
+static std::string applyBatch(InventoryStore& store, const JsonView& operations, bool& changed) {
+    std::vector<JsonView> entries = operations.elements();
+    if (entries.empty()) return "{\"error\": \"missing operations\"}";
+    if (entries.size() > MAX_BATCH_OPERATIONS) {
+        return "{\"error\": \"too many operations (max " + std::to_string(MAX_BATCH_OPERATIONS) + ")\"}";
+    }
+
+    std::vector<const char*> errors(entries.size(), nullptr);
+    size_t applied = 0;
+
+    bool committed = store.inTransaction([&] {
+        for (size_t i = 0; i < entries.size(); ++i) {
+            errors[i] = applyOperation(store, entries[i]["op"].asString(), entries[i]);
+            if (!errors[i]) ++applied;
+        }
+    });
+    if (!committed) return "{\"error\": \"batch failed\"}";
+
+    changed = applied > 0;
+
+    std::string out;
+    JsonWriter json = JsonWriter::toString(out);
+    json.beginObject();
+    json.key("success"); json.value(applied == entries.size());
+    json.key("applied"); json.value(static_cast<long long>(applied));
+    json.key("results");
+    json.beginArray();
+    for (const char* error : errors) {
+        json.beginObject();
+        json.key("success"); json.value(error == nullptr);
+        if (error) { json.key("error"); json.value(error); }
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+    json.flush();
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// Value of ?key=... in the query string, percent-decoded. False if absent.
+// ---------------------------------------------------------------------------
+static bool queryParam(const char* query, std::string_view key, std::string& value) {
+    std::string_view rest = query ? query : "";
+
+    while (!rest.empty()) {
+        size_t amp = rest.find('&');
+        std::string_view pair = rest.substr(0, amp);
+        rest = amp == std::string_view::npos ? std::string_view() : rest.substr(amp + 1);
+
+        size_t eq = pair.find('=');
+        if (pair.substr(0, eq) != key) continue;
+
+        std::string_view raw = eq == std::string_view::npos ? std::string_view() : pair.substr(eq + 1);
+        auto hex = [](char c) {
+            return std::isdigit(static_cast<unsigned char>(c)) ? c - '0' : (c | 0x20) - 'a' + 10;
+        };
+
+        value.clear();
+        for (size_t i = 0; i < raw.size(); ++i) {
+            if (raw[i] == '+') {
+                value += ' ';
+            } else if (raw[i] == '%' && i + 2 < raw.size() &&
+                       std::isxdigit(static_cast<unsigned char>(raw[i + 1])) &&
+                       std::isxdigit(static_cast<unsigned char>(raw[i + 2]))) {
+                value += static_cast<char>(hex(raw[i + 1]) * 16 + hex(raw[i + 2]));
+                i += 2;
+            } else {
+                value += raw[i];
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// ?within= as a number of days: "3", "3d" or "2w". -1 if unreadable.
+// ---------------------------------------------------------------------------
+static int parseWithinDays(const std::string& text) {
+    char* end = nullptr;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if (end == text.c_str() || value < 0) return -1;
+
+    std::string unit = end;
+    if (unit == "w") value *= 7;
+    else if (!unit.empty() && unit != "d") return -1;
+    return value > MAX_EXPIRY_DAYS ? MAX_EXPIRY_DAYS : static_cast<int>(value);
+}
+
+// ---------------------------------------------------------------------------
+// ?best_before_from= / ?best_before_to= as a BestBefore day number into
+// @p days, left at -1 if absent or empty. False if given but not a date.
+// ---------------------------------------------------------------------------
+static bool dayParam(const char* query, std::string_view key, std::string& param, long long& days) {
+    if (!queryParam(query, key, param) || param.empty()) return true;
+
+    BestBefore date;
+    if (!BestBefore::parse(param, date)) return false;
+    days = date.days;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Local date as YYYY-MM-DD, @p daysAgo days before today
+// ---------------------------------------------------------------------------
+static std::string localDate(int daysAgo) {
+    time_t at = time(nullptr) - static_cast<time_t>(daysAgo) * 86400;
+    struct tm local;
+    localtime_r(&at, &local);
+    char buf[11];
+    strftime(buf, sizeof(buf), "%Y-%m-%d", &local);
+    return buf;
+}
+// ---------------------------------------------------------------------------
+// One request to an inventory route. The handler fills in the response;
+// route() writes it.
+// ---------------------------------------------------------------------------
+struct InventoryRoutes::Exchange {
+    Exchange(InventoryStore& store, FCGX_Request& request, const char* query, bool dbOpen)
+        : store(store), request(request), query(query), dbOpen(dbOpen) {}
+
+    InventoryStore& store;      // the worker's own connection
+    FCGX_Request&   request;
+    const char*     query;
+    bool            dbOpen;
+
+    std::string responseBody;
+    std::string contentType = "application/json";
+    std::string extraHeaders;
+    std::function<bool(JsonWriter&)> streamBody;   // set instead of responseBody for listings
+    bool        changed  = false;
+    bool        answered = false;                  // handler already wrote a body-less reply
+    std::string param;
+};
+
+const char* const InventoryRoutes::DB_PATH = "/var/lib/pifridge/inventory.db";
+
+InventoryRoutes::InventoryRoutes(EventNotifier& events)
+    : events_(events), cache_(DB_PATH), backup_(DB_PATH, BACKUP_DIR, BACKUP_KEEP) {
+    cache_.current();
+
+    // Daily history totals, kept close to current between history requests.
+    // Its own connection; rolling up records no events of its own.
+    rollUp_ = std::thread([this] {
+        InventoryStore store(DB_PATH, "rollup");
+        std::unique_lock<std::mutex> lock(rollUpMutex_);
+        while (!stopping_) {
+            lock.unlock();
+            if (store.open()) store.rollUpHistory();
+            lock.lock();
+            rollUpWake_.wait_for(lock, HISTORY_ROLLUP_INTERVAL, [this] { return stopping_; });
+        }
+    });
+
+    // A copy every BACKUP_INTERVAL, plus any asked for through /api/admin/backup
+    backup_.start(BACKUP_INTERVAL);
+}
+
+InventoryRoutes::~InventoryRoutes() {
+    {
+        std::lock_guard<std::mutex> lock(rollUpMutex_);
+        stopping_ = true;
+    }
+    rollUpWake_.notify_all();
+    if (rollUp_.joinable()) rollUp_.join();
+}
+
+void InventoryRoutes::addTo(Router& router, InventoryStore& store) {
+    // Imports go through a connection of their own, so imported rows show
+    // in history as "import". One per worker, like @p store; the route holds it.
+    auto importStore = std::make_shared<InventoryStore>(DB_PATH, "import");
+
+    router.add("GET",  "/api/inventory",           route(store, [this](Exchange& e) { getItems(e); }));
+    router.add("GET",  "/api/inventory/search",    route(store, [this](Exchange& e) { getSearch(e); }));
+    router.add("GET",  "/api/inventory/expiring",  route(store, [this](Exchange& e) { getExpiring(e); }));
+    router.add("GET",  "/api/inventory/history",   route(store, [this](Exchange& e) { getHistory(e); }));
+    router.add("GET",  "/api/inventory/export",    route(store, [this](Exchange& e) { getExport(e); }));
+
+    router.add("POST", "/api/inventory",           route(store, [this](Exchange& e) { postOperation(e, "add"); }));
+    router.add("POST", "/api/inventory/update",    route(store, [this](Exchange& e) { postOperation(e, "update"); }));
+    router.add("POST", "/api/inventory/increment", route(store, [this](Exchange& e) { postOperation(e, "increment"); }));
+    router.add("POST", "/api/inventory/decrement", route(store, [this](Exchange& e) { postOperation(e, "decrement"); }));
+    router.add("POST", "/api/inventory/delete",    route(store, [this](Exchange& e) { postOperation(e, "delete"); }));
+    router.add("POST", "/api/inventory/batch",     route(store, [this](Exchange& e) { postBatch(e); }));
+    router.add("POST", "/api/inventory/import",    route(*importStore, [this, importStore](Exchange& e) { postImport(e); }));
+
+    router.add("GET",  "/api/admin/backup",        route(store, [this](Exchange& e) { getBackup(e); }));
+    router.add("POST", "/api/admin/backup",        route(store, [this](Exchange& e) { postBackup(e); }));
+}
+
+// ---------------------------------------------------------------------------
+// Runs on a worker thread with that worker's own store. Reads come from the
+// cache shared by all workers; writes go to SQLite.
+// ---------------------------------------------------------------------------
+Router::Handler InventoryRoutes::route(InventoryStore& store, std::function<void(Exchange&)> handle) {
+    return [this, &store, handle](const Router::Request& routed) {
+        // Retry if the database was unavailable at startup
+        Exchange exchange(store, routed.fcgi, routed.query, store.open());
+        handle(exchange);
+        if (exchange.answered) return FcgiWorkerPool::Result::Finished;
+
+        FCGX_Request& request = routed.fcgi;
+        FCGX_FPrintF(request.out,
+            "Content-Type: %s\r\n"
+            "Access-Control-Allow-Origin: *\r\n"
+            "%s"
+            "\r\n", exchange.contentType.c_str(), exchange.extraHeaders.c_str());
+
+        if (exchange.streamBody) {
+            // Rows are escaped into a fixed buffer and passed on as they are
+            // read, so a large inventory is never held in memory as a whole
+            FCGX_Stream* out = request.out;
+            JsonWriter json([out](const char* data, size_t size) {
+                return FCGX_PutStr(data, static_cast<int>(size), out) >= 0;
+            });
+            if (!exchange.streamBody(json)) json.rawValue("{\"error\": \"Failed to query inventory\"}");
+            json.flush();
+        } else {
+            FCGX_PutStr(exchange.responseBody.data(), static_cast<int>(exchange.responseBody.size()), request.out);
+        }
+
+        // Tell open dashboards to refetch
+        if (exchange.changed) events_.publish("inventory", "{}");
+        return FcgiWorkerPool::Result::Finished;
+    };
+}
+
+// ---------------------------------------------------------------------------
+// GET /api/inventory?since=N                          — changes after version N
+// GET /api/inventory?limit=N&cursor=C&barcode=&name_prefix=
+//     &best_before_from=&best_before_to=&fields=      — one page
+// GET /api/inventory?id=N | ?barcode=X | ?name=X      — matching items
+// GET /api/inventory                                  — all items
+// ---------------------------------------------------------------------------
+void InventoryRoutes::getItems(Exchange& exchange) {
+    const char* query = exchange.query;
+    std::string& param = exchange.param;
+
+    if (queryParam(query, "since", param)) {
+        auto snapshot = cache_.current();
+        if (snapshot) {
+            char* end = nullptr;
+            long long since = std::strtoll(param.c_str(), &end, 10);
+            if (param.empty() || *end != '\0') since = -1;   // unreadable — resend everything
+
+            // Client is already current — nothing to send
+            if (since == snapshot->version) {
+                FCGX_FPrintF(exchange.request.out,
+                    "Status: 304 Not Modified\r\n"
+                    "Access-Control-Allow-Origin: *\r\n"
+                    "\r\n");
+                exchange.answered = true;
+                return;
+            }
+
+            exchange.extraHeaders = "Cache-Control: no-cache\r\n";
+            exchange.streamBody = [snapshot, since](JsonWriter& json) {
+                snapshot->writeChangesSince(since, json);
+                return true;
+            };
+        } else {
+            exchange.responseBody = "{\"error\": \"database unavailable\"}";
+        }
+    }
+
+    else if (std::any_of(std::begin(PAGE_PARAMS), std::end(PAGE_PARAMS),
+                         [query, &param](const char* key) { return queryParam(query, key, param); })) {
+        InventoryCache::PageQuery page;
+        page.limit = DEFAULT_PAGE_ITEMS;
+        queryParam(query, "barcode", page.barcode);
+        queryParam(query, "name_prefix", page.namePrefix);
+        bool datesValid = dayParam(query, "best_before_from", param, page.bestBeforeFromDays) &&
+                          dayParam(query, "best_before_to", param, page.bestBeforeToDays);
+
+        // A positive whole number; only one above the maximum is clamped
+        bool limitValid = true;
+        if (queryParam(query, "limit", param)) {
+            char* end = nullptr;
+            long long limit = std::strtoll(param.c_str(), &end, 10);
+            limitValid = !param.empty() && *end == '\0' && limit > 0;
+            if (limitValid) {
+                page.limit = limit > static_cast<long long>(MAX_PAGE_ITEMS)
+                    ? MAX_PAGE_ITEMS : static_cast<size_t>(limit);
+            }
+        }
+
+        if (!datesValid) {
+            exchange.extraHeaders = "Status: 400 Bad Request\r\n";
+            exchange.responseBody = "{\"error\": \"invalid best_before_from or best_before_to\"}";
+        } else if (!limitValid) {
+            exchange.extraHeaders = "Status: 400 Bad Request\r\n";
+            exchange.responseBody = "{\"error\": \"invalid limit\"}";
+        } else if (queryParam(query, "cursor", param) && !param.empty() &&
+                   !InventoryCache::parseCursor(param, page)) {
+            exchange.extraHeaders = "Status: 400 Bad Request\r\n";
+            exchange.responseBody = "{\"error\": \"invalid cursor\"}";
+        } else if (queryParam(query, "fields", param) && !InventoryCache::parseFields(param, page.fields)) {
+            exchange.extraHeaders = "Status: 400 Bad Request\r\n";
+            exchange.responseBody = "{\"error\": \"unknown field\"}";
+        } else if (auto snapshot = cache_.current()) {
+            exchange.extraHeaders = "Cache-Control: no-cache\r\n";
+            exchange.streamBody = [snapshot, page](JsonWriter& json) {
+                snapshot->writePage(page, json);
+                return true;
+            };
+        } else {
+            exchange.responseBody = "{\"error\": \"database unavailable\"}";
+        }
+    }
+
+    else if (queryParam(query, "id", param) || queryParam(query, "barcode", param) ||
+             queryParam(query, "name", param)) {
+        auto snapshot = cache_.current();
+        if (snapshot) {
+            std::vector<const InventoryItem*> found;
+            if (queryParam(query, "id", param)) {
+                const InventoryItem* item = snapshot->findById(std::strtoll(param.c_str(), nullptr, 10));
+                if (item) found.push_back(item);
+            } else if (queryParam(query, "barcode", param)) {
+                found = snapshot->findByBarcode(param);
+            } else {
+                found = snapshot->findByName(param);
+            }
+
+            exchange.extraHeaders = "Cache-Control: no-cache\r\n";
+            exchange.streamBody = [snapshot, found](JsonWriter& json) {
+                json.beginArray();
+                for (const InventoryItem* item : found) InventoryCache::writeItem(json, *item);
+                json.endArray();
+                return true;
+            };
+        } else {
+            exchange.responseBody = "{\"error\": \"database unavailable\"}";
+        }
+    }
+
+    else {
+        auto snapshot = cache_.current();
+        if (snapshot) {
+            // Body and ETag come from the same snapshot, so they always agree
+            std::string etag = "\"v" + std::to_string(snapshot->version) + "\"";
+            const char* ifNoneMatch = FCGX_GetParam("HTTP_IF_NONE_MATCH", exchange.request.envp);
+
+            // Nothing changed since the client's copy
+            if (ifNoneMatch && etag == ifNoneMatch) {
+                FCGX_FPrintF(exchange.request.out,
+                    "Status: 304 Not Modified\r\n"
+                    "ETag: %s\r\n"
+                    "Access-Control-Allow-Origin: *\r\n"
+                    "\r\n", etag.c_str());
+                exchange.answered = true;
+                return;
+            }
+
+            exchange.extraHeaders = "ETag: " + etag + "\r\nCache-Control: no-cache\r\n";
+            exchange.streamBody = [snapshot](JsonWriter& json) {
+                json.rawValue(snapshot->listing());
+                return true;
+            };
+        } else {
+            exchange.responseBody = "{\"error\": \"database unavailable\"}";
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// GET /api/inventory/search?q=...&limit=N — ranked type-ahead search
+// ---------------------------------------------------------------------------
+void InventoryRoutes::getSearch(Exchange& exchange) {
+    if (exchange.dbOpen) {
+        std::string text;
+        queryParam(exchange.query, "q", text);
+
+        int limit = DEFAULT_SEARCH_RESULTS;
+        if (queryParam(exchange.query, "limit", exchange.param)) {
+            limit = static_cast<int>(std::strtol(exchange.param.c_str(), nullptr, 10));
+            if (limit <= 0 || limit > MAX_SEARCH_RESULTS) limit = MAX_SEARCH_RESULTS;
+        }
+
+        InventoryStore& store = exchange.store;
+        exchange.extraHeaders = "Cache-Control: no-cache\r\n";
+        exchange.streamBody = [&store, text, limit](JsonWriter& json) {
+            return store.writeSearch(text, limit, json);
+        };
+    } else {
+        exchange.responseBody = "{\"error\": \"database unavailable\"}";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// GET /api/inventory/expiring?within=3d — what to eat first
+// ---------------------------------------------------------------------------
+void InventoryRoutes::getExpiring(Exchange& exchange) {
+    int within = DEFAULT_EXPIRY_DAYS;
+    if (queryParam(exchange.query, "within", exchange.param)) within = parseWithinDays(exchange.param);
+
+    if (within < 0) {
+        exchange.responseBody = "{\"error\": \"invalid within\"}";
+    } else if (auto snapshot = cache_.current()) {
+        long long today = BestBefore::today();
+        exchange.extraHeaders = "Cache-Control: no-cache\r\n";
+        exchange.streamBody = [snapshot, today, within](JsonWriter& json) {
+            snapshot->writeExpiring(today, within, json);
+            return true;
+        };
+    } else {
+        exchange.responseBody = "{\"error\": \"database unavailable\"}";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// GET /api/inventory/history?from=YYYY-MM-DD&to=YYYY-MM-DD&name=X
+// ---------------------------------------------------------------------------
+void InventoryRoutes::getHistory(Exchange& exchange) {
+    const char* query = exchange.query;
+    std::string& param = exchange.param;
+
+    // Any date BestBefore reads; passed on as YYYY-MM-DD
+    std::string fromText = queryParam(query, "from", param) ? param : localDate(DEFAULT_HISTORY_DAYS);
+    std::string toText   = queryParam(query, "to", param)   ? param : localDate(0);
+    BestBefore from;
+    BestBefore to;
+    bool valid = BestBefore::parse(fromText, from) && BestBefore::parse(toText, to) &&
+                 from.days <= to.days && to.days - from.days <= MAX_HISTORY_DAYS;
+    std::string name;
+    queryParam(query, "name", name);
+
+    if (!valid) {
+        exchange.responseBody = "{\"error\": \"invalid date range\"}";
+    } else if (exchange.dbOpen) {
+        // Events since the last periodic roll-up; usually none or a few
+        InventoryStore& store = exchange.store;
+        store.rollUpHistory();
+
+        exchange.extraHeaders = "Cache-Control: no-cache\r\n";
+        exchange.streamBody = [&store, from, to, name](JsonWriter& json) {
+            return store.writeHistory(from.date, to.date, name, json);
+        };
+    } else {
+        exchange.responseBody = "{\"error\": \"database unavailable\"}";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// GET /api/inventory/export?format=ndjson|csv — backup or move
+// ---------------------------------------------------------------------------
+void InventoryRoutes::getExport(Exchange& exchange) {
+    InventoryTransfer::Format format = InventoryTransfer::Format::Ndjson;
+    if (queryParam(exchange.query, "format", exchange.param) &&
+        !InventoryTransfer::parseFormat(exchange.param, format)) {
+        exchange.responseBody = "{\"error\": \"unknown format\"}";
+    } else if (exchange.dbOpen) {
+        // Straight from SQLite a row at a time, not from the cache, so
+        // the rows are one consistent read whatever else is writing
+        InventoryStore& store = exchange.store;
+        exchange.contentType  = InventoryTransfer::contentType(format);
+        exchange.extraHeaders = "Cache-Control: no-cache\r\n"
+                                "Content-Disposition: attachment; filename=\"inventory." +
+                                std::string(InventoryTransfer::extension(format)) + "\"\r\n";
+        exchange.streamBody = [&store, format](JsonWriter& out) {
+            return InventoryTransfer::writeExport(store, format, out);
+        };
+    } else {
+        exchange.responseBody = "{\"error\": \"database unavailable\"}";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// POST /api/inventory            — add a new item
+// POST /api/inventory/update     — edit an item by id
+// POST /api/inventory/increment  — increase quantity by 1
+// POST /api/inventory/decrement  — reduce quantity by 1, delete if reaches 0
+// POST /api/inventory/delete     — delete an item by id
+// ---------------------------------------------------------------------------
+void InventoryRoutes::postOperation(Exchange& exchange, const char* op) {
+    std::string body;
+    if (!readPostBody(exchange.request, body)) {
+        exchange.extraHeaders = "Status: 413 Payload Too Large\r\n";
+        exchange.responseBody = "{\"error\": \"request body too large\"}";
+    } else if (exchange.dbOpen) {
+        const char* error = applyOperation(exchange.store, op, JsonView::parse(body));
+        exchange.changed = !error;
+        exchange.responseBody = error ? "{\"error\": \"" + std::string(error) + "\"}" : "{\"success\": true}";
+    } else {
+        exchange.responseBody = "{\"error\": \"database unavailable\"}";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// POST /api/inventory/batch — many operations, one transaction
+// ---------------------------------------------------------------------------
+void InventoryRoutes::postBatch(Exchange& exchange) {
+    std::string body;
+    if (!readPostBody(exchange.request, body)) {
+        exchange.extraHeaders = "Status: 413 Payload Too Large\r\n";
+        exchange.responseBody = "{\"error\": \"request body too large\"}";
+    } else if (exchange.dbOpen) {
+        exchange.responseBody = applyBatch(exchange.store, JsonView::parse(body)["operations"], exchange.changed);
+    } else {
+        exchange.responseBody = "{\"error\": \"database unavailable\"}";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// POST /api/inventory/import?format=ndjson|csv — body read in chunks
+// ---------------------------------------------------------------------------
+void InventoryRoutes::postImport(Exchange& exchange) {
+    // Without ?format=, a text/csv body is CSV and anything else NDJSON
+    const char* bodyType = FCGX_GetParam("CONTENT_TYPE", exchange.request.envp);
+    bool csvBody = bodyType && std::string_view(bodyType).find("csv") != std::string_view::npos;
+    InventoryTransfer::Format format = csvBody ? InventoryTransfer::Format::Csv
+                                               : InventoryTransfer::Format::Ndjson;
+    if (queryParam(exchange.query, "format", exchange.param) &&
+        !InventoryTransfer::parseFormat(exchange.param, format)) {
+        exchange.responseBody = "{\"error\": \"unknown format\"}";
+    } else if (exchange.dbOpen) {
+        // exchange.store is the worker's "import" connection (see addTo)
+        InventoryImporter importer(exchange.store, format);
+        char chunk[IMPORT_CHUNK_BYTES];
+        int read;
+        while ((read = FCGX_GetStr(chunk, static_cast<int>(sizeof(chunk)), exchange.request.in)) > 0) {
+            if (!importer.feed(chunk, static_cast<size_t>(read))) break;
+        }
+        importer.finish();
+        exchange.changed = importer.imported() > 0;
+
+        JsonWriter json = JsonWriter::toString(exchange.responseBody);
+        importer.writeResult(json);
+        json.flush();
+    } else {
+        exchange.responseBody = "{\"error\": \"database unavailable\"}";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// GET /api/admin/backup — backup progress and last outcome
+// ---------------------------------------------------------------------------
+void InventoryRoutes::getBackup(Exchange& exchange) {
+    exchange.extraHeaders = "Cache-Control: no-cache\r\n";
+    exchange.streamBody = [this](JsonWriter& json) {
+        backup_.writeStatus(json);
+        return true;
+    };
+}
+
+// ---------------------------------------------------------------------------
+// POST /api/admin/backup — back up now, on the backup thread
+// ---------------------------------------------------------------------------
+void InventoryRoutes::postBackup(Exchange& exchange) {
+    // The copy takes seconds; poll GET for pages_done/pages_total
+    bool started = backup_.request();
+    JsonWriter json = JsonWriter::toString(exchange.responseBody);
+    json.beginObject();
+    json.key("started");
+    json.value(started);
+    json.key("status");
+    backup_.writeStatus(json);
+    json.endObject();
+    json.flush();
+}
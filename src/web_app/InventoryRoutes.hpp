@@ -0,0 +1,83 @@
+#pragma once
+
+#include "EventNotifier.hpp"
+#include "InventoryBackup.hpp"
+#include "InventoryCache.hpp"
+#include "InventoryStore.hpp"
+#include "Router.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Routes of pifridge_api for /api/inventory, its sub-paths and /api/admin/backup.
+ *
+ * Owns what all workers share: the in-memory copy GETs are answered from,
+ * the backup job and the history roll-up thread, both started by the
+ * constructor. Writes go through the connection of the worker that took
+ * the request, passed to addTo().
+ *
+ * Usage:
+ * @code
+ *   InventoryRoutes inventory(events);
+ *   pool.run([&inventory] {
+ *       auto store  = std::make_shared<InventoryStore>(InventoryRoutes::DB_PATH, "ui");
+ *       auto router = std::make_shared<Router>();
+ *       store->open();
+ *       inventory.addTo(*router, *store);
+ *       return [store, router](FCGX_Request& request) { return router->dispatch(request); };
+ *   });
+ * @endcode
+ */
+class InventoryRoutes {
+public:
+    /** Database shared with the barcode scanner and pifridge (camera). */
+    static const char* const DB_PATH;
+
+    /** @param events Where to announce that the inventory changed. */
+    explicit InventoryRoutes(EventNotifier& events);
+
+    /** Stops the history roll-up thread, and the backup job with it. */
+    ~InventoryRoutes();
+
+    InventoryRoutes(const InventoryRoutes&) = delete;
+    InventoryRoutes& operator=(const InventoryRoutes&) = delete;
+
+    /**
+     * @brief Register every route on @p router; writes go through @p store.
+     *
+     * Imports go through a second connection of the worker's, with source
+     * "import", created here; so call this once per worker, as above.
+     */
+    void addTo(Router& router, InventoryStore& store);
+
+private:
+    struct Exchange;
+
+    /** Run @p handle on a request and write what it set. */
+    Router::Handler route(InventoryStore& store, std::function<void(Exchange&)> handle);
+
+    void getItems(Exchange& exchange);
+    void getSearch(Exchange& exchange);
+    void getExpiring(Exchange& exchange);
+    void getHistory(Exchange& exchange);
+    void getExport(Exchange& exchange);
+    void postOperation(Exchange& exchange, const char* op);
+    void postBatch(Exchange& exchange);
+    void postImport(Exchange& exchange);
+    void getBackup(Exchange& exchange);
+    void postBackup(Exchange& exchange);
+
+    EventNotifier& events_;
+    InventoryCache cache_;
+    InventoryBackup backup_;
+
+    // History roll-up thread, woken early only to stop
+    std::mutex rollUpMutex_;
+    std::condition_variable rollUpWake_;
+    bool stopping_ = false;
+    std::thread rollUp_;
+};
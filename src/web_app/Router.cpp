@@ -0,0 +1,95 @@
+#include "Router.hpp"
+
+#include <algorithm>
+
+Router::Router() : nodes_(1) {}
+
+void Router::add(std::string_view method, std::string_view path, Handler handler) {
+    path = pathOf(path);
+
+    uint32_t node = 0;
+    for (char c : path) {
+        auto& next = nodes_[node].next;
+        auto it = std::lower_bound(next.begin(), next.end(), c,
+                                   [](const std::pair<char, uint32_t>& edge, char key) { return edge.first < key; });
+        if (it != next.end() && it->first == c) {
+            node = it->second;
+            continue;
+        }
+        uint32_t child = static_cast<uint32_t>(nodes_.size());
+        next.insert(it, { c, child });
+        nodes_.emplace_back();   // invalidates next; not used again
+        node = child;
+    }
+
+    for (auto& entry : nodes_[node].methods) {
+        if (entry.first == method) {
+            entry.second = std::move(handler);
+            return;
+        }
+    }
+    nodes_[node].methods.emplace_back(std::string(method), std::move(handler));
+}
+
+const Router::Handler* Router::find(std::string_view method, std::string_view path,
+                                    std::string* allowed) const {
+    uint32_t node = 0;
+    for (char c : path) {
+        const auto& next = nodes_[node].next;
+        auto it = std::lower_bound(next.begin(), next.end(), c,
+                                   [](const std::pair<char, uint32_t>& edge, char key) { return edge.first < key; });
+        if (it == next.end() || it->first != c) return nullptr;
+        node = it->second;
+    }
+
+    const auto& methods = nodes_[node].methods;
+    for (const auto& entry : methods) {
+        if (entry.first == method) return &entry.second;
+    }
+
+    if (allowed) {
+        allowed->clear();
+        for (const auto& entry : methods) {
+            if (!allowed->empty()) *allowed += ", ";
+            *allowed += entry.first;
+        }
+    }
+    return nullptr;
+}
+
+FcgiWorkerPool::Result Router::dispatch(FCGX_Request& request) const {
+    const char* method = FCGX_GetParam("REQUEST_METHOD", request.envp);
+    const char* uri    = FCGX_GetParam("REQUEST_URI",    request.envp);
+    const char* query  = FCGX_GetParam("QUERY_STRING",   request.envp);
+
+    Request routed{ request, method ? method : "", pathOf(uri ? uri : ""), query ? query : "" };
+
+    std::string allowed;
+    if (const Handler* handler = find(routed.method, routed.path, &allowed)) {
+        return (*handler)(routed);
+    }
+
+    if (allowed.empty()) {
+        FCGX_FPrintF(request.out,
+            "Status: 404 Not Found\r\n"
+            "Content-Type: application/json\r\n"
+            "Access-Control-Allow-Origin: *\r\n"
+            "\r\n"
+            "{\"error\": \"not found\"}");
+    } else {
+        FCGX_FPrintF(request.out,
+            "Status: 405 Method Not Allowed\r\n"
+            "Allow: %s\r\n"
+            "Content-Type: application/json\r\n"
+            "Access-Control-Allow-Origin: *\r\n"
+            "\r\n"
+            "{\"error\": \"method not supported\"}", allowed.c_str());
+    }
+    return FcgiWorkerPool::Result::Finished;
+}
+
+std::string_view Router::pathOf(std::string_view uri) {
+    std::string_view path = uri.substr(0, uri.find('?'));
+    if (path.size() > 1 && path.back() == '/') path.remove_suffix(1);
+    return path;
+}
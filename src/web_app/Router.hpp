@@ -0,0 +1,82 @@
+#pragma once
+
+#include "FcgiWorkerPool.hpp"
+
+#include <fcgiapp.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Route table for the FastCGI server: method + exact path -> handler.
+ *
+ * Paths are stored in a byte trie, so finding a route reads the request
+ * path once, whatever the number of routes, and only the exact path
+ * matches: "/api/inventory/update" is a route, "/api/inventory/updates"
+ * and "/x/update" are not. The query string is not part of the path, and
+ * one trailing slash is ignored.
+ *
+ * dispatch() answers requests without a route itself: 404 if no route has
+ * the path, 405 with an Allow header if the path is known but not the
+ * method.
+ *
+ * Not locked: each worker builds its own Router in its HandlerFactory, so
+ * handlers can be bound to that worker's state, such as its database
+ * connection.
+ *
+ * Usage:
+ * @code
+ *   pool.run([] {
+ *       auto router = std::make_shared<Router>();
+ *       router->add("GET", "/api/fridge", [](const Router::Request& request) {
+ *           writeVitals(request.fcgi);
+ *           return FcgiWorkerPool::Result::Finished;
+ *       });
+ *       return [router](FCGX_Request& request) { return router->dispatch(request); };
+ *   });
+ * @endcode
+ */
+class Router {
+public:
+    /** The parts of a request a handler routes on, parsed once. */
+    struct Request {
+        FCGX_Request& fcgi;
+        std::string_view method;
+        std::string_view path;    ///< REQUEST_URI without the query string
+        const char* query;        ///< QUERY_STRING; empty, never null
+    };
+
+    using Handler = std::function<FcgiWorkerPool::Result(const Request&)>;
+
+    Router();
+
+    /** Route @p method requests for exactly @p path to @p handler, replacing any before. */
+    void add(std::string_view method, std::string_view path, Handler handler);
+
+    /**
+     * @brief The handler for @p method and @p path, or nullptr.
+     *
+     * @param allowed If not null and the path has routes but not for
+     *                @p method, set to their methods, e.g. "GET, POST".
+     */
+    const Handler* find(std::string_view method, std::string_view path,
+                        std::string* allowed = nullptr) const;
+
+    /** Route one accepted request, answering 404/405 if nothing takes it. */
+    FcgiWorkerPool::Result dispatch(FCGX_Request& request) const;
+
+    /** @p uri without its query string and one trailing slash. */
+    static std::string_view pathOf(std::string_view uri);
+
+private:
+    struct Node {
+        std::vector<std::pair<char, uint32_t>> next;        // sorted by byte
+        std::vector<std::pair<std::string, Handler>> methods;
+    };
+
+    std::vector<Node> nodes_;   // nodes_[0] is the empty path
+};
@@ -0,0 +1,167 @@
+#include "SseHub.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <utility>
+
+SseHub::SseHub(std::string socketPath)
+    : socketPath_(std::move(socketPath)) {}
+
+SseHub::~SseHub() {
+    stop();
+}
+
+bool SseHub::start() {
+    fd_ = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        std::cerr << "[events] socket failed: " << strerror(errno) << "\n";
+        return false;
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socketPath_.c_str(), sizeof(addr.sun_path) - 1);
+
+    // Remove a stale socket left by a previous run
+    ::unlink(socketPath_.c_str());
+    if (::bind(fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "[events] bind " << socketPath_ << " failed: " << strerror(errno) << "\n";
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    // eventfd wakes the blocked fan-out thread during shutdown
+    stopFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    running_ = true;
+    thread_ = std::thread(&SseHub::run, this);
+    return true;
+}
+
+void SseHub::stop() {
+    if (running_.exchange(false)) {
+        uint64_t one = 1;
+        ::write(stopFd_, &one, sizeof(one));
+    }
+    if (thread_.joinable()) thread_.join();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (FCGX_Request* request : subscribers_) release(request);
+        subscribers_.clear();
+    }
+
+    if (fd_ >= 0)     { ::close(fd_);     fd_ = -1;     ::unlink(socketPath_.c_str()); }
+    if (stopFd_ >= 0) { ::close(stopFd_); stopFd_ = -1; }
+}
+
+void SseHub::subscribe(FCGX_Request* request) {
+    // Bound how long a stalled client can hold up the fan-out thread
+    timeval timeout{1, 0};
+    ::setsockopt(request->ipcFd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::string hello =
+        "Content-Type: text/event-stream\r\n"
+        "Cache-Control: no-cache\r\n"
+        "X-Accel-Buffering: no\r\n"
+        "\r\n"
+        "retry: 3000\n\n";
+    for (const auto& entry : latest_) hello += entry.second;
+
+    // Under the lock, so no broadcast reaches the stream before its hello.
+    // A new socket's buffer is empty, so this write doesn't wait.
+    if (!writeFrame(request, hello)) {
+        release(request);
+        return;
+    }
+    subscribers_.push_back(request);
+}
+
+void SseHub::run() {
+    char buffer[4096];
+    pollfd fds[2] = {
+        { fd_,     POLLIN, 0 },
+        { stopFd_, POLLIN, 0 },
+    };
+
+    while (running_) {
+        int ready = ::poll(fds, 2, KEEPALIVE_SECONDS * 1000);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[events] poll failed: " << strerror(errno) << "\n";
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) break;
+
+        if (ready == 0) {
+            // Idle — a comment frame keeps proxies from timing out and
+            // surfaces connections whose client has gone
+            broadcast("", ": keep-alive\n\n");
+            continue;
+        }
+
+        ssize_t n = ::recv(fd_, buffer, sizeof(buffer), 0);
+        if (n <= 0) continue;
+
+        // Wire format from EventNotifier: "<event>\n<json>"
+        std::string message(buffer, static_cast<size_t>(n));
+        size_t split = message.find('\n');
+        if (split == std::string::npos) continue;
+
+        std::string event = message.substr(0, split);
+        std::string frame = "event: " + event + "\ndata: " + message.substr(split + 1) + "\n\n";
+
+        broadcast(event, frame);
+    }
+}
+
+void SseHub::broadcast(const std::string& event, const std::string& frame) {
+    // Recorded and copied in one step, so a stream subscribing meanwhile
+    // gets the frame once: in its hello or here
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!event.empty()) latest_[event] = frame;
+        sending_ = subscribers_;
+    }
+
+    // Written unlocked: a stalled client holds up this thread for its
+    // SO_SNDTIMEO, but never subscribe() or a worker
+    failed_.clear();
+    for (FCGX_Request* request : sending_) {
+        if (!writeFrame(request, frame)) failed_.push_back(request);
+    }
+    if (failed_.empty()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscribers_.erase(std::remove_if(subscribers_.begin(), subscribers_.end(),
+                                          [this](FCGX_Request* request) {
+                                              return std::find(failed_.begin(), failed_.end(), request) !=
+                                                     failed_.end();
+                                          }),
+                           subscribers_.end());
+    }
+    for (FCGX_Request* request : failed_) release(request);
+}
+
+bool SseHub::writeFrame(FCGX_Request* request, const std::string& frame) {
+    if (FCGX_PutStr(frame.data(), static_cast<int>(frame.size()), request->out) < 0) return false;
+    return FCGX_FFlush(request->out) == 0;
+}
+
+void SseHub::release(FCGX_Request* request) {
+    FCGX_Finish_r(request);
+    delete request;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <fcgiapp.h>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Server-Sent Events fan-out for GET /api/events.
+ *
+ * Writers (main.cpp, the barcode scanner, the inventory routes) send events
+ * as Unix datagrams through EventNotifier. The hub receives them on one
+ * thread and writes each to every open event stream.
+ *
+ * An open stream is just a parked FCGX_Request — it does not hold a worker
+ * thread — so hundreds of idle browser tabs cost one socket and two small
+ * buffers each. A comment line is sent every KEEPALIVE_SECONDS so dead
+ * connections are noticed and dropped.
+ *
+ * Usage:
+ * @code
+ *   SseHub hub(EventNotifier::DEFAULT_SOCKET_PATH);
+ *   hub.start();
+ *   // in a worker, for GET /api/events:
+ *   hub.subscribe(request);   // hub now owns the request
+ * @endcode
+ */
+class SseHub {
+public:
+    static constexpr int KEEPALIVE_SECONDS = 15;
+
+    /**
+     * @param socketPath Datagram socket to receive events on
+     */
+    explicit SseHub(std::string socketPath);
+    ~SseHub();
+
+    SseHub(const SseHub&) = delete;
+    SseHub& operator=(const SseHub&) = delete;
+
+    /** Bind the datagram socket and start the fan-out thread. */
+    bool start();
+
+    /** Stop the fan-out thread and close every open stream. */
+    void stop();
+
+    /**
+     * @brief Take ownership of an accepted request and turn it into a stream.
+     *
+     * Writes the event-stream headers and the latest event of each type so
+     * the client starts with current state. The hub finishes and deletes the
+     * request when the client goes away.
+     *
+     * @param request Heap-allocated request, no longer used by the caller
+     */
+    void subscribe(FCGX_Request* request);
+
+private:
+    void run();
+
+    /**
+     * @brief Send a formatted frame to every subscriber, dropping failed ones.
+     *
+     * The subscriber list is copied under the mutex and written outside it.
+     *
+     * @param event Event name to keep the frame as the latest of; empty for none
+     */
+    void broadcast(const std::string& event, const std::string& frame);
+
+    static bool writeFrame(FCGX_Request* request, const std::string& frame);
+    static void release(FCGX_Request* request);
+
+    std::string socketPath_;
+    int fd_ = -1;
+    int stopFd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    std::mutex mutex_;                           // guards the two members below
+    std::vector<FCGX_Request*> subscribers_;
+    std::map<std::string, std::string> latest_;  // event name -> last frame
+
+    // Fan-out thread only, kept to reuse their capacity
+    std::vector<FCGX_Request*> sending_;
+    std::vector<FCGX_Request*> failed_;
+};
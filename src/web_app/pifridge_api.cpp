@@ -1,24 +1,73 @@
 // pifridge_api.cpp
-// FastCGI endpoint for PiFridge.
-// Reads /tmp/fridge_data.json and serves it to nginx on each GET /api/fridge.
+// FastCGI server for PiFridge — every /api/ route, on one socket.
+// Serves the vitals pifridge publishes to shared memory on GET /api/fridge.
+// Streams vitals and inventory change events on GET /api/events (SSE).
+// Serves /api/inventory/* and /api/admin/backup (see InventoryRoutes.cpp).
 //
 // Build via CMake (see src/web_app/CMakeLists.txt)
 // Run:
-//   sudo ./build/src/web_app/pifridge_api
+//   ./build/src/web_app/pifridge_api [--workers N]
+
+#include "EventNotifier.hpp"
+#include "FcgiWorkerPool.hpp"
+#include "InventoryRoutes.hpp"
+#include "Router.hpp"
+#include "SseHub.hpp"
+#include "VitalsChannel.hpp"
 
 #include <fcgiapp.h>
-#include <fstream>
+#include <csignal>
 #include <iostream>
-#include <sstream>
+#include <memory>
 #include <string>
 
-// Path must match the path written by saveStateToJson() in main.cpp
-static const char* JSON_PATH   = "/tmp/fridge_data.json";
-
 // Must match fastcgi_pass in config/pifridge.conf
 static const char* SOCKET_PATH = "/var/run/pifridge/pifridge.sock";
 
-int main() {
+// Worker threads, overridable with --workers N. Event streams don't hold
+// one, so this only bounds concurrent API requests and database writes.
+static const int DEFAULT_WORKERS = 4;
+
+// ---------------------------------------------------------------------------
+// Request handler — one call per GET /api/fridge from the browser.
+// Copies the latest vitals out of the shared memory pifridge publishes to:
+// no file, no lock and no syscall, and never a half-written record.
+// ---------------------------------------------------------------------------
+static void handleVitals(FCGX_Request& request, VitalsChannel& channel) {
+    Vitals vitals;
+    std::string body = channel.read(vitals)
+        ? vitalsToJson(vitals)
+        : "{\"error\": \"data not available yet\"}";   // pifridge may still be starting up
+
+    // Write HTTP headers then body
+    FCGX_FPrintF(request.out,
+        "Content-Type: application/json\r\n"
+        "Access-Control-Allow-Origin: *\r\n"
+        "\r\n"
+        "%s", body.c_str());
+}
+
+// ---------------------------------------------------------------------------
+// Route table of one worker. Built once per worker, so inventory handlers
+// are bound to that worker's own database connection.
+// ---------------------------------------------------------------------------
+static void addFridgeRoutes(Router& router, SseHub& hub, VitalsChannel& vitals) {
+    router.add("GET", "/api/fridge", [&vitals](const Router::Request& request) {
+        handleVitals(request.fcgi, vitals);
+        return FcgiWorkerPool::Result::Finished;
+    });
+
+    // GET /api/events — park the request in the hub as an event stream
+    router.add("GET", "/api/events", [&hub](const Router::Request& request) {
+        hub.subscribe(&request.fcgi);
+        return FcgiWorkerPool::Result::Detached;
+    });
+}
+
+int main(int argc, char** argv) {
+    // A browser closing its event stream must not kill the process
+    std::signal(SIGPIPE, SIG_IGN);
+
     // Initialise the FastCGI library
     if (FCGX_Init() != 0) {
         std::cerr << "[pifridge_api] FCGX_Init failed\n";
@@ -26,49 +75,41 @@ int main() {
     }
 
     // Open a Unix socket — nginx connects to this
-    int socketFd = FCGX_OpenSocket(SOCKET_PATH, /*backlog=*/5);
+    int socketFd = FCGX_OpenSocket(SOCKET_PATH, /*backlog=*/64);
     if (socketFd < 0) {
         std::cerr << "[pifridge_api] Failed to open socket: " << SOCKET_PATH << "\n";
         return 1;
     }
 
-    FCGX_Request request;
-    if (FCGX_InitRequest(&request, socketFd, 0) != 0) {
-        std::cerr << "[pifridge_api] FCGX_InitRequest failed\n";
-        return 1;
-    }
+    FcgiWorkerPool pool(socketFd, FcgiWorkerPool::workersFromArgs(argc, argv, DEFAULT_WORKERS),
+                        "[pifridge_api]");
+
+    std::cout << "[pifridge_api] Listening on " << SOCKET_PATH
+              << " with " << pool.workers() << " workers\n";
 
-    std::cout << "[pifridge_api] Listening on " << SOCKET_PATH << "\n";
-
-    // ---------------------------------------------------------------------------
-    // Request loop — one iteration per GET /api/fridge from the browser.
-    // Follows the REST statelessness principle: each request reads the file
-    // fresh and does not alter any state.
-    // ---------------------------------------------------------------------------
-    while (FCGX_Accept_r(&request) == 0) {
-
-        // Read the JSON file written by saveStateToJson() in main.cpp
-        std::ifstream jsonFile(JSON_PATH);
-        std::string   body;
-
-        if (jsonFile.is_open()) {
-            std::ostringstream ss;
-            ss << jsonFile.rdbuf();
-            body = ss.str();
-        } else {
-            // File not yet written — pifridge may still be starting up
-            body = "{\"error\": \"data not available yet\"}";
-        }
-
-        // Write HTTP headers then body
-        FCGX_FPrintF(request.out,
-            "Content-Type: application/json\r\n"
-            "Access-Control-Allow-Origin: *\r\n"
-            "\r\n"
-            "%s", body.c_str());
-
-        FCGX_Finish_r(&request);
+    SseHub hub(EventNotifier::DEFAULT_SOCKET_PATH);
+    if (!hub.start()) {
+        std::cerr << "[pifridge_api] Event stream disabled\n";
     }
 
+    // GETs are answered from one in-memory copy shared by all workers;
+    // each worker writes through its own connection, with statements
+    // prepared once per worker, not on every request
+    EventNotifier events;
+    InventoryRoutes inventory(events);
+
+    // Shared by all workers; mapped on the first read, so pifridge may
+    // start after us
+    VitalsChannel vitals;
+
+    pool.run([&hub, &inventory, &vitals] {
+        auto store  = std::make_shared<InventoryStore>(InventoryRoutes::DB_PATH, "ui");
+        auto router = std::make_shared<Router>();
+        store->open();
+        addFridgeRoutes(*router, hub, vitals);
+        inventory.addTo(*router, *store);
+        return [store, router](FCGX_Request& request) { return router->dispatch(request); };
+    });
+
     return 0;
-}
\ No newline at end of file
+}
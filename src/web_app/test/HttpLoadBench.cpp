@@ -0,0 +1,175 @@
+// HttpLoadBench.cpp
+// Keep-alive HTTP load generator for comparing the embedded server
+// (pifridge --http-port) with nginx -> FastCGI -> pifridge_api.
+//
+// Each connection is a thread that sends one GET, reads the whole response
+// and sends the next, so the numbers are closed-loop: requests/s and the
+// latency of each request as the client saw it. With --close every request
+// opens a new connection, as a client without keep-alive would.
+//
+// With no port, an HttpServer is started in-process, serving a body the
+// size of /api/fridge, so the server can be measured on its own.
+//
+// Run:
+//   ./build/src/web_app/http_load_bench [port] [path] [connections] [seconds] [--close]
+//   ./build/src/web_app/http_load_bench 8080 /api/fridge 8 5     # embedded server
+//   ./build/src/web_app/http_load_bench 80   /api/fridge 8 5     # nginx
+
+#include "HttpServer.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct ConnectionResult {
+    long requests = 0;
+    long errors = 0;
+    std::vector<double> latencyUs;
+};
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Read one response into @p in (bytes after it are kept for the next call).
+// Returns false if the connection closed or the response is unreadable.
+static bool readResponse(int fd, std::string& in) {
+    char buffer[16384];
+    for (;;) {
+        size_t headEnd = in.find("\r\n\r\n");
+        if (headEnd != std::string::npos) {
+            size_t at = in.find("Content-Length: ");
+            if (at == std::string::npos || at > headEnd) return false;
+            size_t end = headEnd + 4 + std::stoul(in.substr(at + 16, 20));
+            if (in.size() >= end) {
+                bool ok = in.compare(0, 12, "HTTP/1.1 200") == 0;
+                in.erase(0, end);
+                return ok;
+            }
+        }
+        ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) return false;
+        in.append(buffer, static_cast<size_t>(n));
+    }
+}
+
+static void connection(uint16_t port, const std::string& request, bool reconnect,
+                       const std::atomic<bool>& stop, ConnectionResult& result) {
+    int fd = -1;
+    std::string in;
+
+    while (!stop.load(std::memory_order_relaxed)) {
+        auto start = Clock::now();
+        if (fd < 0) {
+            fd = connectTo(port);
+            in.clear();
+            if (fd < 0) {
+                ++result.errors;
+                continue;
+            }
+        }
+
+        bool ok = ::send(fd, request.data(), request.size(), MSG_NOSIGNAL) ==
+                      static_cast<ssize_t>(request.size()) &&
+                  readResponse(fd, in);
+        if (!ok || reconnect) {
+            ::close(fd);
+            fd = -1;
+        }
+        if (!ok) {
+            ++result.errors;
+            continue;
+        }
+
+        result.latencyUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        ++result.requests;
+    }
+    if (fd >= 0) ::close(fd);
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> args;
+    bool reconnect = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--close") == 0) reconnect = true;
+        else args.emplace_back(argv[i]);
+    }
+
+    uint16_t port      = args.size() > 0 ? static_cast<uint16_t>(std::stoi(args[0])) : 0;
+    std::string path   = args.size() > 1 ? args[1] : "/api/fridge";
+    int connections    = args.size() > 2 ? std::stoi(args[2]) : 4;
+    double seconds     = args.size() > 3 ? std::stod(args[3]) : 2.0;
+
+    // Stand-in for the daemon: the same size of body as /api/fridge
+    HttpServer server(0);
+    if (port == 0) {
+        server.route(path, [](const HttpServer::Request&, HttpServer::Response& response) {
+            response.body = "{\"temperature\": 4.21, \"humidity\": 61.37, \"pressure\": 1012.44, "
+                            "\"lux\": 0.00, \"door_open\": false}";
+        });
+        if (!server.start()) return 1;
+        port = server.port();
+    }
+
+    std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n" +
+                          (reconnect ? "Connection: close\r\n" : "") + "\r\n";
+
+    std::cout << "[bench] GET " << path << " on port " << port << ", " << connections
+              << (reconnect ? " connections (new one per request), " : " keep-alive connections, ")
+              << seconds << " s\n";
+
+    std::atomic<bool> stop{false};
+    std::vector<ConnectionResult> results(static_cast<size_t>(connections));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < connections; ++i) {
+        threads.emplace_back(connection, port, std::cref(request), reconnect, std::cref(stop),
+                             std::ref(results[static_cast<size_t>(i)]));
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& t : threads) t.join();
+
+    long total = 0;
+    long errors = 0;
+    std::vector<double> latencies;
+    for (const auto& r : results) {
+        total += r.requests;
+        errors += r.errors;
+        latencies.insert(latencies.end(), r.latencyUs.begin(), r.latencyUs.end());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](size_t p) {
+        return latencies.empty() ? 0.0 : latencies[latencies.size() * p / 100];
+    };
+
+    std::cout << "[bench] " << static_cast<long>(static_cast<double>(total) / seconds) << " req/s"
+              << "  p50=" << percentile(50) << " us"
+              << "  p99=" << percentile(99) << " us"
+              << "  errors=" << errors << "\n";
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,227 @@
+// HttpServerTest.cpp
+// Checks HttpServer over real sockets: keep-alive and pipelined requests,
+// a request split across writes, HEAD, 304, 404 and 405, HTTP/1.0 and
+// "Connection: close", and an oversized request.
+
+#include "../HttpServer.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+
+static void expectTrue(bool condition, const std::string& message, int& failures) {
+    if (!condition) {
+        std::cout << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+static void expectEqual(const std::string& actual, const std::string& expected,
+                        const std::string& message, int& failures) {
+    if (actual != expected) {
+        std::cout << "FAIL: " << message
+                  << " expected \"" << expected
+                  << "\" got \"" << actual << "\"\n";
+        ++failures;
+    }
+}
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    timeval timeout{2, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return;
+        sent += static_cast<size_t>(n);
+    }
+}
+
+// Read until @p count responses have arrived (judged by Content-Length),
+// the connection closes or the read times out
+static std::string readResponses(int fd, int count) {
+    std::string in;
+    int complete = 0;
+    size_t start = 0;
+    char buffer[4096];
+
+    while (complete < count) {
+        size_t headEnd = in.find("\r\n\r\n", start);
+        if (headEnd != std::string::npos) {
+            std::string head = in.substr(start, headEnd - start);
+            size_t at = head.find("Content-Length: ");
+            size_t length = at == std::string::npos ? 0 : std::stoul(head.substr(at + 16));
+            bool noBody = head.find(" 304 ") != std::string::npos || head.find("X-Head: 1") != std::string::npos;
+            size_t end = headEnd + 4 + (noBody ? 0 : length);
+            if (in.size() >= end) {
+                ++complete;
+                start = end;
+                continue;
+            }
+        }
+        ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) break;
+        in.append(buffer, static_cast<size_t>(n));
+    }
+    return in;
+}
+
+// True once the server has closed @p fd
+static bool closedByServer(int fd) {
+    char byte;
+    return ::recv(fd, &byte, 1, 0) == 0;
+}
+
+static int countOf(const std::string& text, const std::string& part) {
+    int n = 0;
+    for (size_t at = text.find(part); at != std::string::npos; at = text.find(part, at + 1)) ++n;
+    return n;
+}
+
+int main() {
+    int failures = 0;
+
+    HttpServer server(0);
+    server.route("/hello", [](const HttpServer::Request& request, HttpServer::Response& response) {
+        response.body = "{\"query\": \"" + std::string(request.query) + "\"}";
+        if (request.method == "HEAD") response.headers = "X-Head: 1\r\n";
+    });
+    server.route("/cached", [](const HttpServer::Request& request, HttpServer::Response& response) {
+        response.headers = "ETag: \"v7\"\r\n";
+        if (request.ifNoneMatch == "\"v7\"") response.status = 304;
+        response.body = "[1,2,3]";
+    });
+    expectTrue(server.start(), "server should start", failures);
+    expectTrue(server.port() != 0, "server should report the port it took", failures);
+
+    // Keep-alive: two requests, one after the other, on one connection
+    int fd = connectTo(server.port());
+    sendAll(fd, "GET /hello?a=1 HTTP/1.1\r\nHost: x\r\n\r\n");
+    std::string first = readResponses(fd, 1);
+    sendAll(fd, "GET /hello?a=2 HTTP/1.1\r\nHost: x\r\n\r\n");
+    std::string second = readResponses(fd, 1);
+    expectTrue(first.compare(0, 15, "HTTP/1.1 200 OK") == 0, "first response should be 200: " + first, failures);
+    expectTrue(first.find("{\"query\": \"a=1\"}") != std::string::npos, "first body", failures);
+    expectTrue(second.find("{\"query\": \"a=2\"}") != std::string::npos,
+               "second request should be answered on the same connection", failures);
+    expectTrue(first.find("Connection: close") == std::string::npos, "HTTP/1.1 should stay open", failures);
+
+    // Pipelined: three requests in one write, answered in order
+    sendAll(fd, "GET /hello?n=1 HTTP/1.1\r\n\r\nGET /missing HTTP/1.1\r\n\r\nGET /hello?n=3 HTTP/1.1\r\n\r\n");
+    std::string pipelined = readResponses(fd, 3);
+    size_t one   = pipelined.find("n=1");
+    size_t four  = pipelined.find("404 Not Found");
+    size_t three = pipelined.find("n=3");
+    expectTrue(one != std::string::npos && four != std::string::npos && three != std::string::npos &&
+               one < four && four < three, "pipelined responses should come in order: " + pipelined, failures);
+
+    // One request split into single bytes
+    std::string split = "GET /hello?s=1 HTTP/1.1\r\nHost: x\r\n\r\n";
+    for (char c : split) {
+        sendAll(fd, std::string(1, c));
+        usleep(200);
+    }
+    expectTrue(readResponses(fd, 1).find("s=1") != std::string::npos, "split request should be answered", failures);
+
+    // HEAD has the headers, Content-Length included, but no body
+    sendAll(fd, "HEAD /hello HTTP/1.1\r\n\r\nGET /hello?after=head HTTP/1.1\r\n\r\n");
+    std::string head = readResponses(fd, 2);
+    expectTrue(head.find("Content-Length: 13\r\n") != std::string::npos, "HEAD keeps Content-Length: " + head, failures);
+    expectEqual(std::to_string(countOf(head, "{\"query\"")), "1", "HEAD should have no body", failures);
+
+    // 304 for a matching ETag
+    sendAll(fd, "GET /cached HTTP/1.1\r\nIf-None-Match: \"v7\"\r\n\r\nGET /cached HTTP/1.1\r\n\r\n");
+    std::string cached = readResponses(fd, 2);
+    expectTrue(cached.find("304 Not Modified") != std::string::npos &&
+               countOf(cached, "[1,2,3]") == 1, "ETag match should get a body-less 304: " + cached, failures);
+    ::close(fd);
+
+    // POST is refused, and the connection closed, without reading the body
+    fd = connectTo(server.port());
+    sendAll(fd, "POST /hello HTTP/1.1\r\nContent-Length: 2\r\n\r\n{}");
+    std::string post = readResponses(fd, 1);
+    expectTrue(post.find("405 Method Not Allowed") != std::string::npos &&
+               post.find("Allow: GET, HEAD") != std::string::npos, "POST should get 405: " + post, failures);
+    expectTrue(closedByServer(fd), "405 should close the connection", failures);
+    ::close(fd);
+
+    // HTTP/1.0 and Connection: close are answered, then closed
+    fd = connectTo(server.port());
+    sendAll(fd, "GET /hello HTTP/1.0\r\n\r\n");
+    expectTrue(readResponses(fd, 1).find("Connection: close") != std::string::npos, "HTTP/1.0 closes", failures);
+    expectTrue(closedByServer(fd), "HTTP/1.0 connection should be closed", failures);
+    ::close(fd);
+
+    fd = connectTo(server.port());
+    sendAll(fd, "GET /hello HTTP/1.1\r\nConnection: close\r\n\r\n");
+    expectTrue(readResponses(fd, 1).find("200 OK") != std::string::npos, "Connection: close answered", failures);
+    expectTrue(closedByServer(fd), "Connection: close should close", failures);
+    ::close(fd);
+
+    // A request line the server can't read
+    fd = connectTo(server.port());
+    sendAll(fd, "HELLO\r\n\r\n");
+    expectTrue(readResponses(fd, 1).find("400 Bad Request") != std::string::npos, "garbage should get 400", failures);
+    ::close(fd);
+
+    // A head that never ends
+    fd = connectTo(server.port());
+    sendAll(fd, "GET /hello HTTP/1.1\r\nX-Filler: " + std::string(HttpServer::MAX_REQUEST_BYTES, 'x'));
+    expectTrue(readResponses(fd, 1).find("431 ") != std::string::npos, "oversized head should get 431", failures);
+    expectTrue(closedByServer(fd), "oversized head should close", failures);
+    ::close(fd);
+
+    // A pipelined burst several heads long is read a head's worth at a time
+    // and every request still answered
+    fd = connectTo(server.port());
+    std::string burst;
+    for (int i = 0; i < 1000; ++i) burst += "GET /hello?b=" + std::to_string(i) + " HTTP/1.1\r\n\r\n";
+    expectTrue(burst.size() > 2 * HttpServer::MAX_REQUEST_BYTES, "burst should be several heads long", failures);
+    sendAll(fd, burst);
+    std::string answered = readResponses(fd, 1000);
+    expectEqual(std::to_string(countOf(answered, "200 OK")), "1000", "every request in the burst answered", failures);
+    expectTrue(answered.find("b=999\"") != std::string::npos, "burst answered to the end", failures);
+    ::close(fd);
+
+    // A client that sends a request and shuts down its side still gets the answer
+    fd = connectTo(server.port());
+    sendAll(fd, "GET /hello?half=1 HTTP/1.1\r\n\r\n");
+    ::shutdown(fd, SHUT_WR);
+    expectTrue(readResponses(fd, 1).find("half=1") != std::string::npos, "half-closed client answered", failures);
+    ::close(fd);
+
+    server.stop();
+    expectTrue(connectTo(server.port()) < 0, "stopped server should not accept", failures);
+
+    std::string command = "--http-port";
+    std::string value = "8080";
+    char* args[] = { nullptr, &command[0], &value[0] };
+    expectEqual(std::to_string(HttpServer::portFromArgs(3, args)), "8080", "--http-port", failures);
+    expectEqual(std::to_string(HttpServer::portFromArgs(1, args)), "0", "no --http-port", failures);
+
+    if (failures == 0) {
+        std::cout << "PASS\n";
+        return 0;
+    }
+    std::cout << "FAILURES: " << failures << "\n";
+    return 1;
+}
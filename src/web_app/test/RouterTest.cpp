@@ -0,0 +1,123 @@
+// RouterTest.cpp
+// Checks that Router matches only the exact method and path of a route,
+// reports the methods a known path does take, and hands handlers the path
+// and query string of a dispatched request.
+
+#include "../Router.hpp"
+
+#include <iostream>
+#include <string>
+
+static void expectTrue(bool condition, const std::string& message, int& failures) {
+    if (!condition) {
+        std::cout << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+static void expectEqual(const std::string& actual, const std::string& expected,
+                        const std::string& message, int& failures) {
+    if (actual != expected) {
+        std::cout << "FAIL: " << message
+                  << " expected \"" << expected
+                  << "\" got \"" << actual << "\"\n";
+        ++failures;
+    }
+}
+
+// The route a handler belongs to, set when it runs
+static std::string called;
+
+static Router::Handler handlerFor(const std::string& name) {
+    return [name](const Router::Request&) {
+        called = name;
+        return FcgiWorkerPool::Result::Finished;
+    };
+}
+
+// Name of the route @p method @p path finds, or "" if none
+static std::string route(const Router& router, const char* method, const char* path) {
+    FCGX_Request fcgi{};
+    const Router::Handler* handler = router.find(method, path);
+    if (!handler) return "";
+    called.clear();
+    (*handler)(Router::Request{ fcgi, method, path, "" });
+    return called;
+}
+
+int main() {
+    int failures = 0;
+
+    Router router;
+    router.add("GET",  "/api/fridge",              handlerFor("vitals"));
+    router.add("GET",  "/api/inventory",           handlerFor("list"));
+    router.add("POST", "/api/inventory",           handlerFor("add"));
+    router.add("POST", "/api/inventory/update",    handlerFor("update"));
+    router.add("POST", "/api/inventory/increment", handlerFor("increment"));
+    router.add("GET",  "/api/inventory/search",    handlerFor("search"));
+    router.add("GET",  "/api/admin/backup",        handlerFor("backup status"));
+    router.add("POST", "/api/admin/backup/",       handlerFor("start backup"));
+
+    expectEqual(route(router, "GET", "/api/fridge"), "vitals", "GET /api/fridge", failures);
+    expectEqual(route(router, "GET", "/api/inventory"), "list", "GET /api/inventory", failures);
+    expectEqual(route(router, "POST", "/api/inventory"), "add", "POST /api/inventory", failures);
+    expectEqual(route(router, "POST", "/api/inventory/update"), "update", "POST /update", failures);
+    expectEqual(route(router, "POST", "/api/inventory/increment"), "increment", "POST /increment", failures);
+    expectEqual(route(router, "GET", "/api/inventory/search"), "search", "GET /search", failures);
+    expectEqual(route(router, "POST", "/api/admin/backup"), "start backup",
+                "a route added with a trailing slash should match without one", failures);
+
+    // Paths that only contain, start or end like a route
+    for (const char* path : { "/api/inventory/updates", "/api/inventory/update/1", "/x/api/inventory/update",
+                              "/api/inventory/upd", "/api/inventor", "/api", "", "/",
+                              "/API/INVENTORY", "/api/inventory/search/../update" }) {
+        expectEqual(route(router, "POST", path) + route(router, "GET", path), "",
+                    std::string("no route should match ") + path, failures);
+    }
+
+    // Known path, other method
+    std::string allowed;
+    expectTrue(!router.find("DELETE", "/api/inventory", &allowed), "DELETE should not match", failures);
+    expectEqual(allowed, "GET, POST", "allowed methods of /api/inventory", failures);
+    expectTrue(!router.find("GET", "/api/inventory/update", &allowed), "GET /update should not match", failures);
+    expectEqual(allowed, "POST", "allowed methods of /api/inventory/update", failures);
+    expectTrue(!router.find("GET", "/api/inventory/upd", &allowed), "partial path should not match", failures);
+    expectEqual(allowed, "", "a partial path should have no methods", failures);
+
+    // Adding a route again replaces its handler
+    router.add("GET", "/api/fridge", handlerFor("vitals v2"));
+    expectEqual(route(router, "GET", "/api/fridge"), "vitals v2", "re-added route", failures);
+
+    expectEqual(std::string(Router::pathOf("/api/inventory?since=3")), "/api/inventory", "query stripped", failures);
+    expectEqual(std::string(Router::pathOf("/api/inventory/?since=3")), "/api/inventory",
+                "query and trailing slash stripped", failures);
+    expectEqual(std::string(Router::pathOf("/")), "/", "root kept", failures);
+    expectEqual(std::string(Router::pathOf("/search?next=/a/b")), "/search", "slash in query", failures);
+
+    // dispatch() reads the request's FastCGI parameters
+    char methodParam[] = "REQUEST_METHOD=GET";
+    char uriParam[] = "REQUEST_URI=/api/inventory/search/?q=mi&limit=5";
+    char queryParam[] = "QUERY_STRING=q=mi&limit=5";
+    char* envp[] = { methodParam, uriParam, queryParam, nullptr };
+
+    std::string seenPath;
+    std::string seenQuery;
+    router.add("GET", "/api/inventory/search", [&](const Router::Request& request) {
+        seenPath  = std::string(request.path);
+        seenQuery = request.query;
+        return FcgiWorkerPool::Result::Detached;
+    });
+    FCGX_Request fcgi{};
+    fcgi.envp = envp;
+    expectTrue(router.dispatch(fcgi) == FcgiWorkerPool::Result::Detached,
+               "dispatch should return the handler's result", failures);
+    expectEqual(seenPath, "/api/inventory/search", "dispatched path", failures);
+    expectEqual(seenQuery, "q=mi&limit=5", "dispatched query", failures);
+
+    if (failures == 0) {
+        std::cout << "PASS\n";
+        return 0;
+    }
+    std::cout << "FAILURES: " << failures << "\n";
+    return 1;
+}
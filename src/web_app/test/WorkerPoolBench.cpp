@@ -0,0 +1,96 @@
+// WorkerPoolBench.cpp
+// Throughput benchmark for the pifridge_api worker model.
+//
+// Runs 1, 2 and 4 workers, each with its own InventoryStore connection as in
+// FcgiWorkerPool, against one WAL database. Every tenth request is a write so
+// the numbers show whether GETs keep flowing while a writer commits.
+//
+// Run:
+//   ./build/src/web_app/worker_pool_bench [seconds-per-run]
+
+#include "InventoryStore.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char* BENCH_DB_PATH = "/tmp/pifridge_worker_bench.db";
+static const int   SEED_ITEMS    = 50;
+
+using Clock = std::chrono::steady_clock;
+
+struct WorkerResult {
+    long requests = 0;
+    std::vector<double> getLatencyUs;
+};
+
+static void worker(int workerId, const std::atomic<bool>& stop, WorkerResult& result) {
+    InventoryStore store(BENCH_DB_PATH);
+    if (!store.open()) return;
+
+    long n = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        if (n % 10 == 9) {
+            store.incrementItem(1 + static_cast<int>((n + workerId) % SEED_ITEMS));
+        } else {
+            auto start = Clock::now();
+            store.getAllItems();
+            result.getLatencyUs.push_back(
+                std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+        ++n;
+    }
+    result.requests = n;
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? std::stod(argv[1]) : 2.0;
+
+    std::remove(BENCH_DB_PATH);
+    {
+        InventoryStore seed(BENCH_DB_PATH);
+        if (!seed.open()) return 1;
+        for (int i = 0; i < SEED_ITEMS; ++i) {
+            seed.addItem("Item " + std::to_string(i), std::to_string(5000000 + i), 1, "");
+        }
+    }
+
+    std::cout << "[bench] " << SEED_ITEMS << " items, 10% writes, "
+              << seconds << " s per run\n";
+
+    for (int workers : {1, 2, 4}) {
+        std::atomic<bool> stop{false};
+        std::vector<WorkerResult> results(static_cast<size_t>(workers));
+        std::vector<std::thread> threads;
+
+        for (int i = 0; i < workers; ++i) {
+            threads.emplace_back(worker, i, std::cref(stop), std::ref(results[static_cast<size_t>(i)]));
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        stop = true;
+        for (auto& t : threads) t.join();
+
+        long total = 0;
+        std::vector<double> latencies;
+        for (const auto& r : results) {
+            total += r.requests;
+            latencies.insert(latencies.end(), r.getLatencyUs.begin(), r.getLatencyUs.end());
+        }
+        std::sort(latencies.begin(), latencies.end());
+        double p99 = latencies.empty() ? 0.0 : latencies[latencies.size() * 99 / 100];
+
+        std::cout << "[bench] workers=" << workers
+                  << "  " << static_cast<long>(static_cast<double>(total) / seconds) << " req/s"
+                  << "  GET p99=" << p99 << " us\n";
+    }
+
+    std::remove(BENCH_DB_PATH);
+    std::remove((std::string(BENCH_DB_PATH) + "-wal").c_str());
+    std::remove((std::string(BENCH_DB_PATH) + "-shm").c_str());
+    return 0;
+}